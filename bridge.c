@@ -1,5 +1,7 @@
 #include "bridge.h"
 #include "platform.h"
+#include "streaming.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,11 +9,91 @@
 
 #define MAX_BRIDGE_FUNCTIONS 256
 
-// Bridge state
+#define BRIDGE_CALL_ARENA_SIZE 4096   // Tokens and strings of a typical message fit on the stack
+#define BRIDGE_FUNCTION_TABLE_SIZE 512   // Name index slots; a power of two, at least twice MAX_BRIDGE_FUNCTIONS
+#define BRIDGE_SCRIPT_ARENA_SIZE 2048  // Response and event scripts of typical size are built on the stack
+#define BRIDGE_WORKER_COUNT 4            // Threads running async handlers, started on the first async call
+
+// Bridge state. A function's method ID is its position in g_functions, so
+// dispatch by ID is an array index; g_function_index finds it by name.
 static bridge_function_t g_functions[MAX_BRIDGE_FUNCTIONS];
 static size_t g_function_count = 0;
+static uint16_t g_function_index[BRIDGE_FUNCTION_TABLE_SIZE];   // Method ID + 1, 0 = empty
 static app_window_t* g_bridge_window = NULL;
 
+// The message being dispatched on this thread; handlers are handed g_call_args,
+// and parameter lookups on that exact string reuse the message's tokens
+static __thread const char* g_call_args = NULL;
+static __thread const bridge_json_t* g_call_json = NULL;
+static __thread int g_call_params = -1;
+
+// An async call waiting for a worker; args is its own copy of the params
+typedef struct bridge_job {
+    bridge_handler_t handler;
+    app_window_t* window;
+    char callback_id[32];
+    struct bridge_job* next;
+    char args[];
+} bridge_job_t;
+
+// Script produced on a worker, waiting for the main thread
+typedef struct bridge_script {
+    app_window_t* window;
+    size_t length;
+    struct bridge_script* next;
+    char text[];
+} bridge_script_t;
+
+// Worker pool: jobs oldest first
+static pthread_mutex_t g_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_job_cond = PTHREAD_COND_INITIALIZER;
+static bridge_job_t* g_job_head = NULL;
+static bridge_job_t* g_job_tail = NULL;
+static pthread_t g_workers[BRIDGE_WORKER_COUNT];
+static int g_worker_count = 0;
+static bool g_workers_stop = false;
+
+// Scripts from workers. One flush is posted to the main thread for the first
+// script of a batch; everything queued before it runs goes in the same hop.
+static pthread_mutex_t g_script_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bridge_script_t* g_script_head = NULL;
+static bridge_script_t* g_script_tail = NULL;
+static bool g_script_flush_posted = false;
+
+static __thread bool t_bridge_worker = false;
+
+// Responses of the batched message being dispatched; workers never have one
+typedef struct {
+    bridge_writer_t script;           // In the message's arena
+    int count;
+} bridge_batch_t;
+
+static __thread bridge_batch_t* g_batch = NULL;
+
+static void bridge_get_methods(const char* json_args, const char* callback_id, app_window_t* window);
+static void bridge_stop_workers(void);
+
+// FNV-1a
+static uint32_t bridge_hash_name(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Method ID of a registered function, or -1
+static int bridge_find_function(const char* name) {
+    uint32_t slot = bridge_hash_name(name) & (BRIDGE_FUNCTION_TABLE_SIZE - 1);
+    while (g_function_index[slot] != 0) {
+        int id = g_function_index[slot] - 1;
+        if (strcmp(g_functions[id].name, name) == 0) return id;
+        slot = (slot + 1) & (BRIDGE_FUNCTION_TABLE_SIZE - 1);
+    }
+    return -1;
+}
+
 // Initialize the bridge system
 bool bridge_init(app_window_t* window) {
     if (!window) {
@@ -22,6 +104,14 @@ bool bridge_init(app_window_t* window) {
     printf("Initializing bridge system...\n");
     g_bridge_window = window;
     g_function_count = 0;
+    memset(g_function_index, 0, sizeof(g_function_index));
+    
+    pthread_mutex_lock(&g_job_mutex);
+    g_workers_stop = false;
+    pthread_mutex_unlock(&g_job_mutex);
+    
+    // The method table comes first so its ID never changes
+    bridge_register("bridge.getMethods", bridge_get_methods, "Get the method ID of every bridge function");
     
     // Register built-in and custom functions
     bridge_register_builtin_functions();
@@ -34,12 +124,17 @@ bool bridge_init(app_window_t* window) {
 // Cleanup the bridge system
 void bridge_cleanup(void) {
     printf("Cleaning up bridge system...\n");
+    
+    // Handlers already running finish first; calls still queued are dropped
+    bridge_stop_workers();
+    
     g_function_count = 0;
+    memset(g_function_index, 0, sizeof(g_function_index));
     g_bridge_window = NULL;
 }
 
 // Register a bridge function
-void bridge_register(const char* name, bridge_handler_t handler, const char* description) {
+static void bridge_register_function(const char* name, bridge_handler_t handler, const char* description, bool async) {
     if (!name || !handler || !description) {
         printf("Bridge register failed: Invalid parameters\n");
         return;
@@ -50,232 +145,588 @@ void bridge_register(const char* name, bridge_handler_t handler, const char* des
         return;
     }
     
-    printf("Registering bridge function: %s - %s\n", name, description);
+    // The first registration of a name wins, as it always has
+    if (bridge_find_function(name) >= 0) {
+        printf("Bridge register failed: %s is already registered\n", name);
+        return;
+    }
+    
+    printf("Registering bridge function: %s - %s%s\n", name, description, async ? " (async)" : "");
     
     strncpy(g_functions[g_function_count].name, name, sizeof(g_functions[g_function_count].name) - 1);
     g_functions[g_function_count].name[sizeof(g_functions[g_function_count].name) - 1] = '\0';
     
     g_functions[g_function_count].handler = handler;
+    g_functions[g_function_count].async = async;
     
     strncpy(g_functions[g_function_count].description, description, sizeof(g_functions[g_function_count].description) - 1);
     g_functions[g_function_count].description[sizeof(g_functions[g_function_count].description) - 1] = '\0';
     
+    // Index under the stored (possibly truncated) name so lookups agree with it
+    uint32_t slot = bridge_hash_name(g_functions[g_function_count].name) & (BRIDGE_FUNCTION_TABLE_SIZE - 1);
+    while (g_function_index[slot] != 0) {
+        slot = (slot + 1) & (BRIDGE_FUNCTION_TABLE_SIZE - 1);
+    }
+    g_function_index[slot] = (uint16_t)(g_function_count + 1);
+    
     g_function_count++;
 }
 
-// Handle incoming bridge message
+void bridge_register(const char* name, bridge_handler_t handler, const char* description) {
+    bridge_register_function(name, handler, description, false);
+}
+
+void bridge_register_async(const char* name, bridge_handler_t handler, const char* description) {
+    bridge_register_function(name, handler, description, true);
+}
+
+// Run an async call on a worker: its args are tokenized again there, and
+// parameter lookups reuse those tokens the way they do on the main thread
+static void bridge_run_job(bridge_job_t* job) {
+    char arena_buffer[BRIDGE_CALL_ARENA_SIZE];
+    bridge_arena_t arena;
+    bridge_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    
+    bridge_json_t json;
+    bool parsed = bridge_json_parse(&json, job->args, strlen(job->args), &arena);
+    g_call_args = job->args;
+    g_call_json = parsed ? &json : NULL;
+    g_call_params = parsed && bridge_json_type(&json, 0) == BRIDGE_JSON_OBJECT ? 0 : -1;
+    
+    job->handler(job->args, job->callback_id, job->window);
+    
+    g_call_args = NULL;
+    g_call_json = NULL;
+    g_call_params = -1;
+    bridge_arena_release(&arena);
+}
+
+static void* bridge_worker_thread(void* arg) {
+    (void)arg;
+    t_bridge_worker = true;
+    
+    for (;;) {
+        pthread_mutex_lock(&g_job_mutex);
+        while (!g_job_head && !g_workers_stop) {
+            pthread_cond_wait(&g_job_cond, &g_job_mutex);
+        }
+        if (g_workers_stop) {
+            pthread_mutex_unlock(&g_job_mutex);
+            break;
+        }
+        bridge_job_t* job = g_job_head;
+        g_job_head = job->next;
+        if (!g_job_head) g_job_tail = NULL;
+        pthread_mutex_unlock(&g_job_mutex);
+        
+        bridge_run_job(job);
+        free(job);
+    }
+    return NULL;
+}
+
+// Queue a call for the worker pool, starting the pool if need be. False if it
+// could not be queued; the caller then runs the handler itself.
+static bool bridge_submit_job(bridge_handler_t handler, const char* args, const char* callback_id, app_window_t* window) {
+    size_t length = strlen(args);
+    bridge_job_t* job = malloc(sizeof(bridge_job_t) + length + 1);
+    if (!job) return false;
+    job->handler = handler;
+    job->window = window;
+    strncpy(job->callback_id, callback_id, sizeof(job->callback_id) - 1);
+    job->callback_id[sizeof(job->callback_id) - 1] = '\0';
+    job->next = NULL;
+    memcpy(job->args, args, length + 1);
+    
+    pthread_mutex_lock(&g_job_mutex);
+    if (g_workers_stop) {
+        pthread_mutex_unlock(&g_job_mutex);
+        free(job);
+        return false;
+    }
+    while (g_worker_count < BRIDGE_WORKER_COUNT) {
+        if (pthread_create(&g_workers[g_worker_count], NULL, bridge_worker_thread, NULL) != 0) {
+            printf("Bridge: failed to start worker thread %d\n", g_worker_count);
+            break;
+        }
+        g_worker_count++;
+    }
+    if (g_worker_count == 0) {
+        pthread_mutex_unlock(&g_job_mutex);
+        free(job);
+        return false;
+    }
+    if (g_job_tail) {
+        g_job_tail->next = job;
+    } else {
+        g_job_head = job;
+    }
+    g_job_tail = job;
+    pthread_cond_signal(&g_job_cond);
+    pthread_mutex_unlock(&g_job_mutex);
+    return true;
+}
+
+// Main thread: evaluate every script the workers queued, one evaluation per
+// run of scripts for the same window
+static void bridge_flush_scripts(void* arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&g_script_mutex);
+    bridge_script_t* script = g_script_head;
+    g_script_head = g_script_tail = NULL;
+    g_script_flush_posted = false;
+    pthread_mutex_unlock(&g_script_mutex);
+    
+    while (script) {
+        app_window_t* window = script->window;
+        size_t total = 0;
+        for (bridge_script_t* s = script; s && s->window == window; s = s->next) {
+            total += s->length + 1;
+        }
+        
+        // Out of memory for the batch: evaluate them one at a time instead
+        char* batch = malloc(total + 1);
+        size_t used = 0;
+        while (script && script->window == window) {
+            bridge_script_t* next = script->next;
+            if (batch) {
+                memcpy(batch + used, script->text, script->length);
+                used += script->length;
+                batch[used++] = '\n';
+            } else {
+                platform_webview_evaluate_javascript(window, script->text);
+            }
+            free(script);
+            script = next;
+        }
+        if (batch) {
+            batch[used] = '\0';
+            platform_webview_evaluate_javascript(window, batch);
+            free(batch);
+        }
+    }
+}
+
+// Worker thread: hold a script for the main thread
+static void bridge_queue_script(app_window_t* window, const char* text) {
+    size_t length = strlen(text);
+    bridge_script_t* script = malloc(sizeof(bridge_script_t) + length + 1);
+    if (!script) {
+        printf("Bridge: out of memory queuing a response for the main thread\n");
+        return;
+    }
+    script->window = window;
+    script->length = length;
+    script->next = NULL;
+    memcpy(script->text, text, length + 1);
+    
+    pthread_mutex_lock(&g_script_mutex);
+    if (g_script_tail) {
+        g_script_tail->next = script;
+    } else {
+        g_script_head = script;
+    }
+    g_script_tail = script;
+    bool post = !g_script_flush_posted;
+    g_script_flush_posted = true;
+    pthread_mutex_unlock(&g_script_mutex);
+    
+    // Left queued on failure; the next script tries again
+    if (post && !platform_post_to_main_thread(bridge_flush_scripts, NULL)) {
+        printf("Bridge: failed to post responses to the main thread\n");
+        pthread_mutex_lock(&g_script_mutex);
+        g_script_flush_posted = false;
+        pthread_mutex_unlock(&g_script_mutex);
+    }
+}
+
+// Everything for the webview goes through here; workers may not touch it
+static void bridge_evaluate(app_window_t* window, const char* script) {
+    if (t_bridge_worker) {
+        bridge_queue_script(window, script);
+    } else {
+        platform_webview_evaluate_javascript(window, script);
+    }
+}
+
+static void bridge_stop_workers(void) {
+    pthread_mutex_lock(&g_job_mutex);
+    g_workers_stop = true;
+    pthread_cond_broadcast(&g_job_cond);
+    int count = g_worker_count;
+    pthread_mutex_unlock(&g_job_mutex);
+    
+    for (int i = 0; i < count; i++) {
+        pthread_join(g_workers[i], NULL);
+    }
+    
+    pthread_mutex_lock(&g_job_mutex);
+    g_worker_count = 0;
+    bridge_job_t* job = g_job_head;
+    g_job_head = g_job_tail = NULL;
+    pthread_mutex_unlock(&g_job_mutex);
+    
+    int dropped = 0;
+    while (job) {
+        bridge_job_t* next = job->next;
+        free(job);
+        job = next;
+        dropped++;
+    }
+    if (dropped > 0) {
+        printf("Bridge: dropped %d queued async calls\n", dropped);
+    }
+    
+    // A flush already posted finds nothing left to do
+    pthread_mutex_lock(&g_script_mutex);
+    bridge_script_t* script = g_script_head;
+    g_script_head = g_script_tail = NULL;
+    pthread_mutex_unlock(&g_script_mutex);
+    while (script) {
+        bridge_script_t* next = script->next;
+        free(script);
+        script = next;
+    }
+}
+
+// Dispatch one call object of a parsed message
+static void bridge_dispatch_call(const bridge_json_t* message, int call, bridge_arena_t* arena, app_window_t* window) {
+    char callback_id[32];
+    long long id_value;
+    long long method_id = -1;
+    bool have_method = false;
+    bool have_id = false;
+    if (bridge_json_type(message, call) == BRIDGE_JSON_OBJECT) {
+        // "method" is the ID from bridge.getMethods, or the function name
+        int method = bridge_json_get(message, call, "method");
+        if (bridge_json_int(message, method, &method_id)) {
+            have_method = true;
+        } else {
+            const char* method_name = bridge_json_string(message, method, arena);
+            have_method = method_name != NULL;
+            method_id = method_name ? bridge_find_function(method_name) : -1;
+        }
+        have_id = bridge_json_int(message, bridge_json_get(message, call, "id"), &id_value);
+    }
+    if (have_id) {
+        snprintf(callback_id, sizeof(callback_id), "%lld", id_value);
+    }
+    
+    if (!have_method || !have_id) {
+        bridge_send_error(have_id ? callback_id : "unknown", "Invalid message format", window);
+        return;
+    }
+    
+    // Handlers take params as a string of their own
+    int params = bridge_json_get(message, call, "params");
+    bridge_json_type_t params_type = bridge_json_type(message, params);
+    const char* args = "{}";
+    int args_object = -1;
+    if (params_type == BRIDGE_JSON_OBJECT || params_type == BRIDGE_JSON_ARRAY) {
+        size_t length;
+        const char* raw = bridge_json_raw(message, params, &length);
+        char* copy = bridge_arena_alloc(arena, length + 1);
+        if (copy) {
+            memcpy(copy, raw, length);
+            copy[length] = '\0';
+            args = copy;
+            args_object = params_type == BRIDGE_JSON_OBJECT ? params : -1;
+        }
+    }
+    
+    // Find and call the function; handlers may dispatch nested calls, so the
+    // current call is saved around it
+    const char* outer_args = g_call_args;
+    const bridge_json_t* outer_json = g_call_json;
+    int outer_params = g_call_params;
+    g_call_args = args;
+    g_call_json = message;
+    g_call_params = args_object;
+    
+    bool found = method_id >= 0 && (size_t)method_id < g_function_count;
+    if (found) {
+        const bridge_function_t* function = &g_functions[method_id];
+        if (!function->async || !bridge_submit_job(function->handler, args, callback_id, window)) {
+            function->handler(args, callback_id, window);
+        }
+    }
+    
+    g_call_args = outer_args;
+    g_call_json = outer_json;
+    g_call_params = outer_params;
+    
+    if (!found) {
+        bridge_send_error(callback_id, "Function not found", window);
+    }
+}
+
+// Callback IDs of calls from the page are integers; anything else (native_call)
+// goes back as a string
+static bool bridge_is_call_id(const char* callback_id) {
+    const char* digits = callback_id[0] == '-' ? callback_id + 1 : callback_id;
+    size_t digit_count = strspn(digits, "0123456789");
+    return digit_count > 0 && digits[digit_count] == '\0';
+}
+
+static void bridge_write_callback_id(bridge_writer_t* script, const char* callback_id) {
+    if (bridge_is_call_id(callback_id)) {
+        bridge_writer_json(script, callback_id);
+    } else {
+        bridge_writer_string(script, callback_id);
+    }
+}
+
+// Handle incoming bridge message: one call object, or an array of them from a
+// batch, answered together with a single window.handleBridgeResponses script
 void bridge_handle_message(const char* json_message, app_window_t* window) {
     if (!json_message || !window) return;
     
     printf("Bridge received message: %s\n", json_message);
     
-    // Extract method name and id from JSON (matching frontend format)
-    char* method_name = bridge_get_string_param(json_message, "method");
-    char* callback_id = bridge_get_id_param(json_message, "id");
+    // Tokenize once; method, id, params and every handler lookup read the same tokens
+    char arena_buffer[BRIDGE_CALL_ARENA_SIZE];
+    bridge_arena_t arena;
+    bridge_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
     
-    if (!method_name || !callback_id) {
-        bridge_send_error(callback_id ? callback_id : "unknown", "Invalid message format", window);
-        free(method_name);
-        free(callback_id);
+    bridge_json_t message;
+    if (!bridge_json_parse(&message, json_message, strlen(json_message), &arena)) {
+        bridge_send_error("unknown", "Invalid message format", window);
+        bridge_arena_release(&arena);
         return;
     }
     
-    // Extract params using JSON value extraction
-    char* params = bridge_get_json_value(json_message, "params");
+    if (bridge_json_type(&message, 0) != BRIDGE_JSON_ARRAY) {
+        bridge_dispatch_call(&message, 0, &arena, window);
+        bridge_arena_release(&arena);
+        return;
+    }
     
-    // Find and call the function
-    bool found = false;
-    for (size_t i = 0; i < g_function_count; i++) {
-        if (strcmp(g_functions[i].name, method_name) == 0) {
-            g_functions[i].handler(params ? params : "{}", callback_id, window);
-            found = true;
-            break;
+    // Sync handlers' responses collect in the batch; async ones answer later on their own
+    bridge_batch_t batch;
+    bridge_writer_init(&batch.script, &arena);
+    batch.count = 0;
+    bridge_writer_raw(&batch.script, "window.handleBridgeResponses(");
+    bridge_writer_begin_array(&batch.script);
+    bridge_batch_t* outer_batch = g_batch;
+    g_batch = &batch;
+    
+    int call = 1;
+    for (uint32_t i = 0; i < message.tokens[0].count; i++) {
+        bridge_dispatch_call(&message, call, &arena, window);
+        call = (int)message.tokens[call].next;
+    }
+    
+    g_batch = outer_batch;
+    if (batch.count > 0) {
+        bridge_writer_end_array(&batch.script);
+        bridge_writer_raw(&batch.script, ");");
+        const char* script = bridge_writer_text(&batch.script);
+        if (script) {
+            platform_webview_evaluate_javascript(window, script);
+        } else {
+            printf("Bridge: out of memory answering a batch of %d calls\n", batch.count);
         }
     }
     
-    if (!found) {
-        bridge_send_error(callback_id, "Function not found", window);
+    bridge_arena_release(&arena);
+}
+
+// handleBridgeResponse(id, success, value): value is the result's JSON text, or
+// the error message as a string. Batched calls are answered with their batch.
+static void bridge_send_callback(const char* callback_id, bool success, const char* value, app_window_t* window) {
+    if (g_batch && bridge_is_call_id(callback_id)) {
+        bridge_writer_t* script = &g_batch->script;
+        bridge_writer_begin_array(script);
+        bridge_writer_json(script, callback_id);
+        bridge_writer_bool(script, success);
+        if (success) {
+            bridge_writer_json(script, value);
+        } else {
+            bridge_writer_string(script, value);
+        }
+        bridge_writer_end_array(script);
+        g_batch->count++;
+        return;
+    }
+    
+    char arena_buffer[BRIDGE_SCRIPT_ARENA_SIZE];
+    bridge_arena_t arena;
+    bridge_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    bridge_writer_t script;
+    bridge_writer_init(&script, &arena);
+    
+    bridge_writer_raw(&script, "window.handleBridgeResponse(");
+    bridge_write_callback_id(&script, callback_id);
+    bridge_writer_bool(&script, success);
+    if (success) {
+        bridge_writer_json(&script, value);
+    } else {
+        bridge_writer_string(&script, value);
     }
+    bridge_writer_raw(&script, ");");
     
-    free(method_name);
-    free(callback_id);
-    free(params);
+    const char* text = bridge_writer_text(&script);
+    if (text) {
+        bridge_evaluate(window, text);
+    } else {
+        printf("Bridge: out of memory sending the response to %s\n", callback_id);
+    }
+    bridge_arena_release(&arena);
 }
 
 // Send success response
 void bridge_send_response(const char* callback_id, const char* result, app_window_t* window) {
     if (!callback_id || !window) return;
     
-    char response[1024];
-    snprintf(response, sizeof(response), 
-        "window.handleBridgeResponse(%s, true, %s);", 
-        callback_id, result ? result : "null");
-    
-    platform_webview_evaluate_javascript(window, response);
+    bridge_send_callback(callback_id, true, result ? result : "null", window);
 }
 
 // Send error response
 void bridge_send_error(const char* callback_id, const char* error, app_window_t* window) {
     if (!callback_id || !window) return;
     
-    char response[1024];
-    snprintf(response, sizeof(response), 
-        "window.handleBridgeResponse(%s, false, '%s');", 
-        callback_id, error ? error : "Unknown error");
+    bridge_send_callback(callback_id, false, error ? error : "Unknown error", window);
+}
+
+bridge_writer_t* bridge_result_begin(bridge_result_t* result) {
+    bridge_arena_init(&result->arena, result->buffer, sizeof(result->buffer));
+    bridge_writer_init(&result->writer, &result->arena);
+    return &result->writer;
+}
+
+void bridge_result_send(bridge_result_t* result, const char* callback_id, app_window_t* window) {
+    const char* text = bridge_writer_text(&result->writer);
+    if (text && text[0] != '\0') {
+        bridge_send_response(callback_id, text, window);
+    } else {
+        bridge_send_error(callback_id, text ? "Empty result" : "Out of memory", window);
+    }
+    bridge_arena_release(&result->arena);
+}
+
+// Tokens for a handler's json_args: the current message's when json_args is what
+// it was handed, otherwise json_args parsed into arena
+bool bridge_get_args(const char* json_args, bridge_json_t* json, int* object, bridge_arena_t* arena) {
+    if (!json_args) return false;
+    
+    if (json_args == g_call_args && g_call_params >= 0) {
+        *json = *g_call_json;
+        *object = g_call_params;
+        return true;
+    }
     
-    platform_webview_evaluate_javascript(window, response);
+    *object = 0;
+    return bridge_json_parse(json, json_args, strlen(json_args), arena);
 }
 
-// Simple JSON string extraction
+// One key of a handler's arguments; the lookup holds any tokens it had to build
+typedef struct {
+    char buffer[1024];
+    bridge_arena_t arena;
+    bridge_json_t json;
+    int index;
+} bridge_param_t;
+
+static bool bridge_find_param(const char* json_args, const char* key, bridge_param_t* param) {
+    int object;
+    bridge_arena_init(&param->arena, param->buffer, sizeof(param->buffer));
+    param->index = -1;
+    if (!key || !bridge_get_args(json_args, &param->json, &object, &param->arena)) return false;
+    param->index = bridge_json_get(&param->json, object, key);
+    return param->index >= 0;
+}
+
+// JSON string parameter, unescaped (caller frees)
 char* bridge_get_string_param(const char* json_args, const char* key) {
-    if (!json_args || !key) return NULL;
-    
-    char search_pattern[128];
-    snprintf(search_pattern, sizeof(search_pattern), "\"%s\":", key);
-    
-    char* start = strstr(json_args, search_pattern);
-    if (!start) return NULL;
-    
-    start += strlen(search_pattern);
-    while (*start == ' ' || *start == '\t') start++; // Skip whitespace
-    
-    if (*start != '"') return NULL;
-    start++; // Skip opening quote
-    
-    char* end = strchr(start, '"');
-    if (!end) return NULL;
-    
-    size_t len = end - start;
-    char* result = malloc(len + 1);
-    if (!result) return NULL;
-    
-    strncpy(result, start, len);
-    result[len] = '\0';
-    
+    bridge_param_t param;
+    char* result = NULL;
+    if (bridge_find_param(json_args, key, &param)) {
+        result = bridge_json_string(&param.json, param.index, NULL);
+    }
+    bridge_arena_release(&param.arena);
     return result;
 }
 
-// Simple JSON integer extraction
+// JSON integer parameter (0 if absent or not a number)
 int bridge_get_int_param(const char* json_args, const char* key) {
-    if (!json_args || !key) return 0;
-    
-    char search_pattern[128];
-    snprintf(search_pattern, sizeof(search_pattern), "\"%s\":", key);
-    
-    char* start = strstr(json_args, search_pattern);
-    if (!start) return 0;
-    
-    start += strlen(search_pattern);
-    while (*start == ' ' || *start == '\t') start++; // Skip whitespace
-    
-    return atoi(start);
+    bridge_param_t param;
+    long long value = 0;
+    if (bridge_find_param(json_args, key, &param)) {
+        bridge_json_int(&param.json, param.index, &value);
+    }
+    bridge_arena_release(&param.arena);
+    return (int)value;
 }
 
 // Extract numeric ID and convert to string
 char* bridge_get_id_param(const char* json_args, const char* key) {
-    if (!json_args || !key) return NULL;
-    
-    char search_pattern[128];
-    snprintf(search_pattern, sizeof(search_pattern), "\"%s\":", key);
-    
-    char* start = strstr(json_args, search_pattern);
-    if (!start) return NULL;
-    
-    start += strlen(search_pattern);
-    while (*start == ' ' || *start == '\t') start++; // Skip whitespace
-    
-    int id_value = atoi(start);
-    
-    char* result = malloc(32); // Enough for a large integer
-    if (!result) return NULL;
-    
-    snprintf(result, 32, "%d", id_value);
+    bridge_param_t param;
+    long long value;
+    char* result = NULL;
+    if (bridge_find_param(json_args, key, &param) && bridge_json_int(&param.json, param.index, &value)) {
+        result = malloc(32); // Enough for a large integer
+        if (result) snprintf(result, 32, "%lld", value);
+    }
+    bridge_arena_release(&param.arena);
     return result;
 }
 
-// Simple JSON boolean extraction
+// JSON boolean parameter (false if absent or not a boolean)
 bool bridge_get_bool_param(const char* json_args, const char* key) {
-    if (!json_args || !key) return false;
-    
-    char search_pattern[128];
-    snprintf(search_pattern, sizeof(search_pattern), "\"%s\":", key);
-    
-    char* start = strstr(json_args, search_pattern);
-    if (!start) return false;
-    
-    start += strlen(search_pattern);
-    while (*start == ' ' || *start == '\t') start++; // Skip whitespace
-    
-    return (strncmp(start, "true", 4) == 0);
+    bridge_param_t param;
+    bool value = false;
+    if (bridge_find_param(json_args, key, &param)) {
+        bridge_json_bool(&param.json, param.index, &value);
+    }
+    bridge_arena_release(&param.arena);
+    return value;
 }
 
-// Extract JSON value (string, object, array, or null)
+// Extract JSON value: strings unescaped, anything else as its JSON text, null as NULL (caller frees)
 char* bridge_get_json_value(const char* json_args, const char* key) {
-    if (!json_args || !key) return NULL;
-    
-    char search_pattern[128];
-    snprintf(search_pattern, sizeof(search_pattern), "\"%s\":", key);
-    
-    char* start = strstr(json_args, search_pattern);
-    if (!start) return NULL;
-    
-    start += strlen(search_pattern);
-    while (*start == ' ' || *start == '\t') start++; // Skip whitespace
-    
-    char* end;
-    
-    // Handle different JSON value types
-    if (*start == '"') {
-        // String value
-        start++; // Skip opening quote
-        end = strchr(start, '"');
-        if (!end) return NULL;
-    } else if (*start == '{') {
-        // Object value - find matching closing brace
-        int brace_count = 1;
-        end = start + 1;
-        while (*end && brace_count > 0) {
-            if (*end == '{') brace_count++;
-            else if (*end == '}') brace_count--;
-            end++;
+    bridge_param_t param;
+    char* result = NULL;
+    if (bridge_find_param(json_args, key, &param)) {
+        bridge_json_type_t type = bridge_json_type(&param.json, param.index);
+        if (type == BRIDGE_JSON_STRING) {
+            result = bridge_json_string(&param.json, param.index, NULL);
+        } else if (type != BRIDGE_JSON_NULL) {
+            size_t length;
+            const char* raw = bridge_json_raw(&param.json, param.index, &length);
+            result = malloc(length + 1);
+            if (result) {
+                memcpy(result, raw, length);
+                result[length] = '\0';
+            }
         }
-        if (brace_count != 0) return NULL;
-        end--; // Point to closing brace
-        
-        // Return the full object including braces
-        size_t len = end - start + 1;
-        char* result = malloc(len + 1);
-        if (!result) return NULL;
-        strncpy(result, start, len);
-        result[len] = '\0';
-        return result;
-    } else if (strncmp(start, "null", 4) == 0) {
-        // Null value
-        return NULL;
-    } else {
-        // Number or boolean - find next delimiter
-        end = start;
-        while (*end && *end != ',' && *end != '}' && *end != ']' && *end != ' ' && *end != '\t' && *end != '\n') {
-            end++;
-        }
-        end--; // Back up one
     }
-    
-    size_t len = end - start;
-    char* result = malloc(len + 1);
-    if (!result) return NULL;
-    
-    strncpy(result, start, len);
-    result[len] = '\0';
-    
+    bridge_arena_release(&param.arena);
     return result;
 }
 
+// {"name": id, ...} for every registered function; the frontend fetches it
+// once and then sends IDs instead of names
+static void bridge_get_methods(const char* json_args, const char* callback_id, app_window_t* window) {
+    (void)json_args; // Unused parameter
+    
+    bridge_result_t result;
+    bridge_writer_t* table = bridge_result_begin(&result);
+    bridge_writer_begin_object(table);
+    for (size_t i = 0; i < g_function_count; i++) {
+        bridge_writer_key(table, g_functions[i].name);
+        bridge_writer_int(table, (long long)i);
+    }
+    bridge_writer_end_object(table);
+    bridge_result_send(&result, callback_id, window);
+}
+
 // List all registered functions
 void bridge_list_functions(void) {
     printf("=== Registered Bridge Functions ===\n");
     for (size_t i = 0; i < g_function_count; i++) {
-        printf("  %s - %s\n", g_functions[i].name, g_functions[i].description);
+        printf("  [%zu] %s - %s%s\n", i, g_functions[i].name, g_functions[i].description,
+               g_functions[i].async ? " (async)" : "");
     }
     printf("===================================\n");
 }
@@ -288,13 +739,15 @@ bool bridge_call_function(const char* function_name, const char* json_params, ap
     }
     
     // Find the function
-    for (size_t i = 0; i < g_function_count; i++) {
-        if (strcmp(g_functions[i].name, function_name) == 0) {
-            printf("Native bridge call: %s\n", function_name);
-            // Call with a dummy callback ID since this is a native call
-            g_functions[i].handler(json_params ? json_params : "{}", "native_call", window);
-            return true;
+    int id = bridge_find_function(function_name);
+    if (id >= 0) {
+        printf("Native bridge call: %s\n", function_name);
+        // Call with a dummy callback ID since this is a native call
+        const char* args = json_params ? json_params : "{}";
+        if (!g_functions[id].async || !bridge_submit_job(g_functions[id].handler, args, "native_call", window)) {
+            g_functions[id].handler(args, "native_call", window);
         }
+        return true;
     }
     
     printf("Bridge call failed: Function '%s' not found\n", function_name);
@@ -305,32 +758,34 @@ bool bridge_call_function(const char* function_name, const char* json_params, ap
 bool bridge_function_exists(const char* function_name) {
     if (!function_name) return false;
     
-    for (size_t i = 0; i < g_function_count; i++) {
-        if (strcmp(g_functions[i].name, function_name) == 0) {
-            return true;
-        }
-    }
-    
-    return false;
+    return bridge_find_function(function_name) >= 0;
 }
 
 // NEW: Send event to frontend (for toolbar actions that should trigger frontend events)
 void bridge_send_event(const char* event_name, const char* json_data, app_window_t* window) {
     if (!event_name || !window) return;
     
-    char event_js[1024];
-    if (json_data && strlen(json_data) > 0) {
-        snprintf(event_js, sizeof(event_js), 
-            "if (window.bridge?.onNativeEvent) { window.bridge.onNativeEvent('%s', %s); }", 
-            event_name, json_data);
-    } else {
-        snprintf(event_js, sizeof(event_js), 
-            "if (window.bridge?.onNativeEvent) { window.bridge.onNativeEvent('%s'); }", 
-            event_name);
+    char arena_buffer[BRIDGE_SCRIPT_ARENA_SIZE];
+    bridge_arena_t arena;
+    bridge_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    bridge_writer_t script;
+    bridge_writer_init(&script, &arena);
+    
+    bridge_writer_raw(&script, "if (window.bridge?.onNativeEvent) { window.bridge.onNativeEvent(");
+    bridge_writer_string(&script, event_name);
+    if (json_data && json_data[0] != '\0') {
+        bridge_writer_json(&script, json_data);
     }
+    bridge_writer_raw(&script, "); }");
     
     printf("Sending native event: %s\n", event_name);
-    platform_webview_evaluate_javascript(window, event_js);
+    const char* text = bridge_writer_text(&script);
+    if (text) {
+        bridge_evaluate(window, text);
+    } else {
+        printf("Bridge: out of memory sending event %s\n", event_name);
+    }
+    bridge_arena_release(&arena);
 }
 
 // NEW: Toolbar action dispatcher - handles toolbar button clicks dynamically
@@ -346,9 +801,19 @@ void bridge_handle_toolbar_action(const char* action_name, app_window_t* window)
     }
     
     // If not found as bridge function, send as an event to frontend
-    char event_data[256];
-    snprintf(event_data, sizeof(event_data), "{\"action\":\"%s\"}", action_name);
-    bridge_send_event("toolbar_action", event_data, window);
+    bridge_result_t event;
+    bridge_writer_t* data = bridge_result_begin(&event);
+    bridge_writer_begin_object(data);
+    bridge_writer_key(data, "action");
+    bridge_writer_string(data, action_name);
+    bridge_writer_end_object(data);
+    const char* event_data = bridge_writer_text(data);
+    if (event_data) {
+        bridge_send_event("toolbar_action", event_data, window);
+    } else {
+        printf("Bridge: out of memory sending toolbar action %s\n", action_name);
+    }
+    bridge_arena_release(&event.arena);
     
     printf("Toolbar action '%s' sent as frontend event\n", action_name);
 }
@@ -362,12 +827,15 @@ void bridge_streaming_get_config(const char* json_args, const char* callback_id,
         return;
     }
     
-    // Create streaming config JSON
-    char* result = malloc(256);
-    snprintf(result, 256, "{\"enabled\": true, \"port\": %d}", window->config->streaming.server.port);
-    
-    bridge_send_response(callback_id, result, window);
-    free(result);
+    bridge_result_t result;
+    bridge_writer_t* config = bridge_result_begin(&result);
+    bridge_writer_begin_object(config);
+    bridge_writer_key(config, "enabled");
+    bridge_writer_bool(config, true);
+    bridge_writer_key(config, "port");
+    bridge_writer_int(config, window->config->streaming.server.port);
+    bridge_writer_end_object(config);
+    bridge_result_send(&result, callback_id, window);
 }
 
 void bridge_streaming_get_server_url(const char* json_args, const char* callback_id, app_window_t* window) {
@@ -379,11 +847,28 @@ void bridge_streaming_get_server_url(const char* json_args, const char* callback
     }
     
     // Create server URL using the configured host
-    char* result = malloc(128);
-    snprintf(result, 128, "\"http://%s:%d\"", 
-             window->config->streaming.server.host, 
+    char url[sizeof(window->config->streaming.server.host) + 32];
+    snprintf(url, sizeof(url), "http://%s:%d",
+             window->config->streaming.server.host,
              window->config->streaming.server.port);
     
-    bridge_send_response(callback_id, result, window);
-    free(result);
+    bridge_result_t result;
+    bridge_writer_string(bridge_result_begin(&result), url);
+    bridge_result_send(&result, callback_id, window);
+}
+
+// {"stream": "<push stream name>", "data": {...}} -> true once queued
+void bridge_streaming_publish(const char* json_args, const char* callback_id, app_window_t* window) {
+    char* stream = bridge_get_string_param(json_args, "stream");
+    char* data = bridge_get_json_value(json_args, "data");
+    
+    if (!stream || !data || data[0] != '{') {
+        bridge_send_error(callback_id, "publish needs a stream name and an object in data", window);
+    } else {
+        bool published = streaming_publish(stream, data, strlen(data));
+        bridge_send_response(callback_id, published ? "true" : "false", window);
+    }
+    
+    free(stream);
+    free(data);
 } 
\ No newline at end of file
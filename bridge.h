@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "platform.h"
+#include "bridge_json.h"
 
 // Constants
 #define MAX_BRIDGE_FUNCTIONS 256
@@ -16,6 +17,7 @@ typedef struct {
     char name[128];
     bridge_handler_t handler;
     char description[256];
+    bool async;                    // Runs on a bridge worker thread instead of the main thread
 } bridge_function_t;
 
 // Bridge initialization and cleanup
@@ -24,11 +26,20 @@ void bridge_cleanup(void);
 
 // Function registration
 void bridge_register(const char* name, bridge_handler_t handler, const char* description);
+
+// Register a handler that runs on the bridge worker pool, for calls slow enough
+// to stall rendering and input. It must not touch the UI directly; its responses,
+// errors and events are queued and delivered on the main thread in batches.
+void bridge_register_async(const char* name, bridge_handler_t handler, const char* description);
 void bridge_register_builtin_functions(void);
 void bridge_register_custom_functions(void);
 void bridge_list_functions(void);
 
-// Message handling
+// Message handling. {"id": n, "method": ..., "params": {...}} where method is
+// either the function name or its method ID; IDs are positions in registration
+// order, listed by the built-in "bridge.getMethods" as {"name": id, ...}.
+// An array of such calls is a batch: they are dispatched in order and the sync
+// handlers' results go back in one window.handleBridgeResponses([[id, ok, result], ...]).
 void bridge_handle_message(const char* json_message, app_window_t* window);
 
 // Native to bridge calling (NEW - for bidirectional communication)
@@ -39,20 +50,41 @@ void bridge_send_event(const char* event_name, const char* json_data, app_window
 // Toolbar action dispatcher (NEW - for dynamic toolbar callbacks)
 void bridge_handle_toolbar_action(const char* action_name, app_window_t* window);
 
-// Utility functions for handlers
+// Utility functions for handlers. result is JSON text of any size; error is
+// plain text and is escaped on the way out.
 void bridge_send_response(const char* callback_id, const char* result, app_window_t* window);
 void bridge_send_error(const char* callback_id, const char* error, app_window_t* window);
 
+// A result built in place: write one value to the writer bridge_result_begin
+// returns, then bridge_result_send sends it (an error if a write failed) and
+// releases everything. Small results stay in buffer.
+typedef struct {
+    char buffer[1024];
+    bridge_arena_t arena;
+    bridge_writer_t writer;
+} bridge_result_t;
+
+bridge_writer_t* bridge_result_begin(bridge_result_t* result);
+void bridge_result_send(bridge_result_t* result, const char* callback_id, app_window_t* window);
+
 // NEW: Streaming bridge functions
 void bridge_streaming_get_config(const char* json_args, const char* callback_id, app_window_t* window);
 void bridge_streaming_get_server_url(const char* json_args, const char* callback_id, app_window_t* window);
+void bridge_streaming_publish(const char* json_args, const char* callback_id, app_window_t* window);
 bool bridge_streaming_register_function(const char* name, const char* endpoint, int interval_ms, const char* description);
 
-// JSON helper functions
+// Parameter access for handlers. The message is tokenized once per call; these
+// look keys up among the top-level members of json_args only. Strings come back
+// unescaped and malloc'd.
 char* bridge_get_string_param(const char* json_args, const char* key);
 int bridge_get_int_param(const char* json_args, const char* key);
 char* bridge_get_id_param(const char* json_args, const char* key);
 char* bridge_get_json_value(const char* json_args, const char* key);
 bool bridge_get_bool_param(const char* json_args, const char* key);
 
+// Typed access to the same tokens: fills json and the index of the arguments
+// object. Free of cost for the json_args a handler was called with; any other
+// string is parsed into arena. False if json_args is not valid JSON.
+bool bridge_get_args(const char* json_args, bridge_json_t* json, int* object, bridge_arena_t* arena);
+
 #endif // BRIDGE_H 
\ No newline at end of file
@@ -28,10 +28,16 @@ export interface AppConfig {
 // Internal message types
 export interface BridgeMessage {
   id: number;
-  method: string;
+  method: string | number; // Method ID once the table from bridge.getMethods has arrived
   params?: unknown;
 }
 
+// One answer in a batch: [message id, success, result or error text]
+export type BridgeResponse = [id: number, success: boolean, result: unknown];
+
+// Method name -> method ID, as returned by bridge.getMethods
+export type BridgeMethodTable = Record<string, number>;
+
 export interface BridgeCallback {
   resolve: (value: unknown) => void;
   reject: (error: Error) => void;
@@ -60,6 +66,8 @@ export interface BridgeAPI {
   streaming: {
     getConfig(): Promise<{ enabled: boolean; port: number }>;
     getServerUrl(): Promise<string>;
+    // Send one sample on a push stream; false if nobody is subscribed or it is backed up
+    publish(stream: string, data: Record<string, unknown>): Promise<boolean>;
   };
 
   // Counter functions
@@ -100,6 +108,7 @@ declare global {
   interface Window {
     bridge: BridgeAPI;
     handleBridgeResponse(id: number, success: boolean, result: unknown): void;
+    handleBridgeResponses(responses: BridgeResponse[]): void;
     webkit?: {
       messageHandlers: {
         bridge: {
@@ -3,6 +3,8 @@ import type {
   BridgeAPI,
   BridgeMessage,
   BridgeCallback,
+  BridgeMethodTable,
+  BridgeResponse,
   WindowSize,
   AppConfig,
   NativeEventHandler,
@@ -13,6 +15,8 @@ export type {
   BridgeAPI,
   BridgeMessage,
   BridgeCallback,
+  BridgeMethodTable,
+  BridgeResponse,
   WindowSize,
   AppConfig,
   NativeEventHandler,
@@ -21,6 +25,10 @@ export type {
 class Bridge implements BridgeAPI {
   private nextCallbackId = 1;
   private callbacks = new Map<number, BridgeCallback>();
+  // Filled once bridge.getMethods answers; until then calls go by name
+  private methodIds = new Map<string, number>();
+  // Calls made in the current microtask, posted together when it ends
+  private pending: BridgeMessage[] = [];
   // NEW: Event listeners for native events
   private eventListeners = new Map<string, Set<NativeEventHandler>>();
 
@@ -30,17 +38,48 @@ class Bridge implements BridgeAPI {
       id: number,
       success: boolean,
       result: unknown
-    ) => {
-      const callback = this.callbacks.get(id);
-      if (callback) {
-        if (success) {
-          callback.resolve(result);
-        } else {
-          callback.reject(new Error(String(result)));
-        }
-        this.callbacks.delete(id);
-      }
+    ) => this.settle(id, success, result);
+
+    // A batch is answered in one script
+    window.handleBridgeResponses = (responses: BridgeResponse[]) => {
+      responses.forEach(([id, success, result]) =>
+        this.settle(id, success, result)
+      );
     };
+
+    // Fetch the method table once so later calls can send small integer IDs
+    if (window.webkit?.messageHandlers.bridge) {
+      this.call<BridgeMethodTable>("bridge.getMethods")
+        .then((table) => {
+          this.methodIds = new Map(Object.entries(table));
+        })
+        .catch((error) => {
+          console.warn("[Bridge] Method table unavailable, calling by name", error);
+        });
+    }
+  }
+
+  private settle(id: number, success: boolean, result: unknown): void {
+    const callback = this.callbacks.get(id);
+    if (callback) {
+      if (success) {
+        callback.resolve(result);
+      } else {
+        callback.reject(new Error(String(result)));
+      }
+      this.callbacks.delete(id);
+    }
+  }
+
+  // Post everything queued this microtask: a lone call as itself, several as one array
+  private flush(): void {
+    const messages = this.pending;
+    this.pending = [];
+    const handler = window.webkit?.messageHandlers.bridge;
+    if (!handler || messages.length === 0) return;
+    handler.postMessage(
+      JSON.stringify(messages.length === 1 ? messages[0] : messages)
+    );
   }
 
   private async call<T>(method: string, params?: unknown): Promise<T> {
@@ -63,12 +102,14 @@ class Bridge implements BridgeAPI {
       // Create bridge message
       const message: BridgeMessage = {
         id,
-        method,
+        method: this.methodIds.get(method) ?? method,
         params: params || null,
       };
 
-      // Send to native layer
-      webkit.messageHandlers.bridge.postMessage(JSON.stringify(message));
+      // Send to native layer with the other calls made this microtask
+      if (this.pending.push(message) === 1) {
+        queueMicrotask(() => this.flush());
+      }
     });
   }
 
@@ -137,6 +178,8 @@ class Bridge implements BridgeAPI {
     getConfig: () =>
       this.call<{ enabled: boolean; port: number }>("streaming.getConfig"),
     getServerUrl: () => this.call<string>("streaming.getServerUrl"),
+    publish: (stream: string, data: Record<string, unknown>) =>
+      this.call<boolean>("streaming.publish", { stream, data }),
   };
 
   // Counter functions
@@ -28,9 +28,22 @@ export interface NetworkPacket {
 
 export interface TcpDumpData extends StreamData {
   packet_count: number;
+  kernel_drops?: number;
   recent_packets: NetworkPacket[];
 }
 
+// Delta mode patch ("patch" events between "data" keyframes)
+export interface StreamAppend {
+  drop: number;
+  items: unknown[];
+}
+
+export interface StreamPatch {
+  $set?: Record<string, unknown>;
+  $unset?: string[];
+  $append?: Record<string, StreamAppend>;
+}
+
 // Stream configuration types
 export interface StreamEndpoint {
   name: string;
@@ -39,6 +52,8 @@ export interface StreamEndpoint {
   interval_ms: number;
   enabled: boolean;
   description: string;
+  max_subscribers?: number;
+  delta_keyframe_interval?: number;
 }
 
 export interface StreamingConfig {
@@ -55,10 +70,12 @@ export interface StreamingConfig {
 // Stream connection types
 export interface StreamConnection {
   url: string;
+  endpoint: StreamEndpointType | null;  // Kept across disconnects to resume the same stream
   eventSource: EventSource | null;
   isConnected: boolean;
   error: string | null;
   lastData: StreamData | null;
+  lastEventId: number | null;
 }
 
 // Stream event handlers
@@ -68,6 +85,23 @@ export type StreamEventHandler<T extends StreamData = StreamData> = (
 export type StreamErrorHandler = (error: string) => void;
 export type StreamConnectionHandler = (connected: boolean) => void;
 
+// Callbacks for one stream on the shared multiplexed connection
+export interface StreamSubscriptionHandlers<T extends StreamData = StreamData> {
+  onData: StreamEventHandler<T>;
+  onError?: StreamErrorHandler;
+  onConnection?: StreamConnectionHandler;
+}
+
+// One connection carrying every subscribed stream
+export interface StreamMultiplexer {
+  // Returns the unsubscribe function
+  subscribe<T extends StreamData = StreamData>(
+    streamName: string,
+    handlers: StreamSubscriptionHandlers<T>
+  ): () => void;
+  isConnected(): boolean;
+}
+
 // Stream manager interface
 export interface StreamManager {
   // Connection management
@@ -96,7 +130,20 @@ export interface StreamManager {
 export declare const STREAM_ENDPOINTS: {
   readonly MEMORY: "/stream/memory";
   readonly TCPDUMP: "/stream/tcpdump";
+  readonly MULTI: "/stream/multi";
 };
 
+// Registered stream names, as used by the multiplexer
+export declare const STREAM_NAMES: {
+  readonly MEMORY: "system.memory";
+  readonly TCPDUMP: "network.tcpdump";
+};
+
+// Rebuild a full sample from the previous one and a patch
+export declare function applyStreamPatch<T extends StreamData = StreamData>(
+  base: T,
+  patch: StreamPatch
+): T;
+
 export type StreamEndpointType =
   (typeof STREAM_ENDPOINTS)[keyof typeof STREAM_ENDPOINTS];
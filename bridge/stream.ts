@@ -1,12 +1,15 @@
 // Stream implementation for frontend
 import type {
   StreamData,
+  StreamPatch,
   StreamConnection,
   StreamEventHandler,
   StreamErrorHandler,
   StreamConnectionHandler,
   StreamManager,
   StreamEndpointType,
+  StreamMultiplexer,
+  StreamSubscriptionHandlers,
 } from "./stream.d";
 import bridge from "./bridge";
 
@@ -14,11 +17,20 @@ import bridge from "./bridge";
 export const STREAM_ENDPOINTS = {
   MEMORY: "/stream/memory",
   TCPDUMP: "/stream/tcpdump",
+  MULTI: "/stream/multi",
+} as const;
+
+// Registered stream names, as used by the multiplexer
+export const STREAM_NAMES = {
+  MEMORY: "system.memory",
+  TCPDUMP: "network.tcpdump",
 } as const;
 
 // Re-export all types for convenience
 export type {
   StreamData,
+  StreamPatch,
+  StreamAppend,
   MemoryData,
   TcpDumpData,
   StreamConnection,
@@ -27,15 +39,43 @@ export type {
   StreamConnectionHandler,
   StreamManager,
   StreamEndpointType,
+  StreamMultiplexer,
+  StreamSubscriptionHandlers,
 } from "./stream.d";
 
+// Rebuild a full sample from the previous one and a patch
+export function applyStreamPatch<T extends StreamData = StreamData>(
+  base: T,
+  patch: StreamPatch
+): T {
+  const next: Record<string, unknown> = { ...base };
+
+  if (patch.$set) {
+    Object.assign(next, patch.$set);
+  }
+  if (patch.$unset) {
+    for (const key of patch.$unset) {
+      delete next[key];
+    }
+  }
+  if (patch.$append) {
+    for (const [key, append] of Object.entries(patch.$append)) {
+      const current = Array.isArray(next[key]) ? (next[key] as unknown[]) : [];
+      next[key] = current.slice(append.drop).concat(append.items);
+    }
+  }
+  return next as T;
+}
+
 class StreamManagerImpl implements StreamManager {
   private connection: StreamConnection = {
     url: "",
+    endpoint: null,
     eventSource: null,
     isConnected: false,
     error: null,
     lastData: null,
+    lastEventId: null,
   };
 
   private dataHandlers: StreamEventHandler[] = [];
@@ -46,7 +86,16 @@ class StreamManagerImpl implements StreamManager {
     try {
       // Get server URL from bridge
       const serverUrl = await bridge.streaming.getServerUrl();
-      const streamUrl = `${serverUrl}${endpoint}`;
+      // Ask for patches between keyframes; streams without delta mode ignore it
+      const separator = endpoint.includes("?") ? "&" : "?";
+      const baseUrl = `${serverUrl}${endpoint}${separator}delta=1`;
+
+      // Reconnecting to the same stream resumes after the last event seen;
+      // EventSource's own reconnects send Last-Event-ID by themselves
+      const resumeId =
+        this.connection.endpoint === endpoint ? this.connection.lastEventId : null;
+      const streamUrl =
+        resumeId !== null ? `${baseUrl}&last_event_id=${resumeId}` : baseUrl;
 
       console.log(`[StreamManager] Connecting to: ${streamUrl}`);
 
@@ -56,8 +105,13 @@ class StreamManagerImpl implements StreamManager {
       // Create new EventSource
       const eventSource = new EventSource(streamUrl);
       this.connection.url = streamUrl;
+      this.connection.endpoint = endpoint;
       this.connection.eventSource = eventSource;
       this.connection.error = null;
+      if (resumeId === null) {
+        this.connection.lastData = null;
+        this.connection.lastEventId = null;
+      }
 
       // Setup event handlers
       eventSource.onopen = () => {
@@ -68,13 +122,23 @@ class StreamManagerImpl implements StreamManager {
 
       eventSource.onmessage = (event) => {
         console.log(`[StreamManager] Message received:`, event.data);
-        this.handleData(event.data);
+        this.handleData(event.data, event.lastEventId);
       };
 
       // Listen for 'data' events specifically (server sends events with this type)
       eventSource.addEventListener("data", (event) => {
         console.log(`[StreamManager] Data event received:`, event.data);
-        this.handleData(event.data);
+        this.handleData(event.data, event.lastEventId);
+      });
+
+      // Delta mode: changes since the previous event
+      eventSource.addEventListener("patch", (event) => {
+        this.handlePatch(event.data, event.lastEventId);
+      });
+
+      // Batched streams: several samples per event, oldest first
+      eventSource.addEventListener("batch", (event) => {
+        this.handleBatch(event.data, event.lastEventId);
       });
 
       eventSource.onerror = (event) => {
@@ -149,10 +213,11 @@ class StreamManagerImpl implements StreamManager {
   }
 
   // Private methods
-  private handleData(rawData: string): void {
+  private handleData(rawData: string, eventId: string): void {
     try {
       const data = JSON.parse(rawData) as StreamData;
       this.connection.lastData = data;
+      this.connection.lastEventId = eventId ? Number(eventId) : null;
       this.notifyDataHandlers(data);
     } catch (error) {
       const errorMsg = `Failed to parse stream data: ${error}`;
@@ -162,6 +227,45 @@ class StreamManagerImpl implements StreamManager {
     }
   }
 
+  // Each sample is delivered on its own; the event id covers the whole batch
+  private handleBatch(rawData: string, eventId: string): void {
+    try {
+      const samples = JSON.parse(rawData) as StreamData[];
+      this.connection.lastEventId = eventId ? Number(eventId) : null;
+      samples.forEach((data) => {
+        this.connection.lastData = data;
+        this.notifyDataHandlers(data);
+      });
+    } catch (error) {
+      const errorMsg = `Failed to parse stream batch: ${error}`;
+      console.error(`[StreamManager] ${errorMsg}`);
+      this.connection.error = errorMsg;
+      this.notifyErrorHandlers(errorMsg);
+    }
+  }
+
+  // A patch only applies on top of the event right before it; after a gap
+  // the next keyframe resynchronizes
+  private handlePatch(rawData: string, eventId: string): void {
+    const id = Number(eventId);
+    const base = this.connection.lastData;
+    if (!base || this.connection.lastEventId === null || id !== this.connection.lastEventId + 1) {
+      return;
+    }
+
+    try {
+      const data = applyStreamPatch(base, JSON.parse(rawData) as StreamPatch);
+      this.connection.lastData = data;
+      this.connection.lastEventId = id;
+      this.notifyDataHandlers(data);
+    } catch (error) {
+      const errorMsg = `Failed to parse stream patch: ${error}`;
+      console.error(`[StreamManager] ${errorMsg}`);
+      this.connection.error = errorMsg;
+      this.notifyErrorHandlers(errorMsg);
+    }
+  }
+
   private notifyDataHandlers(data: StreamData): void {
     this.dataHandlers.forEach((handler) => {
       try {
@@ -196,6 +300,139 @@ class StreamManagerImpl implements StreamManager {
 // Create and export stream manager instance
 export const streamManager = new StreamManagerImpl();
 
+// Shares one EventSource on /stream/multi between every component. The server
+// names each event after its stream, so listeners are attached per stream name;
+// the connection is reopened whenever the set of streams changes.
+class StreamMultiplexerImpl implements StreamMultiplexer {
+  private eventSource: EventSource | null = null;
+  private connected = false;
+  private generation = 0;
+  private reconnectScheduled = false;
+  private subscriptions = new Map<string, Set<StreamSubscriptionHandlers>>();
+
+  subscribe<T extends StreamData = StreamData>(
+    streamName: string,
+    handlers: StreamSubscriptionHandlers<T>
+  ): () => void {
+    const entry = handlers as StreamSubscriptionHandlers;
+    let subscribers = this.subscriptions.get(streamName);
+    if (!subscribers) {
+      subscribers = new Set();
+      this.subscriptions.set(streamName, subscribers);
+      this.scheduleReconnect();
+    } else if (this.connected) {
+      entry.onConnection?.(true);
+    }
+    subscribers.add(entry);
+
+    return () => {
+      const current = this.subscriptions.get(streamName);
+      if (!current || !current.delete(entry)) return;
+      if (current.size === 0) {
+        this.subscriptions.delete(streamName);
+        this.scheduleReconnect();
+      }
+    };
+  }
+
+  isConnected(): boolean {
+    return this.connected;
+  }
+
+  // Coalesce subscription changes made in the same tick into one reconnect
+  private scheduleReconnect(): void {
+    if (this.reconnectScheduled) return;
+    this.reconnectScheduled = true;
+    queueMicrotask(() => {
+      this.reconnectScheduled = false;
+      this.reconnect().catch((error) => {
+        this.notifyError(`Failed to connect to multiplexed stream: ${error}`);
+      });
+    });
+  }
+
+  private async reconnect(): Promise<void> {
+    const generation = ++this.generation;
+    this.eventSource?.close();
+    this.eventSource = null;
+    this.connected = false;
+
+    const names = [...this.subscriptions.keys()];
+    if (names.length === 0) return;
+
+    const serverUrl = await bridge.streaming.getServerUrl();
+    // A newer subscription change may have started its own connection meanwhile
+    if (generation !== this.generation) return;
+
+    const streamUrl = `${serverUrl}${STREAM_ENDPOINTS.MULTI}?s=${names
+      .map(encodeURIComponent)
+      .join(",")}`;
+    console.log(`[StreamMultiplexer] Connecting to: ${streamUrl}`);
+
+    const eventSource = new EventSource(streamUrl);
+    this.eventSource = eventSource;
+
+    eventSource.onopen = () => {
+      this.connected = true;
+      this.notifyConnection(true);
+    };
+
+    eventSource.onerror = (event) => {
+      console.error(`[StreamMultiplexer] Stream error:`, event);
+      this.connected = false;
+      this.notifyError(`Stream connection error for ${names.join(", ")}`);
+      this.notifyConnection(false);
+    };
+
+    for (const name of names) {
+      eventSource.addEventListener(name, (event) => {
+        this.dispatch(name, (event as MessageEvent).data);
+      });
+    }
+  }
+
+  private dispatch(streamName: string, rawData: string): void {
+    const subscribers = this.subscriptions.get(streamName);
+    if (!subscribers) return;
+
+    let samples: StreamData[];
+    try {
+      // Batched streams send an array of samples under the same event name
+      const parsed = JSON.parse(rawData) as StreamData | StreamData[];
+      samples = Array.isArray(parsed) ? parsed : [parsed];
+    } catch (error) {
+      const errorMsg = `Failed to parse ${streamName} data: ${error}`;
+      subscribers.forEach((handlers) => handlers.onError?.(errorMsg));
+      return;
+    }
+
+    samples.forEach((data) =>
+      subscribers.forEach((handlers) => {
+        try {
+          handlers.onData(data);
+        } catch (error) {
+          console.error(`[StreamMultiplexer] Error in ${streamName} handler:`, error);
+        }
+      })
+    );
+  }
+
+  private notifyError(error: string): void {
+    this.subscriptions.forEach((subscribers) =>
+      subscribers.forEach((handlers) => handlers.onError?.(error))
+    );
+  }
+
+  private notifyConnection(connected: boolean): void {
+    this.subscriptions.forEach((subscribers) =>
+      subscribers.forEach((handlers) => handlers.onConnection?.(connected))
+    );
+  }
+}
+
+// Shared multiplexed connection for components that show several streams
+export const streamMultiplexer: StreamMultiplexer = new StreamMultiplexerImpl();
+
 // Utility function to create a new stream manager instance
 export function createStreamManager(): StreamManager {
   return new StreamManagerImpl();
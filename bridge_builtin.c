@@ -52,9 +52,15 @@ static void bridge_window_get_size(const char* json_args, const char* callback_i
     (void)window; // Unused for now
     
     // Return default size for now
-    char response[256];
-    snprintf(response, sizeof(response), "{\"width\":800,\"height\":600}");
-    bridge_send_response(callback_id, response, window);
+    bridge_result_t result;
+    bridge_writer_t* size = bridge_result_begin(&result);
+    bridge_writer_begin_object(size);
+    bridge_writer_key(size, "width");
+    bridge_writer_int(size, 800);
+    bridge_writer_key(size, "height");
+    bridge_writer_int(size, 600);
+    bridge_writer_end_object(size);
+    bridge_result_send(&result, callback_id, window);
 }
 
 // System operations
@@ -71,10 +77,17 @@ static void bridge_system_get_version(const char* json_args, const char* callbac
 static void bridge_system_get_config(const char* json_args, const char* callback_id, app_window_t* window) {
     (void)json_args; // Unused parameter
     
-    char response[512];
-    snprintf(response, sizeof(response), 
-        "{\"name\":\"Desktop App\",\"version\":\"1.0.0\",\"debug\":true}");
-    bridge_send_response(callback_id, response, window);
+    bridge_result_t result;
+    bridge_writer_t* config = bridge_result_begin(&result);
+    bridge_writer_begin_object(config);
+    bridge_writer_key(config, "name");
+    bridge_writer_string(config, "Desktop App");
+    bridge_writer_key(config, "version");
+    bridge_writer_string(config, "1.0.0");
+    bridge_writer_key(config, "debug");
+    bridge_writer_bool(config, true);
+    bridge_writer_end_object(config);
+    bridge_result_send(&result, callback_id, window);
 }
 
 // UI operations
@@ -131,4 +144,5 @@ void bridge_register_builtin_functions(void) {
     // Streaming functions
     bridge_register("streaming.getConfig", bridge_streaming_get_config, "Get streaming configuration");
     bridge_register("streaming.getServerUrl", bridge_streaming_get_server_url, "Get streaming server URL");
+    bridge_register("streaming.publish", bridge_streaming_publish, "Publish a sample on a push stream");
 } 
\ No newline at end of file
@@ -64,12 +64,19 @@ static void bridge_demo_greet(const char* json_args, const char* callback_id, ap
         return;
     }
     
-    char response[256];
-    snprintf(response, sizeof(response), "\"Hello, %s! Greetings from C!\"", name);
-    
     printf("Greeting: Hello, %s!\n", name);
     
-    bridge_send_response(callback_id, response, window);
+    // The greeting is sized to the name and goes through the writer, so neither
+    // length nor quotes in the name can break the result
+    bridge_result_t result;
+    bridge_writer_t* out = bridge_result_begin(&result);
+    size_t size = strlen(name) + sizeof("Hello, ! Greetings from C!");
+    char* greeting = bridge_arena_alloc(&result.arena, size);
+    if (greeting) {
+        snprintf(greeting, size, "Hello, %s! Greetings from C!", name);
+        bridge_writer_string(out, greeting);
+    }
+    bridge_result_send(&result, callback_id, window);
     free(name);
 }
 
@@ -234,7 +241,7 @@ void bridge_register_custom_functions(void) {
     
     // Demo functions
     bridge_register("demo.greet", bridge_demo_greet, "Greet user by name");
-    bridge_register("demo.calculate", bridge_demo_calculate, "Perform calculation");
+    bridge_register_async("demo.calculate", bridge_demo_calculate, "Perform calculation");
 
     // Toolbar action handlers - these can be called from toolbar buttons
     bridge_register("toolbar_back_callback", bridge_toolbar_back,
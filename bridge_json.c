@@ -0,0 +1,623 @@
+#include "bridge_json.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE 4096
+#define JSON_INITIAL_TOKENS 32
+#define WRITER_INITIAL_CAPACITY 256
+
+void bridge_arena_init(bridge_arena_t* arena, void* buffer, size_t size) {
+    // Callers pass plain char arrays, so the start is aligned here; offsets are
+    // kept multiples of 8 from then on
+    size_t skip = (size_t)(-(uintptr_t)buffer & 7);
+    arena->buffer = buffer && size > skip ? (char*)buffer + skip : NULL;
+    arena->used = 0;
+    arena->capacity = arena->buffer ? size - skip : 0;
+    arena->chunks = NULL;
+}
+
+void* bridge_arena_alloc(bridge_arena_t* arena, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+
+    if (arena->buffer && size <= arena->capacity - arena->used) {
+        void* memory = arena->buffer + arena->used;
+        arena->used += size;
+        return memory;
+    }
+
+    bridge_arena_chunk_t* chunk = arena->chunks;
+    if (!chunk || size > chunk->capacity - chunk->used) {
+        size_t capacity = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = malloc(sizeof(bridge_arena_chunk_t) + capacity);
+        if (!chunk) return NULL;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    void* memory = chunk->data + chunk->used;
+    chunk->used += size;
+    return memory;
+}
+
+void bridge_arena_release(bridge_arena_t* arena) {
+    while (arena->chunks) {
+        bridge_arena_chunk_t* chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        free(chunk);
+    }
+    arena->used = 0;
+}
+
+// Tokenizer state; p only moves forward
+typedef struct {
+    const char* text;
+    const char* p;
+    const char* end;
+    bridge_json_t* json;
+} json_parser_t;
+
+static int json_add_token(json_parser_t* parser, bridge_json_type_t type, const char* start) {
+    bridge_json_t* json = parser->json;
+    if (json->count == json->capacity) {
+        int capacity = json->capacity ? json->capacity * 2 : JSON_INITIAL_TOKENS;
+        bridge_json_token_t* tokens = bridge_arena_alloc(json->arena, (size_t)capacity * sizeof(bridge_json_token_t));
+        if (!tokens) return -1;
+        if (json->count > 0) memcpy(tokens, json->tokens, (size_t)json->count * sizeof(bridge_json_token_t));
+        json->tokens = tokens;
+        json->capacity = capacity;
+    }
+
+    bridge_json_token_t* token = &json->tokens[json->count];
+    token->start = (uint32_t)(start - parser->text);
+    token->length = 0;
+    token->next = 0;
+    token->count = 0;
+    token->type = (uint8_t)type;
+    token->escaped = false;
+    return json->count++;
+}
+
+static void json_skip_whitespace(json_parser_t* parser) {
+    while (parser->p < parser->end &&
+           (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\n' || *parser->p == '\r')) {
+        parser->p++;
+    }
+}
+
+static bool json_is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool json_is_digit(const json_parser_t* parser) {
+    return parser->p < parser->end && *parser->p >= '0' && *parser->p <= '9';
+}
+
+static int json_parse_string(json_parser_t* parser) {
+    parser->p++;                                            // Opening quote
+    int index = json_add_token(parser, BRIDGE_JSON_STRING, parser->p);
+    if (index < 0) return -1;
+
+    bool escaped = false;
+    while (parser->p < parser->end) {
+        unsigned char c = (unsigned char)*parser->p;
+        if (c == '"') {
+            bridge_json_token_t* token = &parser->json->tokens[index];
+            token->length = (uint32_t)(parser->p - parser->text) - token->start;
+            token->escaped = escaped;
+            token->next = (uint32_t)index + 1;
+            parser->p++;
+            return index;
+        }
+        if (c < 0x20) return -1;
+        if (c == '\\') {
+            escaped = true;
+            if (parser->end - parser->p < 2) return -1;
+            char e = parser->p[1];
+            if (e == 'u') {
+                if (parser->end - parser->p < 6 || !json_is_hex(parser->p[2]) || !json_is_hex(parser->p[3]) ||
+                    !json_is_hex(parser->p[4]) || !json_is_hex(parser->p[5])) {
+                    return -1;
+                }
+                parser->p += 6;
+                continue;
+            }
+            if (!strchr("\"\\/bfnrt", e) || e == '\0') return -1;
+            parser->p += 2;
+            continue;
+        }
+        parser->p++;
+    }
+    return -1;
+}
+
+static int json_parse_number(json_parser_t* parser) {
+    const char* start = parser->p;
+    if (*parser->p == '-') parser->p++;
+    if (!json_is_digit(parser)) return -1;
+    if (*parser->p == '0') {
+        parser->p++;
+    } else {
+        while (json_is_digit(parser)) parser->p++;
+    }
+    if (parser->p < parser->end && *parser->p == '.') {
+        parser->p++;
+        if (!json_is_digit(parser)) return -1;
+        while (json_is_digit(parser)) parser->p++;
+    }
+    if (parser->p < parser->end && (*parser->p == 'e' || *parser->p == 'E')) {
+        parser->p++;
+        if (parser->p < parser->end && (*parser->p == '+' || *parser->p == '-')) parser->p++;
+        if (!json_is_digit(parser)) return -1;
+        while (json_is_digit(parser)) parser->p++;
+    }
+
+    int index = json_add_token(parser, BRIDGE_JSON_NUMBER, start);
+    if (index < 0) return -1;
+    parser->json->tokens[index].length = (uint32_t)(parser->p - start);
+    parser->json->tokens[index].next = (uint32_t)index + 1;
+    return index;
+}
+
+static int json_parse_literal(json_parser_t* parser, const char* literal, bridge_json_type_t type) {
+    size_t length = strlen(literal);
+    if ((size_t)(parser->end - parser->p) < length || memcmp(parser->p, literal, length) != 0) return -1;
+
+    int index = json_add_token(parser, type, parser->p);
+    if (index < 0) return -1;
+    parser->json->tokens[index].length = (uint32_t)length;
+    parser->json->tokens[index].next = (uint32_t)index + 1;
+    parser->p += length;
+    return index;
+}
+
+static int json_parse_value(json_parser_t* parser, int depth);
+
+// Objects and arrays share everything but the member syntax
+static int json_parse_container(json_parser_t* parser, int depth, bool object) {
+    if (depth >= BRIDGE_JSON_MAX_DEPTH) return -1;
+
+    const char* start = parser->p;
+    char close = object ? '}' : ']';
+    int index = json_add_token(parser, object ? BRIDGE_JSON_OBJECT : BRIDGE_JSON_ARRAY, start);
+    if (index < 0) return -1;
+    parser->p++;
+
+    uint32_t count = 0;
+    json_skip_whitespace(parser);
+    if (parser->p < parser->end && *parser->p == close) {
+        parser->p++;
+    } else {
+        for (;;) {
+            json_skip_whitespace(parser);
+            if (object) {
+                if (parser->p >= parser->end || *parser->p != '"' || json_parse_string(parser) < 0) return -1;
+                json_skip_whitespace(parser);
+                if (parser->p >= parser->end || *parser->p != ':') return -1;
+                parser->p++;
+            }
+            if (json_parse_value(parser, depth + 1) < 0) return -1;
+            count++;
+
+            json_skip_whitespace(parser);
+            if (parser->p >= parser->end) return -1;
+            if (*parser->p == ',') {
+                parser->p++;
+                continue;
+            }
+            if (*parser->p != close) return -1;
+            parser->p++;
+            break;
+        }
+    }
+
+    bridge_json_token_t* token = &parser->json->tokens[index];
+    token->length = (uint32_t)(parser->p - start);
+    token->count = count;
+    token->next = (uint32_t)parser->json->count;
+    return index;
+}
+
+static int json_parse_value(json_parser_t* parser, int depth) {
+    json_skip_whitespace(parser);
+    if (parser->p >= parser->end) return -1;
+
+    switch (*parser->p) {
+    case '{': return json_parse_container(parser, depth, true);
+    case '[': return json_parse_container(parser, depth, false);
+    case '"': return json_parse_string(parser);
+    case 't': return json_parse_literal(parser, "true", BRIDGE_JSON_BOOL);
+    case 'f': return json_parse_literal(parser, "false", BRIDGE_JSON_BOOL);
+    case 'n': return json_parse_literal(parser, "null", BRIDGE_JSON_NULL);
+    default: return json_parse_number(parser);
+    }
+}
+
+bool bridge_json_parse(bridge_json_t* json, const char* text, size_t length, bridge_arena_t* arena) {
+    json->text = text;
+    json->tokens = NULL;
+    json->count = 0;
+    json->capacity = 0;
+    json->arena = arena;
+    if (!text || length >= UINT32_MAX) return false;
+
+    json_parser_t parser = { text, text, text + length, json };
+    if (json_parse_value(&parser, 0) < 0) return false;
+    json_skip_whitespace(&parser);
+    return parser.p == parser.end;
+}
+
+static unsigned long json_hex4(const char* p) {
+    return strtoul((char[]){ p[0], p[1], p[2], p[3], '\0' }, NULL, 16);
+}
+
+// Decode one character of a string token (a raw byte or an escape) at *p into
+// out as UTF-8, advancing *p past it; returns the bytes written (at most 4).
+// \u0000 and unpaired surrogates become U+FFFD so that the result is a whole C
+// string and valid UTF-8.
+static size_t json_unescape_char(const char** p, const char* end, char out[4]) {
+    const char* s = *p;
+    if (*s != '\\') {
+        out[0] = *s;
+        *p = s + 1;
+        return 1;
+    }
+    *p = s + 2;
+    switch (s[1]) {
+    case 'b': out[0] = '\b'; return 1;
+    case 'f': out[0] = '\f'; return 1;
+    case 'n': out[0] = '\n'; return 1;
+    case 'r': out[0] = '\r'; return 1;
+    case 't': out[0] = '\t'; return 1;
+    case 'u': break;
+    default: out[0] = s[1]; return 1;                  // \" \\ \/
+    }
+
+    unsigned long code = json_hex4(s + 2);
+    *p = s + 6;
+    // A high surrogate followed by a low one is a single code point
+    if (code >= 0xd800 && code <= 0xdbff && end - *p >= 6 && (*p)[0] == '\\' && (*p)[1] == 'u') {
+        unsigned long low = json_hex4(*p + 2);
+        if (low >= 0xdc00 && low <= 0xdfff) {
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+            *p += 6;
+        }
+    }
+    if (code == 0 || (code >= 0xd800 && code <= 0xdfff)) code = 0xfffd;
+
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xc0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3f));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xe0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (code & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (code & 0x3f));
+    return 4;
+}
+
+// Write the unescaped form of a string token to out (room for token length + 1)
+static size_t json_unescape(const char* p, size_t length, char* out) {
+    const char* end = p + length;
+    char* o = out;
+    while (p < end) {
+        if (*p != '\\') {
+            *o++ = *p++;
+            continue;
+        }
+        o += json_unescape_char(&p, end, o);
+    }
+    *o = '\0';
+    return (size_t)(o - out);
+}
+
+// Whether an escaped string token decodes to key, without a decoded copy
+static bool json_unescaped_equals(const char* p, size_t length, const char* key, size_t key_length) {
+    const char* end = p + length;
+    while (p < end) {
+        char decoded[4];
+        size_t n = json_unescape_char(&p, end, decoded);
+        if (n > key_length || memcmp(decoded, key, n) != 0) return false;
+        key += n;
+        key_length -= n;
+    }
+    return key_length == 0;
+}
+
+int bridge_json_get(const bridge_json_t* json, int object, const char* key) {
+    if (!json || !key || object < 0 || object >= json->count ||
+        json->tokens[object].type != BRIDGE_JSON_OBJECT) {
+        return -1;
+    }
+
+    size_t key_length = strlen(key);
+    const bridge_json_token_t* tokens = json->tokens;
+    uint32_t index = (uint32_t)object + 1;
+    for (uint32_t member = 0; member < tokens[object].count; member++) {
+        const bridge_json_token_t* name = &tokens[index];
+        const char* text = json->text + name->start;
+        uint32_t value = index + 1;
+
+        bool match;
+        if (!name->escaped) {
+            match = name->length == key_length && memcmp(text, key, key_length) == 0;
+        } else {
+            match = json_unescaped_equals(text, name->length, key, key_length);
+        }
+        if (match) return (int)value;
+
+        index = tokens[value].next;
+    }
+    return -1;
+}
+
+bridge_json_type_t bridge_json_type(const bridge_json_t* json, int index) {
+    if (!json || index < 0 || index >= json->count) return BRIDGE_JSON_NULL;
+    return (bridge_json_type_t)json->tokens[index].type;
+}
+
+const char* bridge_json_raw(const bridge_json_t* json, int index, size_t* length) {
+    if (!json || index < 0 || index >= json->count) return NULL;
+    if (length) *length = json->tokens[index].length;
+    return json->text + json->tokens[index].start;
+}
+
+// Numbers are not NUL-terminated in place; they are short enough to copy
+static bool json_number_text(const bridge_json_t* json, int index, char* out, size_t size) {
+    if (bridge_json_type(json, index) != BRIDGE_JSON_NUMBER || json->tokens[index].length >= size) return false;
+    memcpy(out, json->text + json->tokens[index].start, json->tokens[index].length);
+    out[json->tokens[index].length] = '\0';
+    return true;
+}
+
+bool bridge_json_int(const bridge_json_t* json, int index, long long* value) {
+    char text[64];
+    if (!json_number_text(json, index, text, sizeof(text))) return false;
+    *value = strtoll(text, NULL, 10);               // Fractions are truncated
+    return true;
+}
+
+bool bridge_json_double(const bridge_json_t* json, int index, double* value) {
+    char text[64];
+    if (!json_number_text(json, index, text, sizeof(text))) return false;
+    *value = strtod(text, NULL);
+    return true;
+}
+
+bool bridge_json_bool(const bridge_json_t* json, int index, bool* value) {
+    if (bridge_json_type(json, index) != BRIDGE_JSON_BOOL) return false;
+    *value = json->text[json->tokens[index].start] == 't';
+    return true;
+}
+
+char* bridge_json_string(const bridge_json_t* json, int index, bridge_arena_t* arena) {
+    if (bridge_json_type(json, index) != BRIDGE_JSON_STRING) return NULL;
+
+    const bridge_json_token_t* token = &json->tokens[index];
+    char* out = arena ? bridge_arena_alloc(arena, (size_t)token->length + 1) : malloc((size_t)token->length + 1);
+    if (!out) return NULL;
+    if (token->escaped) {
+        json_unescape(json->text + token->start, token->length, out);
+    } else {
+        memcpy(out, json->text + token->start, token->length);
+        out[token->length] = '\0';
+    }
+    return out;
+}
+
+void bridge_writer_init(bridge_writer_t* writer, bridge_arena_t* arena) {
+    writer->arena = arena;
+    writer->data = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+    writer->failed = false;
+    writer->separate = false;
+}
+
+const char* bridge_writer_text(const bridge_writer_t* writer) {
+    if (writer->failed) return NULL;
+    return writer->data ? writer->data : "";
+}
+
+// Room for size more bytes; NULL once the writer has failed
+static char* writer_reserve(bridge_writer_t* writer, size_t size) {
+    if (writer->failed) return NULL;
+
+    if (!writer->data || size > writer->capacity - writer->length) {
+        size_t capacity = writer->capacity ? writer->capacity : WRITER_INITIAL_CAPACITY;
+        while (capacity - writer->length < size) {
+            if (capacity > SIZE_MAX / 2) {
+                writer->failed = true;
+                return NULL;
+            }
+            capacity *= 2;
+        }
+        char* data = bridge_arena_alloc(writer->arena, capacity + 1);
+        if (!data) {
+            writer->failed = true;
+            return NULL;
+        }
+        if (writer->length > 0) memcpy(data, writer->data, writer->length);
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+    return writer->data + writer->length;
+}
+
+static void writer_append(bridge_writer_t* writer, const char* data, size_t length) {
+    char* out = writer_reserve(writer, length);
+    if (!out) return;
+    memcpy(out, data, length);
+    writer->length += length;
+    writer->data[writer->length] = '\0';
+}
+
+// Comma before any value or key that follows a sibling
+static void writer_value_start(bridge_writer_t* writer) {
+    if (writer->separate) writer_append(writer, ",", 1);
+    writer->separate = true;
+}
+
+void bridge_writer_raw(bridge_writer_t* writer, const char* text) {
+    writer_append(writer, text, strlen(text));
+    writer->separate = false;
+}
+
+void bridge_writer_null(bridge_writer_t* writer) {
+    writer_value_start(writer);
+    writer_append(writer, "null", 4);
+}
+
+void bridge_writer_bool(bridge_writer_t* writer, bool value) {
+    writer_value_start(writer);
+    if (value) {
+        writer_append(writer, "true", 4);
+    } else {
+        writer_append(writer, "false", 5);
+    }
+}
+
+void bridge_writer_int(bridge_writer_t* writer, long long value) {
+    char text[24];
+    int length = snprintf(text, sizeof(text), "%lld", value);
+    writer_value_start(writer);
+    writer_append(writer, text, (size_t)length);
+}
+
+void bridge_writer_double(bridge_writer_t* writer, double value) {
+    if (!isfinite(value)) {
+        bridge_writer_null(writer);
+        return;
+    }
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%.17g", value);
+    writer_value_start(writer);
+    writer_append(writer, text, (size_t)length);
+}
+
+// Bytes a string takes quoted and escaped, so the arena block is sized once
+static size_t writer_string_size(const unsigned char* p) {
+    size_t size = 2;
+    for (; *p; p++) {
+        if (*p == '"' || *p == '\\' || *p == '\n' || *p == '\r' || *p == '\t' || *p == '\b' || *p == '\f') {
+            size += 2;
+        } else if (*p < 0x20) {
+            size += 6;
+        } else if (*p == 0xe2 && p[1] == 0x80 && (p[2] == 0xa8 || p[2] == 0xa9)) {
+            size += 6;
+            p += 2;
+        } else {
+            size++;
+        }
+    }
+    return size;
+}
+
+// Quoted and escaped string
+static void writer_append_string(bridge_writer_t* writer, const char* text) {
+    char* out = writer_reserve(writer, writer_string_size((const unsigned char*)text));
+    if (!out) return;
+
+    static const char hex[] = "0123456789abcdef";
+    char* start = out;
+    *out++ = '"';
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        unsigned char c = *p;
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char)c;
+        } else if (c >= 0x20) {
+            // U+2028 and U+2029 are valid in JSON but end a line in older JavaScript
+            if (c == 0xe2 && p[1] == 0x80 && (p[2] == 0xa8 || p[2] == 0xa9)) {
+                memcpy(out, p[2] == 0xa8 ? "\\u2028" : "\\u2029", 6);
+                out += 6;
+                p += 2;
+            } else {
+                *out++ = (char)c;
+            }
+        } else if (c == '\n') {
+            *out++ = '\\';
+            *out++ = 'n';
+        } else if (c == '\r') {
+            *out++ = '\\';
+            *out++ = 'r';
+        } else if (c == '\t') {
+            *out++ = '\\';
+            *out++ = 't';
+        } else if (c == '\b') {
+            *out++ = '\\';
+            *out++ = 'b';
+        } else if (c == '\f') {
+            *out++ = '\\';
+            *out++ = 'f';
+        } else {
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[c >> 4];
+            out[5] = hex[c & 0x0f];
+            out += 6;
+        }
+    }
+    *out++ = '"';
+    writer->length += (size_t)(out - start);
+    writer->data[writer->length] = '\0';
+}
+
+void bridge_writer_string(bridge_writer_t* writer, const char* text) {
+    if (!text) {
+        bridge_writer_null(writer);
+        return;
+    }
+    writer_value_start(writer);
+    writer_append_string(writer, text);
+}
+
+void bridge_writer_json(bridge_writer_t* writer, const char* json_text) {
+    if (!json_text) {
+        bridge_writer_null(writer);
+        return;
+    }
+    writer_value_start(writer);
+    writer_append(writer, json_text, strlen(json_text));
+}
+
+void bridge_writer_begin_object(bridge_writer_t* writer) {
+    writer_value_start(writer);
+    writer_append(writer, "{", 1);
+    writer->separate = false;
+}
+
+void bridge_writer_end_object(bridge_writer_t* writer) {
+    writer_append(writer, "}", 1);
+    writer->separate = true;
+}
+
+void bridge_writer_begin_array(bridge_writer_t* writer) {
+    writer_value_start(writer);
+    writer_append(writer, "[", 1);
+    writer->separate = false;
+}
+
+void bridge_writer_end_array(bridge_writer_t* writer) {
+    writer_append(writer, "]", 1);
+    writer->separate = true;
+}
+
+void bridge_writer_key(bridge_writer_t* writer, const char* key) {
+    writer_value_start(writer);
+    writer_append_string(writer, key ? key : "");
+    writer_append(writer, ":", 1);
+    writer->separate = false;
+}
@@ -0,0 +1,120 @@
+#ifndef BRIDGE_JSON_H
+#define BRIDGE_JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-call bump allocator. It starts in a caller-supplied buffer (usually on
+// the stack, any alignment; the first bytes up to an 8-byte boundary go unused)
+// and spills into malloc'd chunks; everything is released at once.
+typedef struct bridge_arena_chunk {
+    struct bridge_arena_chunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} bridge_arena_chunk_t;
+
+typedef struct {
+    char* buffer;
+    size_t used;
+    size_t capacity;
+    bridge_arena_chunk_t* chunks;     // Overflow, newest first
+} bridge_arena_t;
+
+void bridge_arena_init(bridge_arena_t* arena, void* buffer, size_t size);
+void* bridge_arena_alloc(bridge_arena_t* arena, size_t size);    // 8-byte aligned, NULL when out of memory
+void bridge_arena_release(bridge_arena_t* arena);
+
+typedef enum {
+    BRIDGE_JSON_NULL,
+    BRIDGE_JSON_BOOL,
+    BRIDGE_JSON_NUMBER,
+    BRIDGE_JSON_STRING,
+    BRIDGE_JSON_ARRAY,
+    BRIDGE_JSON_OBJECT
+} bridge_json_type_t;
+
+// One value of the document, in document order. Objects are followed by their
+// members as key/value token pairs, arrays by their items; next is the index
+// just past the whole value, so siblings are one step apart however deep they are.
+typedef struct {
+    uint32_t start;                   // Offset of the value; strings exclude the quotes
+    uint32_t length;
+    uint32_t next;
+    uint32_t count;                   // Members or items
+    uint8_t type;                     // bridge_json_type_t
+    bool escaped;                     // String contains backslash escapes
+} bridge_json_token_t;
+
+typedef struct {
+    const char* text;                 // Not copied; must outlive the tokens
+    bridge_json_token_t* tokens;      // In the arena
+    int count;
+    int capacity;
+    bridge_arena_t* arena;
+} bridge_json_t;
+
+// Tokenize text in one pass. The top-level value is token 0. False if the text
+// is not a single well-formed JSON value or nesting exceeds BRIDGE_JSON_MAX_DEPTH.
+#define BRIDGE_JSON_MAX_DEPTH 64
+bool bridge_json_parse(bridge_json_t* json, const char* text, size_t length, bridge_arena_t* arena);
+
+// Value of key among object's own members (nested objects are not searched); -1 if absent.
+// A linear scan in member order: bridge arguments are small objects read once each.
+int bridge_json_get(const bridge_json_t* json, int object, const char* key);
+
+bridge_json_type_t bridge_json_type(const bridge_json_t* json, int index);
+
+// Raw text of a value (strings without their quotes, still escaped)
+const char* bridge_json_raw(const bridge_json_t* json, int index, size_t* length);
+
+// Typed reads; false (and *value untouched) if index is -1 or of another type
+bool bridge_json_int(const bridge_json_t* json, int index, long long* value);
+bool bridge_json_double(const bridge_json_t* json, int index, double* value);
+bool bridge_json_bool(const bridge_json_t* json, int index, bool* value);
+
+// Unescaped, NUL-terminated copy of a string value, in the arena (malloc'd when
+// arena is NULL, for the caller to free); NULL if not a string. \u0000 and
+// unpaired surrogates decode to U+FFFD.
+char* bridge_json_string(const bridge_json_t* json, int index, bridge_arena_t* arena);
+
+// Growable JSON/JavaScript text in an arena. Growing moves the text to a larger
+// block of the same arena, so nothing needs freeing but the arena itself.
+// Commas between array items, object members and call arguments are written
+// automatically; after an allocation failure later writes are dropped.
+typedef struct {
+    bridge_arena_t* arena;
+    char* data;
+    size_t length;
+    size_t capacity;                  // Usable bytes, not counting the terminator
+    bool failed;
+    bool separate;                    // The next value or key follows a sibling
+} bridge_writer_t;
+
+void bridge_writer_init(bridge_writer_t* writer, bridge_arena_t* arena);
+
+// NUL-terminated text so far ("" when empty); NULL if a write failed
+const char* bridge_writer_text(const bridge_writer_t* writer);
+
+// Script text as is, e.g. "f(" or ");"; the next value starts a new list
+void bridge_writer_raw(bridge_writer_t* writer, const char* text);
+
+void bridge_writer_null(bridge_writer_t* writer);
+void bridge_writer_bool(bridge_writer_t* writer, bool value);
+void bridge_writer_int(bridge_writer_t* writer, long long value);
+void bridge_writer_double(bridge_writer_t* writer, double value);   // null if not finite
+
+// Quoted and escaped; also safe inside a JavaScript string literal. NULL writes null.
+void bridge_writer_string(bridge_writer_t* writer, const char* text);
+
+// Already-encoded JSON text as one value; NULL writes null
+void bridge_writer_json(bridge_writer_t* writer, const char* json_text);
+
+void bridge_writer_begin_object(bridge_writer_t* writer);
+void bridge_writer_end_object(bridge_writer_t* writer);
+void bridge_writer_begin_array(bridge_writer_t* writer);
+void bridge_writer_end_array(bridge_writer_t* writer);
+void bridge_writer_key(bridge_writer_t* writer, const char* key);
+
+#endif // BRIDGE_JSON_H
@@ -366,6 +366,18 @@ static void parse_streaming_config(const char* json, streaming_config_t* config)
     strcpy(config->server.host, "127.0.0.1");
     config->server.port = 8080;
     config->server.max_connections = 10;
+    config->server.max_connections_per_ip = 0;
+    config->server.retry_after_seconds = 5;
+    config->server.event_loops = 0;
+    config->server.reuse_port = false;
+    config->server.zerocopy_threshold = 0;
+    config->server.request_timeout_ms = 10000;
+    config->server.heartbeat_interval_ms = 15000;
+    config->server.reconnect_retry_ms = 3000;
+    config->server.send_queue_max_frames = 64;
+    config->server.send_queue_max_bytes = 1048576;
+    strcpy(config->server.slow_consumer_policy, "drop_oldest");
+    config->server.slow_consumer_timeout_ms = 5000;
     config->stream_count = 0;
 
     // Parse streaming enabled flag
@@ -401,6 +413,79 @@ static void parse_streaming_config(const char* json, streaming_config_t* config)
             free(value);
         }
         
+        value = find_json_value(server_content, "max_connections_per_ip");
+        if (value) {
+            config->server.max_connections_per_ip = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "retry_after_seconds");
+        if (value) {
+            config->server.retry_after_seconds = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "event_loops");
+        if (value) {
+            config->server.event_loops = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "reuse_port");
+        if (value) {
+            config->server.reuse_port = (strcmp(value, "true") == 0);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "zerocopy_threshold");
+        if (value) {
+            config->server.zerocopy_threshold = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "request_timeout_ms");
+        if (value) {
+            config->server.request_timeout_ms = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "heartbeat_interval_ms");
+        if (value) {
+            config->server.heartbeat_interval_ms = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "reconnect_retry_ms");
+        if (value) {
+            config->server.reconnect_retry_ms = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "send_queue_max_frames");
+        if (value) {
+            config->server.send_queue_max_frames = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "send_queue_max_bytes");
+        if (value) {
+            config->server.send_queue_max_bytes = atoi(value);
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "slow_consumer_policy");
+        if (value) {
+            strncpy(config->server.slow_consumer_policy, value, sizeof(config->server.slow_consumer_policy) - 1);
+            config->server.slow_consumer_policy[sizeof(config->server.slow_consumer_policy) - 1] = '\0';
+            free(value);
+        }
+        
+        value = find_json_value(server_content, "slow_consumer_timeout_ms");
+        if (value) {
+            config->server.slow_consumer_timeout_ms = atoi(value);
+            free(value);
+        }
+        
         free(server_content);
     }
 
@@ -485,6 +570,12 @@ static void parse_streaming_config(const char* json, streaming_config_t* config)
                         free(value);
                     }
                     
+                    value = find_json_value(obj_content, "push");
+                    if (value) {
+                        stream->push = (strcmp(value, "true") == 0);
+                        free(value);
+                    }
+                    
                     value = find_json_value(obj_content, "description");
                     if (value) {
                         strncpy(stream->description, value, sizeof(stream->description) - 1);
@@ -492,6 +583,72 @@ static void parse_streaming_config(const char* json, streaming_config_t* config)
                         free(value);
                     }
                     
+                    value = find_json_value(obj_content, "max_subscribers");
+                    if (value) {
+                        stream->max_subscribers = atoi(value);
+                        free(value);
+                    }
+                    
+                    value = find_json_value(obj_content, "delta_keyframe_interval");
+                    if (value) {
+                        stream->delta_keyframe_interval = atoi(value);
+                        free(value);
+                    }
+                    
+                    value = find_json_value(obj_content, "batch");
+                    if (value) {
+                        char* batch_value = find_json_value(value, "max_events");
+                        if (batch_value) {
+                            stream->batch_max_events = atoi(batch_value);
+                            free(batch_value);
+                        }
+                        batch_value = find_json_value(value, "max_delay_ms");
+                        if (batch_value) {
+                            stream->batch_max_delay_ms = atoi(batch_value);
+                            free(batch_value);
+                        }
+                        free(value);
+                    }
+                    
+                    value = find_json_value(obj_content, "replay");
+                    if (value) {
+                        stream->replay_speed = 1.0;
+                        char* replay_value = find_json_value(value, "file");
+                        if (replay_value) {
+                            strncpy(stream->replay_file, replay_value, sizeof(stream->replay_file) - 1);
+                            stream->replay_file[sizeof(stream->replay_file) - 1] = '\0';
+                            free(replay_value);
+                        }
+                        replay_value = find_json_value(value, "speed");
+                        if (replay_value) {
+                            stream->replay_speed = atof(replay_value);
+                            free(replay_value);
+                        }
+                        replay_value = find_json_value(value, "loop");
+                        if (replay_value) {
+                            stream->replay_loop = (strcmp(replay_value, "true") == 0);
+                            free(replay_value);
+                        }
+                        free(value);
+                    }
+                    
+                    value = find_json_value(obj_content, "capture");
+                    if (value) {
+                        char* capture_value = find_json_value(value, "interface");
+                        if (capture_value) {
+                            strncpy(stream->capture_interface, capture_value, sizeof(stream->capture_interface) - 1);
+                            stream->capture_interface[sizeof(stream->capture_interface) - 1] = '\0';
+                            free(capture_value);
+                        }
+                        capture_value = find_json_value(value, "filter");
+                        if (capture_value) {
+                            strncpy(stream->capture_filter, capture_value, sizeof(stream->capture_filter) - 1);
+                            stream->capture_filter[sizeof(stream->capture_filter) - 1] = '\0';
+                            free(capture_value);
+                        }
+                        free(value);
+                    }
+                    
                     free(obj_content);
                     stream_index++;
                 }
@@ -775,7 +932,20 @@ void print_config(const app_configuration_t* config) {
     if (config->streaming.enabled) {
         printf("\n=== Streaming Configuration ===\n");
         printf("Streaming Server: %s:%d\n", config->streaming.server.host, config->streaming.server.port);
-        printf("Max Connections: %d\n", config->streaming.server.max_connections);
+        printf("Max Connections: %d (per IP: %d, Retry-After: %d s)\n",
+               config->streaming.server.max_connections,
+               config->streaming.server.max_connections_per_ip,
+               config->streaming.server.retry_after_seconds);
+        printf("Event Loops: %d\n", config->streaming.server.event_loops);
+        printf("Reuse Port: %s\n", config->streaming.server.reuse_port ? "Yes" : "No");
+        printf("Zerocopy Threshold: %d bytes\n", config->streaming.server.zerocopy_threshold);
+        printf("Request Timeout: %d ms\n", config->streaming.server.request_timeout_ms);
+        printf("Heartbeat Interval: %d ms\n", config->streaming.server.heartbeat_interval_ms);
+        printf("Reconnect Retry: %d ms\n", config->streaming.server.reconnect_retry_ms);
+        printf("Send Queue Limit: %d frames / %d bytes\n", config->streaming.server.send_queue_max_frames,
+               config->streaming.server.send_queue_max_bytes);
+        printf("Slow Consumer Policy: %s (%d ms)\n", config->streaming.server.slow_consumer_policy,
+               config->streaming.server.slow_consumer_timeout_ms);
         printf("Configured Streams: %d\n", config->streaming.stream_count);
         
         for (int i = 0; i < config->streaming.stream_count; i++) {
@@ -785,7 +955,19 @@ void print_config(const app_configuration_t* config) {
             printf("    Handler: %s\n", stream->handler);
             printf("    Interval: %d ms\n", stream->interval_ms);
             printf("    Enabled: %s\n", stream->enabled ? "Yes" : "No");
+            printf("    Push: %s\n", stream->push ? "Yes" : "No");
             printf("    Description: %s\n", stream->description);
+            printf("    Max Subscribers: %d\n", stream->max_subscribers);
+            printf("    Delta Keyframe Interval: %d\n", stream->delta_keyframe_interval);
+            printf("    Batch: %d events / %d ms\n", stream->batch_max_events, stream->batch_max_delay_ms);
+            if (stream->replay_file[0]) {
+                printf("    Replay: %s (speed %g%s)\n", stream->replay_file, stream->replay_speed,
+                       stream->replay_loop ? ", loop" : "");
+            }
+            if (stream->capture_interface[0]) {
+                printf("    Capture: %s%s\n", stream->capture_interface,
+                       stream->capture_filter[0] ? " (filtered)" : "");
+            }
         }
         printf("===============================\n");
     }
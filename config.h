@@ -118,7 +118,19 @@ typedef struct {
 typedef struct {
     char host[64];                    // Server host (e.g., "127.0.0.1")
     int port;                         // Server port (e.g., 8080)
-    int max_connections;              // Maximum concurrent connections
+    int max_connections;              // Maximum concurrent connections (0 = unlimited)
+    int max_connections_per_ip;       // Maximum concurrent connections per client address (0 = unlimited)
+    int retry_after_seconds;          // Retry-After sent with 503 when a cap is hit
+    int event_loops;                  // Event loop threads (0 = one per CPU)
+    bool reuse_port;                  // One SO_REUSEPORT listener per event loop (Linux)
+    int zerocopy_threshold;           // Send frames of at least this size with MSG_ZEROCOPY (0 = off)
+    int request_timeout_ms;           // Close connections that do not send a request in time
+    int heartbeat_interval_ms;        // Comment line sent to idle streams (0 = off)
+    int reconnect_retry_ms;           // SSE retry: hint, jittered up to +50% per client (0 = none)
+    int send_queue_max_frames;        // Events buffered per connection before the policy applies
+    int send_queue_max_bytes;         // Bytes buffered per connection before the policy applies
+    char slow_consumer_policy[16];    // "drop_oldest", "coalesce" or "disconnect"
+    int slow_consumer_timeout_ms;     // Backlog age that triggers "disconnect"
 } stream_server_config_t;
 
 typedef struct {
@@ -127,7 +139,17 @@ typedef struct {
     char handler[64];                 // Handler function name (e.g., "stream_system_memory")
     int interval_ms;                  // Update interval in milliseconds
     bool enabled;                     // Whether stream is enabled
+    bool push;                        // Fed by streaming_publish; handler and interval_ms are unused
     char description[256];            // Description of the stream
+    int max_subscribers;              // Concurrent subscribers allowed (0 = unlimited)
+    int delta_keyframe_interval;      // Events per full keyframe in delta mode (0 = delta off)
+    int batch_max_events;             // Samples per "batch" event (0 or 1 = batching off)
+    int batch_max_delay_ms;           // Longest a sample waits for its batch (0 = until full)
+    char replay_file[512];            // .pcap/.pcapng replayed into the stream (empty = none)
+    double replay_speed;              // 1 = original timing, N = N times faster, 0 = unpaced
+    bool replay_loop;                 // Start the capture over when it ends
+    char capture_interface[32];       // Live AF_PACKET capture on this interface or "any" (empty = none)
+    char capture_filter[2048];        // Classic BPF as printed by `tcpdump -ddd`, lines joined with commas (empty = everything)
 } stream_function_config_t;
 
 typedef struct {
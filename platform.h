@@ -66,6 +66,18 @@ void platform_handle_menu_action(const char* action);
 // Event loop
 void platform_run_event_loop(void);
 
+// Run task(arg) on the main (UI) thread from any thread. Returns at once; tasks
+// run in the order they were posted. False if the task could not be queued.
+typedef void (*platform_main_thread_task_t)(void* arg);
+bool platform_post_to_main_thread(platform_main_thread_task_t task, void* arg);
+
+#ifndef __APPLE__
+// Headless builds have no UI run loop; whichever thread calls this acts as the
+// main thread. Runs every posted task, waiting up to timeout_ms (-1 = forever)
+// for the first one, and returns how many ran.
+int platform_run_main_thread_tasks(int timeout_ms);
+#endif
+
 // Global configuration
 extern app_configuration_t* app_config;
 
@@ -0,0 +1,194 @@
+#ifndef __APPLE__
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "platform.h"
+#include "config.h"
+
+// Headless platform: no window or webview, just enough of the platform layer
+// to run the bridge and streaming code (and the main-thread hop between them)
+// on systems without a native backend. Scripts that would go to the webview
+// are printed in debug mode.
+
+typedef struct platform_main_task {
+    platform_main_thread_task_t task;
+    void* arg;
+    struct platform_main_task* next;
+} platform_main_task_t;
+
+static const app_configuration_t* stored_config = NULL;
+
+// Tasks posted to the main thread, oldest first
+static pthread_mutex_t g_main_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_main_cond = PTHREAD_COND_INITIALIZER;
+static platform_main_task_t* g_main_head = NULL;
+static platform_main_task_t* g_main_tail = NULL;
+static bool g_main_quit = false;
+
+static bool platform_debug(const app_window_t* window) {
+    const app_configuration_t* config = window && window->config ? window->config : stored_config;
+    return config && config->development.debug_mode;
+}
+
+bool platform_init(const app_configuration_t* app_config) {
+    stored_config = app_config;
+    pthread_mutex_lock(&g_main_mutex);
+    g_main_quit = false;
+    pthread_mutex_unlock(&g_main_mutex);
+    printf("Headless platform initialized (no native window)\n");
+    return true;
+}
+
+void platform_cleanup(void) {
+    pthread_mutex_lock(&g_main_mutex);
+    g_main_quit = true;
+    platform_main_task_t* task = g_main_head;
+    g_main_head = g_main_tail = NULL;
+    pthread_cond_broadcast(&g_main_cond);
+    pthread_mutex_unlock(&g_main_mutex);
+
+    // Tasks that never got to run are dropped with the loop
+    while (task) {
+        platform_main_task_t* next = task->next;
+        free(task);
+        task = next;
+    }
+    stored_config = NULL;
+}
+
+bool platform_create_window(app_window_t* window) {
+    return window != NULL;
+}
+
+void platform_show_window(app_window_t* window) {
+    (void)window;
+}
+
+void platform_hide_window(app_window_t* window) {
+    (void)window;
+}
+
+void platform_close_window(app_window_t* window) {
+    (void)window;
+}
+
+void platform_setup_webview(app_window_t* window) {
+    (void)window;
+}
+
+void platform_webview_load_url(app_window_t* window, const char* url) {
+    if (platform_debug(window)) {
+        printf("Headless: load URL %s\n", url ? url : "(null)");
+    }
+}
+
+void platform_webview_load_html(app_window_t* window, const char* html) {
+    (void)html;
+    if (platform_debug(window)) {
+        printf("Headless: load HTML content\n");
+    }
+}
+
+void platform_webview_evaluate_javascript(app_window_t* window, const char* script) {
+    if (!script) return;
+
+    if (platform_debug(window)) {
+        printf("Evaluating JavaScript: %s\n", script);
+    }
+}
+
+void platform_setup_menubar(app_window_t* window) {
+    (void)window;
+}
+
+void platform_handle_menu_action(const char* action) {
+    printf("Headless: menu action %s\n", action ? action : "(null)");
+}
+
+bool platform_show_alert_with_params(app_window_t* window, const char* title, const char* message, const char* ok_button, const char* cancel_button) {
+    (void)window; (void)ok_button; (void)cancel_button;
+    printf("Alert: %s - %s\n", title ? title : "", message ? message : "");
+    return true;
+}
+
+bool platform_show_alert_direct(app_window_t* window, const char* title, const char* message, const char* ok_button, const char* cancel_button) {
+    return platform_show_alert_with_params(window, title, message, ok_button, cancel_button);
+}
+
+bool platform_post_to_main_thread(platform_main_thread_task_t task, void* arg) {
+    if (!task) return false;
+
+    platform_main_task_t* entry = malloc(sizeof(platform_main_task_t));
+    if (!entry) return false;
+    entry->task = task;
+    entry->arg = arg;
+    entry->next = NULL;
+
+    pthread_mutex_lock(&g_main_mutex);
+    if (g_main_tail) {
+        g_main_tail->next = entry;
+    } else {
+        g_main_head = entry;
+    }
+    g_main_tail = entry;
+    pthread_cond_signal(&g_main_cond);
+    pthread_mutex_unlock(&g_main_mutex);
+    return true;
+}
+
+int platform_run_main_thread_tasks(int timeout_ms) {
+    pthread_mutex_lock(&g_main_mutex);
+    if (timeout_ms < 0) {
+        while (!g_main_head && !g_main_quit) {
+            pthread_cond_wait(&g_main_cond, &g_main_mutex);
+        }
+    } else if (timeout_ms > 0 && !g_main_head) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!g_main_head && !g_main_quit) {
+            if (pthread_cond_timedwait(&g_main_cond, &g_main_mutex, &deadline) == ETIMEDOUT) break;
+        }
+    }
+
+    // Take everything queued so far; tasks posted while these run wait for the next call
+    platform_main_task_t* task = g_main_head;
+    g_main_head = g_main_tail = NULL;
+    pthread_mutex_unlock(&g_main_mutex);
+
+    int ran = 0;
+    while (task) {
+        platform_main_task_t* next = task->next;
+        task->task(task->arg);
+        free(task);
+        task = next;
+        ran++;
+    }
+    return ran;
+}
+
+void platform_run_event_loop(void) {
+    // Serve main-thread tasks until platform_cleanup
+    for (;;) {
+        pthread_mutex_lock(&g_main_mutex);
+        bool quit = g_main_quit;
+        pthread_mutex_unlock(&g_main_mutex);
+        if (quit) break;
+        platform_run_main_thread_tasks(-1);
+    }
+}
+
+#endif // !__APPLE__
@@ -4,6 +4,7 @@
 #include <objc/message.h>
 #include <objc/runtime.h>
 #include <CoreGraphics/CoreGraphics.h>
+#include <dispatch/dispatch.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -1033,6 +1034,14 @@ void platform_run_event_loop(void) {
     ((void (*)(id, SEL))objc_msgSend)(g_app, sel_registerName("run"));
 }
 
+bool platform_post_to_main_thread(platform_main_thread_task_t task, void* arg) {
+    if (!task) return false;
+    
+    // The main queue is drained by the NSApplication run loop
+    dispatch_async_f(dispatch_get_main_queue(), arg, task);
+    return true;
+}
+
 // ============================================================================
 // SCRIPT MESSAGE HANDLER IMPLEMENTATION
 // ============================================================================
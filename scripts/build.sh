@@ -15,7 +15,7 @@ cd "$(dirname "$0")/.." || exit 1
 CC="gcc"
 CFLAGS="-Wall -Wextra -std=c99"
 PLATFORM_FLAGS="-DPLATFORM_MACOS -framework Cocoa -framework Foundation -framework WebKit"
-SRCS="main.c config.c webview_framework.c platform_macos.c bridge.c bridge_builtin.c bridge_custom.c streaming.c streaming_builtin.c streaming_custom.c"
+SRCS="main.c config.c webview_framework.c platform_macos.c platform_headless.c bridge.c bridge_json.c bridge_builtin.c bridge_custom.c streaming.c streaming_poll.c streaming_timer.c streaming_frame.c streaming_http.c streaming_router.c streaming_epoch.c streaming_delta.c streaming_ws.c streaming_msgpack.c streaming_buffer.c streaming_mpsc.c streaming_pcap.c streaming_replay.c streaming_capture.c streaming_builtin.c streaming_custom.c"
 OUTPUT_DIR="output"
 TARGET="$OUTPUT_DIR/desktop_app"
 
@@ -1,36 +1,271 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include "streaming.h"
 #include "bridge.h"
+#include "streaming_router.h"
+#include "streaming_delta.h"
+#include "streaming_ws.h"
+#include "streaming_msgpack.h"
+#include "streaming_replay.h"
+#include "streaming_capture.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 #include <pthread.h>
+#include <sys/uio.h>
 
-#ifdef __APPLE__
-#include <sys/sysctl.h>
-#include <mach/mach.h>
-#include <mach/vm_statistics.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
 #endif
 
 #define MAX_STREAM_FUNCTIONS 32
+#define LEGACY_HANDLER_BUFFER_SIZE 1024           // What stream_handler_t handlers have always been given
 #define BUFFER_SIZE 4096
+#define MAX_POLL_EVENTS 128
+#define MAX_SEND_IOV 64
+#define ACCEPT_RETRY_MS 100
+#define IP_TABLE_BUCKETS 256
+#define REJECT_LOG_INTERVAL_MS 1000
+#define CONNECTION_POOL_MAX 64
+#define RECLAIM_RETRY_MS 1
+#define MAX_SUBSCRIPTION_INTERVAL_MS 3600000
+#define MAX_SUBSCRIPTION_RATE 1000
+#define MULTI_STREAM_ENDPOINT "/stream/multi"
+#define WS_REPLY_SIZE 512
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define STREAM_HAVE_ZEROCOPY 1
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define STREAM_SEND_FLAGS 0
+#endif
+
+// Cross-thread task posted to an event loop
+typedef struct stream_task {
+    void (*run)(struct stream_loop* loop, void* arg);
+    void* arg;
+    struct stream_task* next;
+} stream_task_t;
+
+// Frame hand-off to a loop that has subscribers for the stream
+typedef struct {
+    stream_function_entry_t* stream;
+    stream_frame_t* frame;
+    stream_frame_t* patch;            // Same sample as a delta patch (NULL on keyframes)
+    stream_frame_t* ws_frame;         // Same sample as a binary WebSocket message (NULL if unused)
+    stream_frame_t* tagged;           // Same sample with the stream name as event (NULL if unused)
+} stream_delivery_t;
+
+// Options a subscriber passes in the query string
+typedef struct {
+    uint64_t min_interval_ms;
+    bool delta;
+    bool websocket;
+    bool tagged;
+    bool resume;                      // Replay what followed last_event_id
+    uint64_t last_event_id;
+} stream_subscribe_options_t;
+
+// Socket accepted by one loop for another to adopt
+typedef struct {
+    int socket;
+    struct sockaddr_in addr;
+} stream_accepted_t;
+
+// Open connections from one client address (per-IP admission control)
+typedef struct stream_ip_count {
+    uint32_t addr;
+    int count;
+    struct stream_ip_count* next;
+} stream_ip_count_t;
+
+// Frame sent with MSG_ZEROCOPY, held until the kernel reports completion
+typedef struct stream_zerocopy_pending {
+    stream_frame_t* frame;
+    uint32_t seq;
+    struct stream_zerocopy_pending* next;
+} stream_zerocopy_pending_t;
+
+// Send queue counters; written by the owning loop, read by streaming_get_stats
+typedef struct {
+    uint64_t connections_accepted;
+    uint64_t queued_frames;
+    uint64_t queued_bytes;
+    uint64_t queue_high_water;
+    uint64_t frames_sent;
+    uint64_t frames_dropped;
+    uint64_t frames_coalesced;
+    uint64_t slow_disconnects;
+    uint64_t rejected_connections;
+    uint64_t rejected_subscriptions;
+} stream_loop_stats_t;
+
+// Event loop: owns a poller, a timer queue and a set of connections
+typedef struct stream_loop {
+    int index;
+    pthread_t thread;
+    bool thread_started;
+    streaming_server_t* server;
+    stream_poller_t poller;
+    int wake_fds[2];                  // Self-pipe used to interrupt the poller
+    int listen_fd;                    // Listening socket (-1 if this loop does not accept)
+    bool owns_listener;               // listen_fd is this loop's SO_REUSEPORT socket
+    stream_timer_t accept_retry_timer;// Re-polls the listener after fd exhaustion
+    stream_timer_queue_t timers;
+    pthread_mutex_t inbox_mutex;
+    stream_task_t* inbox_head;
+    stream_task_t* inbox_tail;
+    stream_connection_t* connections; // Registry shard (head published with release stores)
+    stream_connection_t* closed;      // Unlinked, waiting for registry walkers to leave
+    stream_connection_t* pool;        // Reclaimed connections kept for reuse
+    int pool_count;
+    int connection_count;             // Atomic (read by streaming_get_stats)
+    unsigned int next_target;         // Round-robin cursor for accepted sockets
+    uint64_t last_reject_log_ms;      // Rate limit for overload messages
+    uint32_t retry_jitter;            // xorshift32 state spreading SSE retry: hints
+    stream_subscription_t* subscribers[MAX_STREAM_FUNCTIONS]; // Per-stream, loop-local
+    stream_loop_stats_t stats;
+} stream_loop_t;
+
+// Sample handed to streaming_publish, queued for the stream's owner loop
+typedef struct {
+    stream_mpsc_node_t node;          // First member: the queue hands this back
+    size_t length;
+    char payload[];                   // NUL-terminated
+} stream_published_t;
 
 // Global streaming state
 static streaming_server_t* g_streaming_server = NULL;
+static stream_frame_t* g_heartbeat_frame = NULL;
+static stream_frame_t* g_ws_ping_frame = NULL;     // Heartbeat for upgraded connections
 static stream_function_entry_t g_stream_functions[MAX_STREAM_FUNCTIONS];
 static int g_stream_function_count = 0;
 static pthread_mutex_t g_functions_mutex = PTHREAD_MUTEX_INITIALIZER;
+static stream_route_table_t g_endpoint_routes;  // Endpoint path -> registry index
+static stream_route_table_t g_name_routes;      // Stream name -> registry index
+static stream_ip_count_t* g_ip_counts[IP_TABLE_BUCKETS];
+static pthread_mutex_t g_ip_counts_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Forward declarations
-static void* server_thread_func(void* arg);
-static void* connection_thread_func(void* arg);
-static void handle_http_request(int client_socket, const char* request);
-static stream_function_entry_t* find_stream_function(const char* endpoint);
+static int create_listen_socket(streaming_server_t* server, bool reuse_port);
+static bool resolve_reuse_port(const streaming_config_t* config);
+static int resolve_loop_count(const streaming_config_t* config);
+static bool loop_open(stream_loop_t* loop, streaming_server_t* server, int index);
+static void loop_close(stream_loop_t* loop);
+static void* loop_thread_func(void* arg);
+static void loop_wake(stream_loop_t* loop);
+static void loop_post(stream_loop_t* loop, void (*run)(stream_loop_t*, void*), void* arg);
+static void loop_run_inbox(stream_loop_t* loop);
+static void loop_accept(stream_loop_t* loop);
+static void loop_accept_retry(stream_timer_t* timer, void* user_data);
+static void loop_adopt_connection(stream_loop_t* loop, int client_socket, const struct sockaddr_in* addr);
+static void loop_adopt_task(stream_loop_t* loop, void* arg);
+static stream_connection_t* loop_alloc_connection(stream_loop_t* loop);
+static void loop_recycle_connection(stream_loop_t* loop, stream_connection_t* conn);
+static bool loop_reclaim(stream_loop_t* loop);
+static void loop_collect_stats(stream_loop_t* loop, streaming_stats_t* stats);
+static bool admission_acquire(stream_loop_t* loop, uint32_t addr);
+static void admission_release(streaming_server_t* server, uint32_t addr);
+static bool ip_count_acquire(uint32_t addr, int limit);
+static void ip_count_release(uint32_t addr);
+static void reject_connection(streaming_server_t* server, int client_socket);
+static void connection_close(stream_connection_t* conn);
+static void connection_on_event(stream_connection_t* conn, uint32_t events);
+static void connection_on_readable(stream_connection_t* conn);
+static void connection_process_requests(stream_connection_t* conn);
+static void connection_process_ws(stream_connection_t* conn);
+static void connection_ws_frame(stream_connection_t* conn, const stream_ws_frame_t* frame, const char* payload);
+static void connection_ws_message(stream_connection_t* conn, const char* text, size_t length);
+static void connection_ws_send(stream_connection_t* conn, stream_ws_opcode_t opcode,
+                               const char* payload, size_t length);
+static void connection_ws_reply(stream_connection_t* conn, const char* type, const char* stream,
+                                const char* message);
+static void connection_ws_close(stream_connection_t* conn, int code);
+static bool connection_flush(stream_connection_t* conn);
+static void connection_enqueue(stream_connection_t* conn, stream_frame_t* frame, int stream);
+static void connection_dequeue(stream_connection_t* conn, size_t position);
+static bool connection_coalesce(stream_connection_t* conn, stream_frame_t* frame, int stream);
+static bool connection_drop_oldest(stream_connection_t* conn);
+static bool connection_check_backlog(stream_connection_t* conn, uint64_t now);
+static void connection_write(stream_connection_t* conn, const char* data, size_t length);
+static void connection_release_frames(stream_connection_t* conn);
+static void connection_zerocopy_retire(stream_connection_t* conn, stream_frame_t* frame, uint32_t seq);
+static void connection_zerocopy_reap(stream_connection_t* conn);
+static void connection_respond(stream_connection_t* conn, const char* status,
+                               const char* content_type, const char* body);
+static void connection_respond_headers(stream_connection_t* conn, const char* status,
+                                       const char* content_type, const char* extra_headers,
+                                       const char* body);
+static void connection_respond_busy(stream_connection_t* conn, const char* body);
+static void connection_send_frame(stream_connection_t* conn, stream_frame_t* frame, int stream);
+static void connection_idle_check(stream_timer_t* timer, void* user_data);
+static void connection_start_heartbeat(stream_connection_t* conn);
+static int stream_reserve_subscriber(stream_function_entry_t* stream);
+static void stream_release_subscriber(stream_function_entry_t* stream);
+static bool connection_subscribe(stream_connection_t* conn, stream_function_entry_t* stream, int previous,
+                                 const stream_subscribe_options_t* options);
+static size_t stream_collect_catch_up(stream_function_entry_t* stream, const stream_subscribe_options_t* options,
+                                      bool first, stream_frame_t** frames);
+static bool parse_subscription_rate(const stream_http_view_t* interval_ms, const stream_http_view_t* max_rate,
+                                    uint64_t* min_interval_ms);
+static bool parse_subscribe_options(stream_http_view_t query, const stream_function_entry_t* stream,
+                                    stream_subscribe_options_t* options);
+static void connection_unsubscribe(stream_connection_t* conn, stream_function_entry_t* stream);
+static void connection_unsubscribe_all(stream_connection_t* conn);
+static void subscription_detach(stream_loop_t* loop, stream_subscription_t* sub);
+static stream_frame_t* subscription_render(const stream_subscription_t* sub, stream_frame_t* frame);
+static stream_loop_t* stream_owner_loop(const stream_function_entry_t* stream);
+static void stream_reset_producers(void);
+static void stream_producer_start(stream_loop_t* loop, void* arg);
+static void stream_producer_tick(stream_timer_t* timer, void* user_data);
+static void stream_producer_emit(stream_function_entry_t* stream, const char* event_name,
+                                 const char* data, size_t data_length);
+static void register_stream_entry(const char* name, const char* endpoint, int interval_ms,
+                                  stream_handler_t handler, stream_writer_t writer,
+                                  const char* description);
+static void stream_drain_published(stream_loop_t* loop, void* arg);
+static void stream_discard_published(stream_function_entry_t* stream);
+static void stream_deliver(stream_loop_t* loop, void* arg);
+static int loop_retry_hint(stream_loop_t* loop);
+static stream_frame_t* render_ws_event(const stream_function_entry_t* stream, uint64_t id,
+                                       const char* data, size_t length);
+static void handle_http_request(stream_connection_t* conn, const stream_http_request_t* request);
+static void handle_ws_upgrade(stream_connection_t* conn, const stream_http_request_t* request);
+static void handle_multi_subscribe(stream_connection_t* conn, const stream_http_request_t* request);
+static void connection_start_event_stream(stream_connection_t* conn);
+static void respond_stats(stream_connection_t* conn);
+static void respond_connection_list(stream_connection_t* conn);
+static void respond_stream_list(stream_connection_t* conn);
+static void respond_stream_snapshot(stream_connection_t* conn, stream_http_view_t name);
+static stream_function_entry_t* find_stream_function(stream_http_view_t endpoint);
+static stream_function_entry_t* find_stream_by_name(stream_http_view_t name);
+static size_t json_append_string(char* out, size_t size, size_t length, const char* text);
+static stream_slow_consumer_policy_t resolve_slow_consumer_policy(const char* name);
+
+static bool server_is_running(const streaming_server_t* server) {
+    return __atomic_load_n(&server->running, __ATOMIC_ACQUIRE);
+}
+
+static void stats_add(uint64_t* counter, uint64_t amount) {
+    __atomic_add_fetch(counter, amount, __ATOMIC_RELAXED);
+}
+
+static void stats_sub(uint64_t* counter, uint64_t amount) {
+    __atomic_sub_fetch(counter, amount, __ATOMIC_RELAXED);
+}
 
 // Initialize streaming system
 bool streaming_init(const streaming_config_t* config, app_window_t* window) {
@@ -55,24 +290,18 @@ bool streaming_init(const streaming_config_t* config, app_window_t* window) {
     g_streaming_server->window = window;
     g_streaming_server->server_socket = -1;
     g_streaming_server->running = false;
-    g_streaming_server->connections = NULL;
+    g_streaming_server->loops = NULL;
+    g_streaming_server->loop_count = 0;
     g_streaming_server->connection_count = 0;
     g_streaming_server->max_connections = config->server.max_connections;
-
-    // Initialize the connections mutex
-    if (pthread_mutex_init(&g_streaming_server->connections_mutex, NULL) != 0) {
-        printf("Streaming init failed: Mutex initialization failed\n");
-        free(g_streaming_server);
-        g_streaming_server = NULL;
-        return false;
-    }
+    stream_epoch_init(&g_streaming_server->registry_epoch);
 
     // Register built-in stream handlers
     streaming_register_builtin_handlers();
-    
+
     // Register custom handlers (user-provided)
     streaming_register_custom_handlers();
-    
+
     // Register streams from configuration (this reads handlers from the registry)
     streaming_register_config_streams(config);
 
@@ -83,25 +312,41 @@ bool streaming_init(const streaming_config_t* config, app_window_t* window) {
 // Cleanup streaming system
 void streaming_cleanup(void) {
     if (!g_streaming_server) return;
-    
+
     printf("Cleaning up streaming system...\n");
-    
+
     // Stop server
     streaming_stop_server();
-    
+    stream_replay_cleanup();
+    stream_capture_cleanup();
+
     // Cleanup connections
     streaming_cleanup_connections();
-    
-    // Destroy mutex
-    pthread_mutex_destroy(&g_streaming_server->connections_mutex);
-    
+
     // Free server structure
     free(g_streaming_server);
     g_streaming_server = NULL;
-    
+
     // Clear stream functions
+    for (int i = 0; i < g_stream_function_count; i++) {
+        stream_frame_release(g_stream_functions[i].latest);
+        g_stream_functions[i].latest = NULL;
+        for (int slot = 0; slot < STREAM_REPLAY_RING_SIZE; slot++) {
+            stream_frame_release(g_stream_functions[i].replay[slot]);
+            g_stream_functions[i].replay[slot] = NULL;
+        }
+        stream_buffer_free(&g_stream_functions[i].output);
+        stream_buffer_free(&g_stream_functions[i].patch);
+        stream_discard_published(&g_stream_functions[i]);
+        free(g_stream_functions[i].batch_buffer);
+        g_stream_functions[i].batch_buffer = NULL;
+        g_stream_functions[i].batch_capacity = 0;
+        pthread_mutex_destroy(&g_stream_functions[i].latest_mutex);
+    }
     g_stream_function_count = 0;
-    
+    stream_route_table_init(&g_endpoint_routes);
+    stream_route_table_init(&g_name_routes);
+
     printf("Streaming system cleaned up\n");
 }
 
@@ -117,371 +362,2833 @@ bool streaming_start_server(void) {
         return true;
     }
 
+    streaming_server_t* server = g_streaming_server;
     printf("Starting streaming server on %s:%d...\n",
-           g_streaming_server->config->server.host, g_streaming_server->config->server.port);
+           server->config->server.host, server->config->server.port);
+
+    // Bind before spawning loops so configuration errors are reported here
+    server->reuse_port = resolve_reuse_port(server->config);
+    server->server_socket = create_listen_socket(server, server->reuse_port);
+    if (server->server_socket < 0) {
+        return false;
+    }
 
-    // Create server thread
-    if (pthread_create(&g_streaming_server->server_thread, NULL, server_thread_func, g_streaming_server) != 0) {
-        printf("Failed to create streaming server thread\n");
+    int loop_count = resolve_loop_count(server->config);
+    server->loops = calloc((size_t)loop_count, sizeof(stream_loop_t));
+    if (!server->loops) {
+        printf("Failed to allocate event loops\n");
+        close(server->server_socket);
+        server->server_socket = -1;
         return false;
     }
 
-    g_streaming_server->running = true;
-    printf("Streaming server started successfully!\n");
+    for (int i = 0; i < loop_count; i++) {
+        if (!loop_open(&server->loops[i], server, i)) {
+            for (int j = 0; j < i; j++) loop_close(&server->loops[j]);
+            free(server->loops);
+            server->loops = NULL;
+            close(server->server_socket);
+            server->server_socket = -1;
+            return false;
+        }
+    }
+    server->loop_count = loop_count;
+    server->slow_consumer_policy = resolve_slow_consumer_policy(server->config->server.slow_consumer_policy);
+    stream_reset_producers();
+
+    // SSE comment line sent to otherwise idle subscribers
+    g_heartbeat_frame = stream_frame_create_raw(": heartbeat\n\n", 13);
+    g_ws_ping_frame = stream_frame_create_raw("\x89\x00", 2);
+
+    // Loop 0 owns the listening socket; without reuse_port it hands connections
+    // out round-robin, with it every loop binds its own socket and the kernel
+    // spreads incoming connections across them
+    server->loops[0].listen_fd = server->server_socket;
+    for (int i = 1; i < loop_count && server->reuse_port; i++) {
+        server->loops[i].listen_fd = create_listen_socket(server, true);
+        if (server->loops[i].listen_fd < 0) {
+            streaming_stop_server();
+            return false;
+        }
+        server->loops[i].owns_listener = true;
+    }
+    for (int i = 0; i < loop_count; i++) {
+        stream_loop_t* loop = &server->loops[i];
+        if (loop->listen_fd >= 0 &&
+            !stream_poller_add(&loop->poller, loop->listen_fd, STREAM_POLL_READ, &loop->listen_fd)) {
+            streaming_stop_server();
+            return false;
+        }
+    }
+
+    __atomic_store_n(&server->running, true, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < loop_count; i++) {
+        stream_loop_t* loop = &server->loops[i];
+        if (pthread_create(&loop->thread, NULL, loop_thread_func, loop) != 0) {
+            printf("Failed to create streaming event loop thread %d\n", i);
+            streaming_stop_server();
+            return false;
+        }
+        loop->thread_started = true;
+    }
+
+    // Capture sources publish into loops that are now running
+    stream_replay_start_all();
+    stream_capture_start_all();
+
+    printf("Streaming server started successfully with %d event loop(s)%s!\n", loop_count,
+           server->reuse_port ? " sharing the port" : "");
     return true;
 }
 
 // Stop streaming server
 void streaming_stop_server(void) {
-    if (!g_streaming_server || !g_streaming_server->running) {
+    // Sources stop publishing before the loops they publish into go away
+    stream_replay_stop_all();
+    stream_capture_stop_all();
+
+    if (!g_streaming_server || !g_streaming_server->loops) {
         return;
     }
-    
+
     printf("Stopping streaming server...\n");
-    
-    // Set running flag to false
-    g_streaming_server->running = false;
-    
+
+    streaming_server_t* server = g_streaming_server;
+
+    // Set running flag to false and interrupt every loop
+    __atomic_store_n(&server->running, false, __ATOMIC_RELEASE);
+    for (int i = 0; i < server->loop_count; i++) {
+        loop_wake(&server->loops[i]);
+    }
+
+    // Wait for loop threads; each closes the connections it owns on exit
+    for (int i = 0; i < server->loop_count; i++) {
+        if (server->loops[i].thread_started) {
+            pthread_join(server->loops[i].thread, NULL);
+        }
+    }
+    for (int i = 0; i < server->loop_count; i++) {
+        loop_close(&server->loops[i]);
+    }
+    free(server->loops);
+    server->loops = NULL;
+    server->loop_count = 0;
+    stream_frame_release(g_heartbeat_frame);
+    g_heartbeat_frame = NULL;
+    stream_frame_release(g_ws_ping_frame);
+    g_ws_ping_frame = NULL;
+
     // Close server socket
-    if (g_streaming_server->server_socket >= 0) {
-        close(g_streaming_server->server_socket);
-        g_streaming_server->server_socket = -1;
-    }
-    
-    // Wait for server thread to finish
-    pthread_join(g_streaming_server->server_thread, NULL);
-    
+    if (server->server_socket >= 0) {
+        close(server->server_socket);
+        server->server_socket = -1;
+    }
+
     // Cleanup all connections
     streaming_cleanup_connections();
-    
+
     printf("Streaming server stopped\n");
 }
 
-// Server thread function
-static void* server_thread_func(void* arg) {
-    streaming_server_t* server = (streaming_server_t*)arg;
-    
-    printf("Server thread started\n");
-    
-    // Create socket
-    server->server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server->server_socket < 0) {
+// Create, bind and listen on a server socket
+static int create_listen_socket(streaming_server_t* server, bool reuse_port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
         printf("Failed to create server socket: %s\n", strerror(errno));
-        return NULL;
+        return -1;
     }
 
     // Set socket options
     int opt = 1;
-    if (setsockopt(server->server_socket, SOL_SOCKET, SO_REUSEADDR, 
-                   &opt, sizeof(opt)) < 0) {
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
         printf("Failed to set socket options: %s\n", strerror(errno));
-        close(server->server_socket);
-        return NULL;
+        close(fd);
+        return -1;
+    }
+
+#ifdef SO_REUSEPORT
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        printf("Failed to set SO_REUSEPORT: %s\n", strerror(errno));
+        close(fd);
+        return -1;
     }
-    
+#else
+    (void)reuse_port;
+#endif
+
     // Bind socket
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = inet_addr(server->config->server.host);
     server_addr.sin_port = htons(server->config->server.port);
-    
-    if (bind(server->server_socket, (struct sockaddr*)&server_addr, 
-             sizeof(server_addr)) < 0) {
+
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         printf("Failed to bind server socket: %s\n", strerror(errno));
-        close(server->server_socket);
-        return NULL;
+        close(fd);
+        return -1;
     }
-    
+
     // Listen for connections
-    if (listen(server->server_socket, server->config->server.max_connections) < 0) {
+    if (listen(fd, server->config->server.max_connections) < 0) {
         printf("Failed to listen on server socket: %s\n", strerror(errno));
-        close(server->server_socket);
-        return NULL;
+        close(fd);
+        return -1;
+    }
+
+    if (!stream_set_nonblocking(fd)) {
+        printf("Failed to make server socket non-blocking: %s\n", strerror(errno));
+        close(fd);
+        return -1;
     }
 
     printf("Server listening on %s:%d\n", server->config->server.host, server->config->server.port);
-    
-    while (server->running) {
+    return fd;
+}
+
+// Whether every loop can get its own listener; only Linux balances SO_REUSEPORT groups
+static bool resolve_reuse_port(const streaming_config_t* config) {
+    if (!config->server.reuse_port) return false;
+#if defined(__linux__) && defined(SO_REUSEPORT)
+    return true;
+#else
+    printf("reuse_port is not supported on this platform; using a single acceptor\n");
+    return false;
+#endif
+}
+
+// Number of event loops to run (0 in config means one per online CPU)
+static int resolve_loop_count(const streaming_config_t* config) {
+    int count = config->server.event_loops;
+    if (count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        count = cpus > 0 ? (int)cpus : 1;
+    }
+    if (count > STREAM_MAX_LOOPS) count = STREAM_MAX_LOOPS;
+    return count;
+}
+
+// Allocate the kernel resources of one event loop
+static bool loop_open(stream_loop_t* loop, streaming_server_t* server, int index) {
+    memset(loop, 0, sizeof(*loop));
+    pthread_mutex_init(&loop->inbox_mutex, NULL);
+    loop->index = index;
+    loop->server = server;
+    loop->listen_fd = -1;
+    loop->retry_jitter = (uint32_t)stream_now_ms() * 2654435761u + (uint32_t)index + 1;
+    if (loop->retry_jitter == 0) loop->retry_jitter = 1;
+    loop->wake_fds[0] = -1;
+    loop->wake_fds[1] = -1;
+    stream_timer_queue_init(&loop->timers, stream_now_ms());
+    stream_timer_init(&loop->accept_retry_timer, loop_accept_retry, loop);
+
+    if (!stream_poller_open(&loop->poller)) {
+        return false;
+    }
+
+    if (pipe(loop->wake_fds) != 0 ||
+        !stream_set_nonblocking(loop->wake_fds[0]) ||
+        !stream_set_nonblocking(loop->wake_fds[1])) {
+        printf("Failed to create event loop wakeup pipe: %s\n", strerror(errno));
+        loop_close(loop);
+        return false;
+    }
+
+    if (!stream_poller_add(&loop->poller, loop->wake_fds[0], STREAM_POLL_READ, &loop->wake_fds[0])) {
+        loop_close(loop);
+        return false;
+    }
+
+    return true;
+}
+
+// Release the kernel resources of one event loop
+static void loop_close(stream_loop_t* loop) {
+    // Drop tasks that were never run (adopted sockets are closed here)
+    loop_run_inbox(loop);
+
+    if (loop->owns_listener && loop->listen_fd >= 0) close(loop->listen_fd);
+    loop->listen_fd = -1;
+    loop->owns_listener = false;
+    if (loop->wake_fds[0] >= 0) close(loop->wake_fds[0]);
+    if (loop->wake_fds[1] >= 0) close(loop->wake_fds[1]);
+    loop->wake_fds[0] = -1;
+    loop->wake_fds[1] = -1;
+    stream_poller_close(&loop->poller);
+    pthread_mutex_destroy(&loop->inbox_mutex);
+}
+
+// Interrupt a loop blocked in the poller
+static void loop_wake(stream_loop_t* loop) {
+    char byte = 1;
+    // A full pipe already guarantees a pending wakeup
+    ssize_t written = write(loop->wake_fds[1], &byte, 1);
+    (void)written;
+}
+
+// Post a task to run on the given loop's thread
+static void loop_post(stream_loop_t* loop, void (*run)(stream_loop_t*, void*), void* arg) {
+    stream_task_t* task = malloc(sizeof(stream_task_t));
+    if (!task) {
+        printf("Failed to allocate event loop task\n");
+        run(NULL, arg);
+        return;
+    }
+    task->run = run;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&loop->inbox_mutex);
+    if (loop->inbox_tail) {
+        loop->inbox_tail->next = task;
+    } else {
+        loop->inbox_head = task;
+    }
+    loop->inbox_tail = task;
+    pthread_mutex_unlock(&loop->inbox_mutex);
+
+    loop_wake(loop);
+}
+
+// Run every task posted to this loop (tasks see loop == NULL during shutdown)
+static void loop_run_inbox(stream_loop_t* loop) {
+    pthread_mutex_lock(&loop->inbox_mutex);
+    stream_task_t* task = loop->inbox_head;
+    loop->inbox_head = NULL;
+    loop->inbox_tail = NULL;
+    pthread_mutex_unlock(&loop->inbox_mutex);
+
+    bool running = server_is_running(loop->server);
+    while (task) {
+        stream_task_t* next = task->next;
+        task->run(running ? loop : NULL, task->arg);
+        free(task);
+        task = next;
+    }
+}
+
+// Event loop thread
+static void* loop_thread_func(void* arg) {
+    stream_loop_t* loop = (stream_loop_t*)arg;
+    stream_poll_event_t events[MAX_POLL_EVENTS];
+
+    printf("Streaming event loop %d started\n", loop->index);
+
+    while (server_is_running(loop->server)) {
+        int timeout = stream_timer_next_timeout(&loop->timers, stream_now_ms());
+        // Closed connections still held by a registry walker are retried shortly
+        if (loop->closed && (timeout < 0 || timeout > RECLAIM_RETRY_MS)) {
+            timeout = RECLAIM_RETRY_MS;
+        }
+        int count = stream_poller_wait(&loop->poller, events, MAX_POLL_EVENTS, timeout);
+        if (count < 0) {
+            printf("Event loop %d poll failed: %s\n", loop->index, strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* data = events[i].data;
+            if (data == &loop->wake_fds[0]) {
+                char drain[64];
+                while (read(loop->wake_fds[0], drain, sizeof(drain)) > 0) {
+                }
+            } else if (data == &loop->listen_fd) {
+                loop_accept(loop);
+            } else {
+                connection_on_event((stream_connection_t*)data, events[i].events);
+            }
+        }
+
+        loop_run_inbox(loop);
+        stream_timer_run_expired(&loop->timers, stream_now_ms());
+
+        // Recycle connections closed during this iteration
+        loop_reclaim(loop);
+    }
+
+    // Close everything this loop owns, then wait out any registry walker
+    while (loop->connections) {
+        connection_close(loop->connections);
+    }
+    while (!loop_reclaim(loop)) {
+        usleep(RECLAIM_RETRY_MS * 1000);
+    }
+    while (loop->pool) {
+        stream_connection_t* conn = loop->pool;
+        loop->pool = conn->retire_next;
+        free(conn->send_queue);
+        free(conn);
+    }
+    loop->pool_count = 0;
+
+    printf("Streaming event loop %d stopped\n", loop->index);
+    return NULL;
+}
+
+// Accept every pending connection (edge-triggered listener)
+static void loop_accept(stream_loop_t* loop) {
+    streaming_server_t* server = loop->server;
+
+    while (true) {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
-        
-        // Accept client connection
-        int client_socket = accept(server->server_socket, 
-                                  (struct sockaddr*)&client_addr, &client_len);
-        
+
+#ifdef __linux__
+        int client_socket = accept4(loop->listen_fd, (struct sockaddr*)&client_addr,
+                                    &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        int client_socket = accept(loop->listen_fd, (struct sockaddr*)&client_addr, &client_len);
+        if (client_socket >= 0 && !stream_set_nonblocking(client_socket)) {
+            close(client_socket);
+            continue;
+        }
+#endif
         if (client_socket < 0) {
-            if (server->running) {
+            if (errno == EINTR) continue;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // The edge will not fire again for sockets already queued; poll again shortly
+                printf("Failed to accept client connection: %s (retrying in %d ms)\n",
+                       strerror(errno), ACCEPT_RETRY_MS);
+                stream_timer_schedule(&loop->timers, &loop->accept_retry_timer,
+                                      stream_now_ms() + ACCEPT_RETRY_MS);
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
                 printf("Failed to accept client connection: %s\n", strerror(errno));
             }
+            return;
+        }
+
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(client_socket, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        // Admission control runs before any allocation so overload stays cheap
+        uint32_t addr = client_addr.sin_addr.s_addr;
+        if (!admission_acquire(loop, addr)) {
+            reject_connection(server, client_socket);
             continue;
         }
-        
-        printf("Client connected from %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-        
-        // Create connection structure
-        stream_connection_t* conn = malloc(sizeof(stream_connection_t));
-        if (!conn) {
-            printf("Failed to allocate connection structure\n");
-            close(client_socket);
+
+        // Sharded listeners keep what they accept; otherwise hand out round-robin.
+        // The adopting loop allocates the connection from its own pool.
+        stream_loop_t* target = server->reuse_port
+            ? loop
+            : &server->loops[loop->next_target++ % (unsigned int)server->loop_count];
+        if (target == loop) {
+            loop_adopt_connection(loop, client_socket, &client_addr);
             continue;
         }
-        
-        conn->socket = client_socket;
-        conn->active = true;
-        conn->next = NULL;
-        
-        // Get client IP and port
-        inet_ntop(AF_INET, &client_addr.sin_addr, conn->client_ip, sizeof(conn->client_ip));
-        conn->client_port = ntohs(client_addr.sin_port);
-
-        // Add to connections list
-        streaming_add_connection(conn);
-        
-        // Create thread to handle this connection
-        if (pthread_create(&conn->thread, NULL, connection_thread_func, conn) != 0) {
-            printf("Failed to create connection thread\n");
-            streaming_remove_connection(conn);
+
+        stream_accepted_t* accepted = malloc(sizeof(stream_accepted_t));
+        if (!accepted) {
+            printf("Failed to allocate accepted socket hand-off\n");
+            admission_release(server, addr);
             close(client_socket);
-            free(conn);
+            continue;
         }
+        accepted->socket = client_socket;
+        accepted->addr = client_addr;
+        loop_post(target, loop_adopt_task, accepted);
     }
-    
-    printf("Server thread stopping\n");
-    return NULL;
 }
 
-// Connection thread function
-static void* connection_thread_func(void* arg) {
-    stream_connection_t* conn = (stream_connection_t*)arg;
-    char buffer[BUFFER_SIZE];
-    
-    // Read HTTP request
-    ssize_t bytes_read = recv(conn->socket, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_read > 0) {
-        buffer[bytes_read] = '\0';
-        handle_http_request(conn->socket, buffer);
+// Retry accepting after a resource exhaustion error
+static void loop_accept_retry(stream_timer_t* timer, void* user_data) {
+    (void)timer;
+    loop_accept((stream_loop_t*)user_data);
+}
+
+// Adopt a socket accepted by another loop
+static void loop_adopt_task(stream_loop_t* loop, void* arg) {
+    stream_accepted_t* accepted = (stream_accepted_t*)arg;
+
+    if (loop) {
+        loop_adopt_connection(loop, accepted->socket, &accepted->addr);
+    } else {
+        admission_release(g_streaming_server, accepted->addr.sin_addr.s_addr);
+        close(accepted->socket);
     }
-    
-    // Connection cleanup will be handled by the main cleanup function
-    return NULL;
+    free(accepted);
 }
 
-// Handle HTTP request
-static void handle_http_request(int client_socket, const char* request) {
-    printf("HTTP Request: %s\n", request);
-    
-    // Parse request line
-    char method[16], path[256], version[16];
-    if (sscanf(request, "%15s %255s %15s", method, path, version) != 3) {
-        streaming_send_http_response(client_socket, "400 Bad Request", 
-                                   "text/plain", "Bad Request");
+// Take ownership of an accepted socket (runs on the target loop)
+static void loop_adopt_connection(stream_loop_t* loop, int client_socket, const struct sockaddr_in* addr) {
+    stream_connection_t* conn = loop_alloc_connection(loop);
+    if (!conn) {
+        printf("Failed to allocate connection structure\n");
+        admission_release(loop->server, addr->sin_addr.s_addr);
+        close(client_socket);
         return;
     }
-    
-    // Only handle GET requests
-    if (strcmp(method, "GET") != 0) {
-        streaming_send_http_response(client_socket, "405 Method Not Allowed", 
-                                   "text/plain", "Method Not Allowed");
-        return;
+
+    conn->socket = client_socket;
+    conn->active = true;
+    conn->state = STREAM_CONN_READING_REQUEST;
+
+    // Get client IP and port
+    inet_ntop(AF_INET, &addr->sin_addr, conn->client_ip, sizeof(conn->client_ip));
+    conn->client_addr = addr->sin_addr.s_addr;
+    conn->client_port = ntohs(addr->sin_port);
+
+    conn->loop = loop;
+    conn->head_zerocopy_seq = -1;
+    stream_http_parser_reset(&conn->parser);
+    conn->last_activity_ms = stream_now_ms();
+    conn->connected_ms = conn->last_activity_ms;
+
+    // Requests must arrive within request_timeout_ms
+    stream_timer_init(&conn->idle_timer, connection_idle_check, conn);
+    int request_timeout = loop->server->config->server.request_timeout_ms;
+    if (request_timeout > 0) {
+        stream_timer_schedule(&loop->timers, &conn->idle_timer,
+                              conn->last_activity_ms + (uint64_t)request_timeout);
     }
-    
-    // Find stream function for this endpoint
-    stream_function_entry_t* stream_func = find_stream_function(path);
-    if (!stream_func) {
-        streaming_send_http_response(client_socket, "404 Not Found", 
-                                   "text/plain", "Stream not found");
+
+    streaming_add_connection(conn);
+    __atomic_add_fetch(&loop->connection_count, 1, __ATOMIC_RELAXED);
+    stats_add(&loop->stats.connections_accepted, 1);
+
+    if (!stream_poller_add(&loop->poller, conn->socket,
+                           STREAM_POLL_READ | STREAM_POLL_WRITE, conn)) {
+        connection_close(conn);
         return;
     }
-    
-    if (!stream_func->enabled) {
-        streaming_send_http_response(client_socket, "503 Service Unavailable", 
-                                   "text/plain", "Stream disabled");
-        return;
-    }
-    
-    // Send SSE headers
-    const char* sse_headers = 
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/event-stream\r\n"
-        "Cache-Control: no-cache\r\n"
-        "Connection: keep-alive\r\n"
-        "Access-Control-Allow-Origin: *\r\n"
-        "\r\n";
-    
-    send(client_socket, sse_headers, strlen(sse_headers), 0);
-    
-    // Stream data
-    char data_buffer[1024];
-    int data_count = 0;
-    while (true) {
-        // Call stream handler
-        stream_func->handler(stream_func->name, data_buffer, sizeof(data_buffer));
-        
-        printf("Streaming data #%d: %s\n", ++data_count, data_buffer);
-        
-        // Send SSE event
-        streaming_send_sse_event(client_socket, "data", data_buffer);
-        
-        // Wait for next interval
-        usleep(stream_func->interval_ms * 1000);
-        
-        // Check if connection is still active (simple check)
-        int error = 0;
-        socklen_t len = sizeof(error);
-        if (getsockopt(client_socket, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
-            printf("Connection closed, stopping stream\n");
-            break;
-        }
+
+    printf("Client connected from %s:%d (loop %d)\n",
+           conn->client_ip, conn->client_port, loop->index);
+}
+
+// Reserve a connection slot against the server-wide and per-IP caps
+static bool admission_acquire(stream_loop_t* loop, uint32_t addr) {
+    streaming_server_t* server = loop->server;
+    const stream_server_config_t* config = &server->config->server;
+    const char* reason = NULL;
+
+    int admitted = __atomic_add_fetch(&server->connection_count, 1, __ATOMIC_ACQ_REL);
+    if (config->max_connections > 0 && admitted > config->max_connections) {
+        reason = "server connection limit reached";
+    } else if (config->max_connections_per_ip > 0 && !ip_count_acquire(addr, config->max_connections_per_ip)) {
+        reason = "per-IP connection limit reached";
     }
-    
-    close(client_socket);
+    if (!reason) return true;
+
+    __atomic_sub_fetch(&server->connection_count, 1, __ATOMIC_ACQ_REL);
+    stats_add(&loop->stats.rejected_connections, 1);
+
+    // One line per second per loop is enough to see overload without flooding the log
+    uint64_t now = stream_now_ms();
+    if (now - loop->last_reject_log_ms >= REJECT_LOG_INTERVAL_MS) {
+        loop->last_reject_log_ms = now;
+        char ip[16];
+        struct in_addr in = { addr };
+        inet_ntop(AF_INET, &in, ip, sizeof(ip));
+        printf("Rejecting connection from %s: %s (%llu rejected so far on loop %d)\n", ip, reason,
+               (unsigned long long)__atomic_load_n(&loop->stats.rejected_connections, __ATOMIC_RELAXED),
+               loop->index);
+    }
+    return false;
 }
 
-// Find stream function by endpoint
-static stream_function_entry_t* find_stream_function(const char* endpoint) {
-    pthread_mutex_lock(&g_functions_mutex);
-    
-    for (int i = 0; i < g_stream_function_count; i++) {
-        if (strcmp(g_stream_functions[i].endpoint, endpoint) == 0) {
-            pthread_mutex_unlock(&g_functions_mutex);
-            return &g_stream_functions[i];
-        }
+// Return a slot taken by admission_acquire
+static void admission_release(streaming_server_t* server, uint32_t addr) {
+    __atomic_sub_fetch(&server->connection_count, 1, __ATOMIC_ACQ_REL);
+    if (server->config->server.max_connections_per_ip > 0) {
+        ip_count_release(addr);
     }
-    
-    pthread_mutex_unlock(&g_functions_mutex);
-    return NULL;
 }
 
-// Register stream function
-void streaming_register_function(const char* name, const char* endpoint, 
-                                int interval_ms, stream_handler_t handler, 
-                                const char* description) {
-    if (!name || !endpoint || !handler || !description) {
-        printf("Invalid parameters for stream function registration\n");
-        return;
+static size_t ip_bucket(uint32_t addr) {
+    return (size_t)((addr * 2654435761u) >> 24) % IP_TABLE_BUCKETS;
+}
+
+// Count one more connection from addr unless it already has limit open
+static bool ip_count_acquire(uint32_t addr, int limit) {
+    stream_ip_count_t** bucket = &g_ip_counts[ip_bucket(addr)];
+    bool admitted = false;
+
+    pthread_mutex_lock(&g_ip_counts_mutex);
+    stream_ip_count_t* entry = *bucket;
+    while (entry && entry->addr != addr) entry = entry->next;
+    if (!entry) {
+        entry = calloc(1, sizeof(stream_ip_count_t));
+        if (entry) {
+            entry->addr = addr;
+            entry->next = *bucket;
+            *bucket = entry;
+        }
     }
-    
-    pthread_mutex_lock(&g_functions_mutex);
-    
-    if (g_stream_function_count >= MAX_STREAM_FUNCTIONS) {
-        printf("Maximum stream functions reached\n");
-        pthread_mutex_unlock(&g_functions_mutex);
-        return;
+    if (entry && entry->count < limit) {
+        entry->count++;
+        admitted = true;
     }
-    
-    stream_function_entry_t* entry = &g_stream_functions[g_stream_function_count];
-    
-    strncpy(entry->name, name, sizeof(entry->name) - 1);
-    entry->name[sizeof(entry->name) - 1] = '\0';
-    
-    strncpy(entry->endpoint, endpoint, sizeof(entry->endpoint) - 1);
-    entry->endpoint[sizeof(entry->endpoint) - 1] = '\0';
-    
-    entry->interval_ms = interval_ms;
-    entry->enabled = true;
-    entry->handler = handler;
-    
-    strncpy(entry->description, description, sizeof(entry->description) - 1);
-    entry->description[sizeof(entry->description) - 1] = '\0';
-    
-    g_stream_function_count++;
-    
-    printf("Registered stream function: %s -> %s (%d ms)\n", name, endpoint, interval_ms);
-    
-    pthread_mutex_unlock(&g_functions_mutex);
+    pthread_mutex_unlock(&g_ip_counts_mutex);
+    return admitted;
 }
 
-// Send HTTP response
-void streaming_send_http_response(int client_socket, const char* status, 
-                                 const char* content_type, const char* body) {
-    char response[2048];
-    snprintf(response, sizeof(response),
-            "HTTP/1.1 %s\r\n"
-            "Content-Type: %s\r\n"
-            "Content-Length: %zu\r\n"
+static void ip_count_release(uint32_t addr) {
+    pthread_mutex_lock(&g_ip_counts_mutex);
+    stream_ip_count_t** link = &g_ip_counts[ip_bucket(addr)];
+    while (*link && (*link)->addr != addr) link = &(*link)->next;
+    stream_ip_count_t* entry = *link;
+    if (entry && --entry->count <= 0) {
+        *link = entry->next;
+        free(entry);
+    }
+    pthread_mutex_unlock(&g_ip_counts_mutex);
+}
+
+// Refuse an accepted socket with a canned 503; never blocks
+static void reject_connection(streaming_server_t* server, int client_socket) {
+    char response[256];
+    int length = snprintf(response, sizeof(response),
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Length: 11\r\n"
+            "Retry-After: %d\r\n"
             "Connection: close\r\n"
             "\r\n"
-            "%s",
-            status, content_type, strlen(body), body);
-    
-    send(client_socket, response, strlen(response), 0);
+            "Server busy",
+            server->config->server.retry_after_seconds);
+
+    // Discard whatever request bytes already arrived so close() sends FIN rather than RST
+    char discard[1024];
+    while (recv(client_socket, discard, sizeof(discard), 0) > 0) {
+    }
+    if (length > 0) {
+        send(client_socket, response, (size_t)length, STREAM_SEND_FLAGS);
+    }
+    shutdown(client_socket, SHUT_WR);
     close(client_socket);
 }
 
-// Send SSE event
-void streaming_send_sse_event(int client_socket, const char* event_name, 
-                             const char* data) {
-    char event[2048];
-    snprintf(event, sizeof(event),
-            "event: %s\n"
-            "data: %s\n"
-            "\n",
-            event_name, data);
-    
-    ssize_t sent = send(client_socket, event, strlen(event), 0);
-    printf("Sent SSE event: %zd bytes\n", sent);
-    if (sent < 0) {
-        printf("Failed to send SSE event: %s\n", strerror(errno));
+// Close a connection; memory is released at the end of the loop iteration
+static void connection_close(stream_connection_t* conn) {
+    if (!conn->active) return;
+
+    stream_loop_t* loop = conn->loop;
+    __atomic_store_n(&conn->active, false, __ATOMIC_RELEASE);
+
+    connection_unsubscribe_all(conn);
+    stream_timer_cancel(&loop->timers, &conn->idle_timer);
+    stats_sub(&loop->stats.queued_frames, conn->send_queue_count);
+    stats_sub(&loop->stats.queued_bytes, conn->send_queue_bytes);
+    stream_poller_remove(&loop->poller, conn->socket);
+    close(conn->socket);
+    conn->socket = -1;
+
+    admission_release(loop->server, conn->client_addr);
+
+    // Unlink from the registry; memory is recycled once no walker can reach it
+    streaming_remove_connection(conn);
+    __atomic_sub_fetch(&loop->connection_count, 1, __ATOMIC_RELAXED);
+}
+
+// Take a connection from the loop's pool, keeping its send queue allocation
+static stream_connection_t* loop_alloc_connection(stream_loop_t* loop) {
+    stream_connection_t* conn = loop->pool;
+    if (!conn) {
+        return calloc(1, sizeof(stream_connection_t));
     }
+
+    loop->pool = conn->retire_next;
+    loop->pool_count--;
+
+    stream_queued_frame_t* send_queue = conn->send_queue;
+    size_t send_queue_capacity = conn->send_queue_capacity;
+    memset(conn, 0, sizeof(*conn));
+    conn->send_queue = send_queue;
+    conn->send_queue_capacity = send_queue_capacity;
+    return conn;
 }
 
-// Add connection to list
-void streaming_add_connection(stream_connection_t* conn) {
-    if (!g_streaming_server || !conn) return;
-    
-    pthread_mutex_lock(&g_streaming_server->connections_mutex);
-    
-    conn->next = g_streaming_server->connections;
-    g_streaming_server->connections = conn;
-    
-    pthread_mutex_unlock(&g_streaming_server->connections_mutex);
+// Return an unreachable connection to the pool (or the allocator once it is full)
+static void loop_recycle_connection(stream_loop_t* loop, stream_connection_t* conn) {
+    connection_release_frames(conn);
+    if (loop->pool_count >= CONNECTION_POOL_MAX) {
+        free(conn->send_queue);
+        free(conn);
+        return;
+    }
+    conn->retire_next = loop->pool;
+    loop->pool = conn;
+    loop->pool_count++;
 }
 
-// Remove connection from list
-void streaming_remove_connection(stream_connection_t* conn) {
-    if (!g_streaming_server || !conn) return;
-    
-    pthread_mutex_lock(&g_streaming_server->connections_mutex);
-    
-    stream_connection_t** current = &g_streaming_server->connections;
-    while (*current) {
-        if (*current == conn) {
-            *current = conn->next;
-            break;
+// Recycle closed connections that no registry walker can still see; true when none remain
+static bool loop_reclaim(stream_loop_t* loop) {
+    if (!loop->closed) return true;
+
+    // Retirement needs the epoch to move twice; without walkers both steps succeed at once
+    stream_epoch_t* epoch = &loop->server->registry_epoch;
+    for (int i = 0; i < 2 && !stream_epoch_is_safe(epoch, loop->closed->retired_epoch); i++) {
+        if (!stream_epoch_try_advance(epoch)) break;
+    }
+
+    stream_connection_t** link = &loop->closed;
+    while (*link) {
+        stream_connection_t* conn = *link;
+        if (stream_epoch_is_safe(epoch, conn->retired_epoch)) {
+            *link = conn->retire_next;
+            loop_recycle_connection(loop, conn);
+        } else {
+            link = &conn->retire_next;
         }
-        current = &(*current)->next;
     }
-    
-    pthread_mutex_unlock(&g_streaming_server->connections_mutex);
+    return loop->closed == NULL;
 }
 
-// Cleanup all connections
-void streaming_cleanup_connections(void) {
-    if (!g_streaming_server) return;
-    
-    pthread_mutex_lock(&g_streaming_server->connections_mutex);
-    
-    stream_connection_t* current = g_streaming_server->connections;
-    while (current) {
-        stream_connection_t* next = current->next;
-        
-        // Close socket
-        if (current->socket >= 0) {
-            close(current->socket);
-        }
-        
-        // Wait for thread to finish
-        if (current->active) {
-            pthread_join(current->thread, NULL);
-        }
-        
-        free(current);
-        current = next;
-    }
-    
-    g_streaming_server->connections = NULL;
-    
-    pthread_mutex_unlock(&g_streaming_server->connections_mutex);
-} 
\ No newline at end of file
+// SSE retry: hint for a new subscriber: reconnect_retry_ms plus up to 50% jitter,
+// so clients dropped together by an outage come back spread out (0 = no hint)
+static int loop_retry_hint(stream_loop_t* loop) {
+    int base = loop->server->config->server.reconnect_retry_ms;
+    if (base <= 0) return 0;
+
+    uint32_t x = loop->retry_jitter;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    loop->retry_jitter = x;
+    return base + (int)(x % ((uint32_t)base / 2 + 1));
+}
+
+// Dispatch poller readiness for a connection
+static void connection_on_event(stream_connection_t* conn, uint32_t events) {
+    if (!conn->active) return;
+
+    if (events & STREAM_POLL_ERROR) {
+        // Zerocopy completions arrive on the error queue; anything else is fatal
+        int error = 0;
+        socklen_t error_length = sizeof(error);
+        if (conn->zerocopy_enabled) {
+            connection_zerocopy_reap(conn);
+        }
+        if (getsockopt(conn->socket, SOL_SOCKET, SO_ERROR, &error, &error_length) != 0 || error != 0) {
+            connection_close(conn);
+            return;
+        }
+    }
+
+    if (events & STREAM_POLL_READ) {
+        connection_on_readable(conn);
+        if (!conn->active) return;
+    }
+
+    if (events & STREAM_POLL_WRITE) {
+        if (!connection_flush(conn)) return;
+    }
+
+    if (events & STREAM_POLL_HUP) {
+        connection_close(conn);
+    }
+}
+
+// Drain the socket receive buffer
+static void connection_on_readable(stream_connection_t* conn) {
+    while (conn->active) {
+        char discard[512];
+        char* target;
+        size_t space;
+
+        // Paused reads resume from connection_flush once the queue drains; handling a
+        // request here would let its response's flush re-enter and repeat it
+        if (conn->read_paused) return;
+
+        if (conn->state == STREAM_CONN_READING_REQUEST) {
+            // Parse what is buffered first so pipelined requests free up space
+            connection_process_requests(conn);
+            if (!conn->active || conn->read_paused) return;
+            if (conn->read_eof) {
+                // Every complete request is answered; close once the responses are out
+                conn->keep_alive = false;
+                __atomic_store_n(&conn->state, STREAM_CONN_CLOSING, __ATOMIC_RELAXED);
+                if (conn->send_queue_count == 0) connection_close(conn);
+                return;
+            }
+        } else if (conn->state == STREAM_CONN_WEBSOCKET) {
+            connection_process_ws(conn);
+            if (!conn->active || conn->read_paused) return;
+        }
+
+        bool buffered = conn->state == STREAM_CONN_READING_REQUEST || conn->state == STREAM_CONN_WEBSOCKET;
+        if (buffered) {
+            // The parsers fail requests and frames that cannot fit, so there is always room here
+            space = sizeof(conn->request_buffer) - conn->request_length;
+            target = conn->request_buffer + conn->request_length;
+        } else {
+            // SSE and closing clients have nothing more to say; drain to detect EOF
+            target = discard;
+            space = sizeof(discard);
+        }
+
+        ssize_t bytes_read = recv(conn->socket, target, space, 0);
+        if (bytes_read == 0) {
+            // A half-closed HTTP client still gets the responses to every complete
+            // request it sent; a closing one still gets its final response
+            if (conn->state == STREAM_CONN_READING_REQUEST) {
+                conn->read_eof = true;
+                continue;
+            }
+            if (conn->state == STREAM_CONN_CLOSING && conn->send_queue_count > 0) return;
+            connection_close(conn);
+            return;
+        }
+        if (bytes_read < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection_close(conn);
+            }
+            return;
+        }
+
+        if (buffered) {
+            conn->request_length += (size_t)bytes_read;
+        }
+    }
+}
+
+// Handle every complete request in the receive buffer, in order
+static void connection_process_requests(stream_connection_t* conn) {
+    const stream_server_config_t* config = &conn->loop->server->config->server;
+
+    while (conn->active && conn->state == STREAM_CONN_READING_REQUEST && conn->request_length > 0) {
+        // A client pipelining faster than it reads responses waits for the queue to drain
+        if (config->send_queue_max_bytes > 0 &&
+            conn->send_queue_bytes > (size_t)config->send_queue_max_bytes) {
+            conn->read_paused = true;
+            return;
+        }
+
+        stream_http_result_t result = stream_http_parse(&conn->parser, conn->request_buffer,
+                                                        conn->request_length,
+                                                        sizeof(conn->request_buffer));
+        if (result == STREAM_HTTP_INCOMPLETE) return;
+        if (result == STREAM_HTTP_ERROR) {
+            const char* status = conn->parser.error_status;
+            conn->keep_alive = false;
+            connection_respond(conn, status, "text/plain", status + 4);
+            return;
+        }
+
+        size_t consumed = conn->parser.request.length;
+        handle_http_request(conn, &conn->parser.request);
+        if (!conn->active) return;
+
+        // Request views die here: shift any pipelined bytes to the front
+        memmove(conn->request_buffer, conn->request_buffer + consumed, conn->request_length - consumed);
+        conn->request_length -= consumed;
+        stream_http_parser_reset(&conn->parser);
+    }
+}
+
+// Handle every complete WebSocket frame in the receive buffer, in order
+static void connection_process_ws(stream_connection_t* conn) {
+    const stream_server_config_t* config = &conn->loop->server->config->server;
+
+    while (conn->active && conn->state == STREAM_CONN_WEBSOCKET && conn->request_length > 0) {
+        // Same back-pressure as pipelined requests: pings are answered only as fast as they are read
+        if (config->send_queue_max_bytes > 0 &&
+            conn->send_queue_bytes > (size_t)config->send_queue_max_bytes) {
+            conn->read_paused = true;
+            return;
+        }
+
+        stream_ws_frame_t frame;
+        int close_code;
+        stream_ws_result_t result = stream_ws_parse_frame(conn->request_buffer, conn->request_length,
+                                                          sizeof(conn->request_buffer) - STREAM_WS_MAX_HEADER,
+                                                          &frame, &close_code);
+        if (result == STREAM_WS_INCOMPLETE) return;
+        if (result == STREAM_WS_ERROR) {
+            connection_ws_close(conn, close_code);
+            return;
+        }
+
+        char* payload = conn->request_buffer + frame.header_length;
+        stream_ws_unmask(payload, frame.payload_length, frame.mask);
+        connection_ws_frame(conn, &frame, payload);
+        if (!conn->active) return;
+
+        size_t consumed = frame.header_length + frame.payload_length;
+        memmove(conn->request_buffer, conn->request_buffer + consumed, conn->request_length - consumed);
+        conn->request_length -= consumed;
+    }
+}
+
+// React to one unmasked client frame
+static void connection_ws_frame(stream_connection_t* conn, const stream_ws_frame_t* frame, const char* payload) {
+    switch (frame->opcode) {
+    case STREAM_WS_OP_PING:
+        connection_ws_send(conn, STREAM_WS_OP_PONG, payload, frame->payload_length);
+        return;
+    case STREAM_WS_OP_PONG:
+        return;
+    case STREAM_WS_OP_CLOSE:
+        // Echo the client's status code; a lone byte or a code that may not be
+        // sent (RFC 6455 section 7.4) is a protocol error, a reason that is not
+        // UTF-8 is invalid data
+        if (frame->payload_length == 1) {
+            connection_ws_close(conn, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+        } else if (frame->payload_length >= 2) {
+            int code = ((uint8_t)payload[0] << 8) | (uint8_t)payload[1];
+            if (!stream_ws_close_code_valid(code)) {
+                code = STREAM_WS_CLOSE_PROTOCOL_ERROR;
+            } else if (!stream_ws_utf8_valid(payload + 2, frame->payload_length - 2)) {
+                code = STREAM_WS_CLOSE_INVALID_DATA;
+            }
+            connection_ws_close(conn, code);
+        } else {
+            connection_ws_close(conn, 0);
+        }
+        return;
+    case STREAM_WS_OP_BINARY:
+        // Control messages are JSON text; binary only flows server to client
+        connection_ws_close(conn, STREAM_WS_CLOSE_UNSUPPORTED);
+        return;
+    case STREAM_WS_OP_TEXT:
+    case STREAM_WS_OP_CONTINUATION:
+        break;
+    }
+
+    // A continuation needs an open message and a new text frame must not interrupt one
+    bool continuation = frame->opcode == STREAM_WS_OP_CONTINUATION;
+    if (continuation != conn->ws_in_message) {
+        connection_ws_close(conn, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+        return;
+    }
+    if (frame->payload_length >= sizeof(conn->ws_message) - conn->ws_message_length) {
+        connection_ws_close(conn, STREAM_WS_CLOSE_TOO_BIG);
+        return;
+    }
+    memcpy(conn->ws_message + conn->ws_message_length, payload, frame->payload_length);
+    conn->ws_message_length += frame->payload_length;
+    conn->ws_in_message = !frame->fin;
+    if (conn->ws_in_message) return;
+
+    // Fragments may split a character, so the message is checked once it is whole
+    size_t length = conn->ws_message_length;
+    conn->ws_message_length = 0;
+    if (!stream_ws_utf8_valid(conn->ws_message, length)) {
+        connection_ws_close(conn, STREAM_WS_CLOSE_INVALID_DATA);
+        return;
+    }
+    conn->ws_message[length] = '\0';
+    connection_ws_message(conn, conn->ws_message, length);
+}
+
+// Control message: {"type":"subscribe"|"unsubscribe","stream":name or endpoint}
+// with optional "interval_ms"/"max_rate" on subscribe. Each gets a JSON text reply;
+// events then arrive as binary frames tagged with the stream name.
+static void connection_ws_message(stream_connection_t* conn, const char* text, size_t length) {
+    char type[32];
+    char name[128];
+
+    if (!stream_ws_json_field(text, length, "type", type, sizeof(type))) {
+        connection_ws_reply(conn, "error", NULL, "Expected a JSON object with a type");
+        return;
+    }
+    bool subscribe = strcmp(type, "subscribe") == 0 || strcmp(type, "start_stream") == 0;
+    bool unsubscribe = strcmp(type, "unsubscribe") == 0 || strcmp(type, "stop_stream") == 0;
+    if (!subscribe && !unsubscribe) {
+        connection_ws_reply(conn, "error", NULL, "Unknown message type");
+        return;
+    }
+    if (!stream_ws_json_field(text, length, "stream", name, sizeof(name))) {
+        connection_ws_reply(conn, "error", NULL, "Missing stream");
+        return;
+    }
+
+    stream_http_view_t view = { name, strlen(name) };
+    stream_function_entry_t* stream = name[0] == '/' ? find_stream_function(view) : find_stream_by_name(view);
+    if (!stream) {
+        connection_ws_reply(conn, "error", name, "Stream not found");
+        return;
+    }
+
+    if (unsubscribe) {
+        connection_unsubscribe(conn, stream);
+        connection_ws_reply(conn, "unsubscribed", stream->name, NULL);
+        return;
+    }
+
+    if (!stream->enabled) {
+        connection_ws_reply(conn, "error", stream->name, "Stream disabled");
+        return;
+    }
+
+    char interval_text[16];
+    char rate_text[16];
+    stream_http_view_t interval_ms = { interval_text, 0 };
+    stream_http_view_t max_rate = { rate_text, 0 };
+    bool has_interval = stream_ws_json_field(text, length, "interval_ms", interval_text, sizeof(interval_text));
+    bool has_rate = stream_ws_json_field(text, length, "max_rate", rate_text, sizeof(rate_text));
+    if (has_interval) interval_ms.length = strlen(interval_text);
+    if (has_rate) max_rate.length = strlen(rate_text);
+
+    stream_subscribe_options_t options = { 0, false, true, false, false, 0 };
+    if (!parse_subscription_rate(has_interval ? &interval_ms : NULL, has_rate ? &max_rate : NULL,
+                                 &options.min_interval_ms)) {
+        connection_ws_reply(conn, "error", stream->name, "interval_ms must be 1-3600000 and max_rate 1-1000");
+        return;
+    }
+
+    // Same resume as Last-Event-ID over SSE
+    char resume_text[24];
+    unsigned long resume_id;
+    if (stream_ws_json_field(text, length, "last_event_id", resume_text, sizeof(resume_text))) {
+        stream_http_view_t resume_view = { resume_text, strlen(resume_text) };
+        if (stream_http_view_to_uint(resume_view, ULONG_MAX, &resume_id)) {
+            options.resume = true;
+            options.last_event_id = resume_id;
+        }
+    }
+
+    // Subscribing again only changes the rate
+    for (stream_subscription_t* sub = conn->subscriptions; sub; sub = sub->conn_next) {
+        if (sub->stream == stream) {
+            sub->min_interval_ms = options.min_interval_ms;
+            sub->next_due_ms = 0;
+            connection_ws_reply(conn, "subscribed", stream->name, NULL);
+            return;
+        }
+    }
+
+    int previous = stream_reserve_subscriber(stream);
+    if (previous < 0) {
+        stats_add(&conn->loop->stats.rejected_subscriptions, 1);
+        connection_ws_reply(conn, "error", stream->name, "Stream at capacity");
+        return;
+    }
+
+    // Acknowledge first so the catch-up sample follows the reply
+    connection_ws_reply(conn, "subscribed", stream->name, NULL);
+    if (!conn->active) {
+        stream_release_subscriber(stream);
+    } else if (!connection_subscribe(conn, stream, previous, &options)) {
+        connection_close(conn);
+    }
+}
+
+// Queue one small server frame (control frames and replies)
+static void connection_ws_send(stream_connection_t* conn, stream_ws_opcode_t opcode,
+                               const char* payload, size_t length) {
+    char frame[STREAM_WS_MAX_HEADER + WS_REPLY_SIZE];
+    if (length > WS_REPLY_SIZE) return;
+
+    size_t header_length = stream_ws_frame_header(opcode, length, frame);
+    memcpy(frame + header_length, payload, length);
+    connection_write(conn, frame, header_length + length);
+}
+
+// JSON text reply to a control message (stream and message may be NULL)
+static void connection_ws_reply(stream_connection_t* conn, const char* type, const char* stream,
+                                const char* message) {
+    char reply[WS_REPLY_SIZE];
+    size_t length = (size_t)snprintf(reply, sizeof(reply), "{\"type\":\"%s\"", type);
+    if (stream && length < sizeof(reply)) {
+        length += (size_t)snprintf(reply + length, sizeof(reply) - length, ",\"stream\":");
+        length = json_append_string(reply, sizeof(reply), length, stream);
+    }
+    if (message && length < sizeof(reply)) {
+        length += (size_t)snprintf(reply + length, sizeof(reply) - length, ",\"message\":");
+        length = json_append_string(reply, sizeof(reply), length, message);
+    }
+    if (length + 1 >= sizeof(reply)) return;
+    reply[length++] = '}';
+    connection_ws_send(conn, STREAM_WS_OP_TEXT, reply, length);
+}
+
+// Start the closing handshake (code 0 sends an empty close frame); the socket
+// closes once the close frame is flushed
+static void connection_ws_close(stream_connection_t* conn, int code) {
+    char payload[2] = { (char)(code >> 8), (char)(code & 0xFF) };
+
+    connection_unsubscribe_all(conn);
+    __atomic_store_n(&conn->state, STREAM_CONN_CLOSING, __ATOMIC_RELAXED);
+    connection_ws_send(conn, STREAM_WS_OP_CLOSE, payload, code ? sizeof(payload) : 0);
+}
+
+// Gather queued frames into one sendmsg call until the socket would block;
+// returns false if the connection was closed
+static bool connection_flush(stream_connection_t* conn) {
+    const streaming_server_t* server = g_streaming_server;
+
+    while (conn->send_queue_count > 0) {
+        struct iovec iov[MAX_SEND_IOV];
+        int iov_count = 0;
+        size_t total = 0;
+
+        for (size_t i = 0; i < conn->send_queue_count; i++) {
+            if (iov_count + STREAM_FRAME_MAX_SEGMENTS > MAX_SEND_IOV) break;
+            const stream_frame_t* frame =
+                conn->send_queue[(conn->send_queue_head + i) % conn->send_queue_capacity].frame;
+            size_t offset = (i == 0) ? conn->send_head_offset : 0;
+            int used = stream_frame_segments(frame, offset, &iov[iov_count], MAX_SEND_IOV - iov_count);
+            for (int j = 0; j < used; j++) total += iov[iov_count + j].iov_len;
+            iov_count += used;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        int flags = STREAM_SEND_FLAGS;
+        bool zerocopy = false;
+#ifdef STREAM_HAVE_ZEROCOPY
+        int threshold = server ? server->config->server.zerocopy_threshold : 0;
+        if (threshold > 0 && total >= (size_t)threshold) {
+            if (!conn->zerocopy_enabled) {
+                int one = 1;
+                conn->zerocopy_enabled =
+                    setsockopt(conn->socket, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+            }
+            if (conn->zerocopy_enabled) {
+                flags |= MSG_ZEROCOPY;
+                zerocopy = true;
+            }
+        }
+#else
+        (void)server;
+#endif
+
+        ssize_t sent = sendmsg(conn->socket, &msg, flags);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // The client is not keeping up; the slow-consumer policy measures from here
+                if (conn->backlog_since_ms == 0) conn->backlog_since_ms = stream_now_ms();
+                return true;
+            }
+            if (zerocopy && errno == ENOBUFS) {
+                // Out of optmem for notifications: fall back to copying sends
+                conn->zerocopy_enabled = false;
+                continue;
+            }
+            connection_close(conn);
+            return false;
+        }
+
+        uint32_t seq = 0;
+        if (zerocopy) seq = conn->zerocopy_next_seq++;
+
+        // Retire fully written frames; the head may remain partially sent
+        size_t remaining = (size_t)sent;
+        while (remaining > 0 && conn->send_queue_count > 0) {
+            stream_frame_t* head = conn->send_queue[conn->send_queue_head].frame;
+            size_t size = stream_frame_size(head);
+            size_t unsent = size - conn->send_head_offset;
+
+            if (remaining < unsent) {
+                conn->send_head_offset += remaining;
+                if (zerocopy) conn->head_zerocopy_seq = seq;
+                break;
+            }
+
+            remaining -= unsent;
+            conn->send_queue[conn->send_queue_head].frame = NULL;
+            conn->send_queue_head = (conn->send_queue_head + 1) % conn->send_queue_capacity;
+            conn->send_queue_count--;
+            conn->send_queue_bytes -= size;
+            conn->send_head_offset = 0;
+            stats_sub(&conn->loop->stats.queued_frames, 1);
+            stats_sub(&conn->loop->stats.queued_bytes, size);
+
+            if (zerocopy) {
+                connection_zerocopy_retire(conn, head, seq);
+            } else if (conn->head_zerocopy_seq >= 0) {
+                connection_zerocopy_retire(conn, head, (uint32_t)conn->head_zerocopy_seq);
+            } else {
+                stream_frame_release(head);
+            }
+            conn->head_zerocopy_seq = -1;
+        }
+    }
+
+    conn->backlog_since_ms = 0;
+    conn->slow_reported = false;
+
+    if (conn->state == STREAM_CONN_CLOSING) {
+        connection_close(conn);
+        return false;
+    }
+    if (conn->read_paused) {
+        // Responses are out: pick up the pipelined requests and anything still unread
+        conn->read_paused = false;
+        connection_on_readable(conn);
+    }
+    return conn->active;
+}
+
+// Append a shared frame to the send queue (takes a new reference)
+static void connection_enqueue(stream_connection_t* conn, stream_frame_t* frame, int stream) {
+    if (!conn->active || !frame) return;
+
+    if (conn->send_queue_count == conn->send_queue_capacity) {
+        size_t capacity = conn->send_queue_capacity ? conn->send_queue_capacity * 2 : 8;
+        stream_queued_frame_t* grown = malloc(capacity * sizeof(stream_queued_frame_t));
+        if (!grown) {
+            printf("Failed to grow send queue for %s:%d\n", conn->client_ip, conn->client_port);
+            connection_close(conn);
+            return;
+        }
+        for (size_t i = 0; i < conn->send_queue_count; i++) {
+            grown[i] = conn->send_queue[(conn->send_queue_head + i) % conn->send_queue_capacity];
+        }
+        free(conn->send_queue);
+        conn->send_queue = grown;
+        conn->send_queue_capacity = capacity;
+        conn->send_queue_head = 0;
+    }
+
+    size_t tail = (conn->send_queue_head + conn->send_queue_count) % conn->send_queue_capacity;
+    size_t size = stream_frame_size(frame);
+    conn->send_queue[tail].frame = stream_frame_retain(frame);
+    conn->send_queue[tail].stream = stream;
+    conn->send_queue_count++;
+    conn->send_queue_bytes += size;
+
+    stream_loop_stats_t* stats = &conn->loop->stats;
+    stats_add(&stats->queued_frames, 1);
+    stats_add(&stats->queued_bytes, size);
+    if (conn->send_queue_count > __atomic_load_n(&stats->queue_high_water, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&stats->queue_high_water, (uint64_t)conn->send_queue_count, __ATOMIC_RELAXED);
+    }
+}
+
+// Remove a queued frame that has not started sending, keeping the ring order
+static void connection_dequeue(stream_connection_t* conn, size_t position) {
+    size_t capacity = conn->send_queue_capacity;
+    stream_frame_t* frame = conn->send_queue[(conn->send_queue_head + position) % capacity].frame;
+    size_t size = stream_frame_size(frame);
+
+    for (size_t i = position; i + 1 < conn->send_queue_count; i++) {
+        conn->send_queue[(conn->send_queue_head + i) % capacity] =
+            conn->send_queue[(conn->send_queue_head + i + 1) % capacity];
+    }
+    conn->send_queue_count--;
+    conn->send_queue_bytes -= size;
+    stats_sub(&conn->loop->stats.queued_frames, 1);
+    stats_sub(&conn->loop->stats.queued_bytes, size);
+    stream_frame_release(frame);
+}
+
+// Replace an unsent frame of the same stream with a newer one; false if none is queued
+static bool connection_coalesce(stream_connection_t* conn, stream_frame_t* frame, int stream) {
+    // A partially written head frame must go out whole
+    size_t first = conn->send_head_offset > 0 ? 1 : 0;
+
+    for (size_t i = first; i < conn->send_queue_count; i++) {
+        stream_queued_frame_t* entry =
+            &conn->send_queue[(conn->send_queue_head + i) % conn->send_queue_capacity];
+        if (entry->stream != stream) continue;
+
+        size_t old_size = stream_frame_size(entry->frame);
+        size_t new_size = stream_frame_size(frame);
+        stream_frame_release(entry->frame);
+        entry->frame = stream_frame_retain(frame);
+        conn->send_queue_bytes = conn->send_queue_bytes - old_size + new_size;
+
+        stream_loop_stats_t* stats = &conn->loop->stats;
+        stats_sub(&stats->queued_bytes, old_size);
+        stats_add(&stats->queued_bytes, new_size);
+        stats_add(&stats->frames_coalesced, 1);
+        return true;
+    }
+    return false;
+}
+
+// Discard the oldest unsent stream event other than the newest one; false if none qualifies
+static bool connection_drop_oldest(stream_connection_t* conn) {
+    size_t first = conn->send_head_offset > 0 ? 1 : 0;
+
+    for (size_t i = first; i + 1 < conn->send_queue_count; i++) {
+        if (conn->send_queue[(conn->send_queue_head + i) % conn->send_queue_capacity].stream < 0) continue;
+        connection_dequeue(conn, i);
+        conn->frames_dropped++;
+        stats_add(&conn->loop->stats.frames_dropped, 1);
+        return true;
+    }
+    return false;
+}
+
+// Close a connection whose backlog outlived slow_consumer_timeout_ms; false if it was closed
+static bool connection_check_backlog(stream_connection_t* conn, uint64_t now) {
+    const streaming_server_t* server = conn->loop->server;
+    if (server->slow_consumer_policy != STREAM_SLOW_DISCONNECT || conn->backlog_since_ms == 0) {
+        return true;
+    }
+
+    uint64_t timeout = (uint64_t)server->config->server.slow_consumer_timeout_ms;
+    if (now - conn->backlog_since_ms < timeout) return true;
+
+    printf("Disconnecting slow consumer %s:%d (%zu frames / %zu bytes backlogged for %llu ms)\n",
+           conn->client_ip, conn->client_port, conn->send_queue_count, conn->send_queue_bytes,
+           (unsigned long long)(now - conn->backlog_since_ms));
+    stats_add(&conn->loop->stats.slow_disconnects, 1);
+    connection_close(conn);
+    return false;
+}
+
+// Queue bytes for the client and push as much as the socket accepts now
+static void connection_write(stream_connection_t* conn, const char* data, size_t length) {
+    if (!conn->active || length == 0) return;
+
+    stream_frame_t* frame = stream_frame_create_raw(data, length);
+    if (!frame) {
+        connection_close(conn);
+        return;
+    }
+    connection_enqueue(conn, frame, -1);
+    stream_frame_release(frame);
+    connection_flush(conn);
+}
+
+// Drop every frame reference held by a closed connection (the queue array is kept for reuse)
+static void connection_release_frames(stream_connection_t* conn) {
+    while (conn->send_queue_count > 0) {
+        stream_frame_release(conn->send_queue[conn->send_queue_head].frame);
+        conn->send_queue_head = (conn->send_queue_head + 1) % conn->send_queue_capacity;
+        conn->send_queue_count--;
+    }
+    conn->send_queue_bytes = 0;
+    conn->send_queue_head = 0;
+
+    while (conn->zerocopy_pending) {
+        stream_zerocopy_pending_t* pending = conn->zerocopy_pending;
+        conn->zerocopy_pending = pending->next;
+        stream_frame_release(pending->frame);
+        free(pending);
+    }
+    conn->zerocopy_pending_tail = NULL;
+}
+
+// Keep a frame alive until the kernel finishes the zerocopy send that used it
+static void connection_zerocopy_retire(stream_connection_t* conn, stream_frame_t* frame, uint32_t seq) {
+    stream_zerocopy_pending_t* pending = malloc(sizeof(stream_zerocopy_pending_t));
+    if (!pending) {
+        // Leaking one reference is safer than freeing pages the kernel may still read
+        return;
+    }
+    pending->frame = frame;
+    pending->seq = seq;
+    pending->next = NULL;
+    if (conn->zerocopy_pending_tail) {
+        conn->zerocopy_pending_tail->next = pending;
+    } else {
+        conn->zerocopy_pending = pending;
+    }
+    conn->zerocopy_pending_tail = pending;
+}
+
+// Read zerocopy completion notifications and release finished frames
+static void connection_zerocopy_reap(stream_connection_t* conn) {
+#ifdef STREAM_HAVE_ZEROCOPY
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(conn->socket, &msg, MSG_ERRQUEUE) < 0) break;
+
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err* serr = (struct sock_extended_err*)CMSG_DATA(cm);
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            // Notifications cover the inclusive range [ee_info, ee_data]
+            if (serr->ee_info <= conn->zerocopy_completed &&
+                serr->ee_data + 1 > conn->zerocopy_completed) {
+                conn->zerocopy_completed = serr->ee_data + 1;
+            }
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // The kernel copied anyway (e.g. loopback); stop paying for notifications
+                conn->zerocopy_enabled = false;
+            }
+        }
+    }
+
+    while (conn->zerocopy_pending &&
+           (int32_t)(conn->zerocopy_pending->seq - conn->zerocopy_completed) < 0) {
+        stream_zerocopy_pending_t* pending = conn->zerocopy_pending;
+        conn->zerocopy_pending = pending->next;
+        if (!conn->zerocopy_pending) conn->zerocopy_pending_tail = NULL;
+        stream_frame_release(pending->frame);
+        free(pending);
+    }
+#else
+    (void)conn;
+#endif
+}
+
+// Send a complete response; the connection stays open for the next request
+// when the client asked for keep-alive, otherwise it closes once flushed
+static void connection_respond(stream_connection_t* conn, const char* status,
+                               const char* content_type, const char* body) {
+    connection_respond_headers(conn, status, content_type, "", body);
+}
+
+// 503 for a capped resource, telling the client when to come back
+static void connection_respond_busy(stream_connection_t* conn, const char* body) {
+    char retry_after[64];
+    snprintf(retry_after, sizeof(retry_after), "Retry-After: %d\r\n",
+             conn->loop->server->config->server.retry_after_seconds);
+    connection_respond_headers(conn, "503 Service Unavailable", "text/plain", retry_after, body);
+}
+
+// connection_respond with extra header lines (each ending in CRLF)
+static void connection_respond_headers(stream_connection_t* conn, const char* status,
+                                       const char* content_type, const char* extra_headers,
+                                       const char* body) {
+    char headers[512];
+    size_t body_length = strlen(body);
+    int length = snprintf(headers, sizeof(headers),
+            "HTTP/1.1 %s\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %zu\r\n"
+            "%s"
+            "Connection: %s\r\n"
+            "\r\n",
+            status, content_type, body_length, extra_headers,
+            conn->keep_alive ? "keep-alive" : "close");
+    if (length < 0 || (size_t)length >= sizeof(headers)) return;
+
+    if (conn->keep_alive) {
+        // Idle keep-alive connections get the same deadline as a fresh one
+        int request_timeout = conn->loop->server->config->server.request_timeout_ms;
+        if (request_timeout > 0) {
+            stream_timer_schedule(&conn->loop->timers, &conn->idle_timer,
+                                  stream_now_ms() + (uint64_t)request_timeout);
+        }
+    } else {
+        __atomic_store_n(&conn->state, STREAM_CONN_CLOSING, __ATOMIC_RELAXED);
+    }
+
+    stream_frame_t* header_frame = stream_frame_create_raw(headers, (size_t)length);
+    stream_frame_t* body_frame = body_length > 0 ? stream_frame_create_raw(body, body_length) : NULL;
+    if (!header_frame || (body_length > 0 && !body_frame)) {
+        stream_frame_release(header_frame);
+        stream_frame_release(body_frame);
+        connection_close(conn);
+        return;
+    }
+    connection_enqueue(conn, header_frame, -1);
+    connection_enqueue(conn, body_frame, -1);
+    stream_frame_release(header_frame);
+    stream_frame_release(body_frame);
+    connection_flush(conn);
+}
+
+// Queue a shared SSE frame for a connection, applying the slow-consumer policy
+// when the send queue is over its bounds (stream is -1 for frames that must not drop)
+static void connection_send_frame(stream_connection_t* conn, stream_frame_t* frame, int stream) {
+    if (!conn->active) return;
+
+    streaming_server_t* server = conn->loop->server;
+    const stream_server_config_t* config = &server->config->server;
+    uint64_t now = stream_now_ms();
+
+    __atomic_add_fetch(&conn->events_sent, 1, __ATOMIC_RELAXED);
+    conn->last_activity_ms = now;
+    if (stream >= 0) stats_add(&conn->loop->stats.frames_sent, 1);
+
+    // While the socket is backed up, a newer sample supersedes an unsent one
+    if (stream >= 0 && server->slow_consumer_policy == STREAM_SLOW_COALESCE &&
+        conn->backlog_since_ms != 0 && connection_coalesce(conn, frame, stream)) {
+        return;
+    }
+
+    connection_enqueue(conn, frame, stream);
+
+    size_t max_frames = config->send_queue_max_frames > 0 ? (size_t)config->send_queue_max_frames : SIZE_MAX;
+    size_t max_bytes = config->send_queue_max_bytes > 0 ? (size_t)config->send_queue_max_bytes : SIZE_MAX;
+    uint64_t dropped = conn->frames_dropped;
+    while (conn->send_queue_count > max_frames || conn->send_queue_bytes > max_bytes) {
+        if (!connection_drop_oldest(conn)) break;
+    }
+    if (conn->frames_dropped != dropped && !conn->slow_reported) {
+        printf("Slow consumer %s:%d: send queue full, dropping events (%llu dropped so far)\n",
+               conn->client_ip, conn->client_port, (unsigned long long)conn->frames_dropped);
+        conn->slow_reported = true;
+    }
+
+    if (!connection_flush(conn)) return;
+    connection_check_backlog(conn, now);
+}
+
+// Idle timer: time out slow requests and keep quiet streams alive
+static void connection_idle_check(stream_timer_t* timer, void* user_data) {
+    (void)timer;
+    stream_connection_t* conn = (stream_connection_t*)user_data;
+    const stream_server_config_t* config = &conn->loop->server->config->server;
+    uint64_t now = stream_now_ms();
+
+    bool websocket = conn->state == STREAM_CONN_WEBSOCKET;
+    if (conn->state != STREAM_CONN_STREAMING && !websocket) {
+        printf("Request timeout for %s:%d\n", conn->client_ip, conn->client_port);
+        connection_close(conn);
+        return;
+    }
+
+    if (!connection_check_backlog(conn, now)) return;
+    if (config->heartbeat_interval_ms <= 0) return;
+
+    uint64_t interval = (uint64_t)config->heartbeat_interval_ms;
+    stream_frame_t* heartbeat = websocket ? g_ws_ping_frame : g_heartbeat_frame;
+    if (now - conn->last_activity_ms >= interval && conn->send_queue_count == 0 && heartbeat) {
+        // A dead peer surfaces as a write error on the heartbeat
+        connection_send_frame(conn, heartbeat, -1);
+        if (!conn->active) return;
+    }
+    // A skipped heartbeat (backlog) waits a full interval rather than re-firing immediately
+    uint64_t deadline = conn->last_activity_ms + interval;
+    if (deadline <= now) deadline = now + interval;
+    stream_timer_schedule(&conn->loop->timers, &conn->idle_timer, deadline);
+}
+
+// The idle timer now sends heartbeats instead of enforcing the request timeout
+static void connection_start_heartbeat(stream_connection_t* conn) {
+    stream_timer_cancel(&conn->loop->timers, &conn->idle_timer);
+    int heartbeat = conn->loop->server->config->server.heartbeat_interval_ms;
+    if (conn->active && heartbeat > 0) {
+        stream_timer_schedule(&conn->loop->timers, &conn->idle_timer,
+                              stream_now_ms() + (uint64_t)heartbeat);
+    }
+}
+
+// Claim a subscriber slot; returns the previous subscriber count, or -1 at capacity
+static int stream_reserve_subscriber(stream_function_entry_t* stream) {
+    int count = __atomic_load_n(&stream->subscriber_count, __ATOMIC_ACQUIRE);
+    do {
+        if (stream->max_subscribers > 0 && count >= stream->max_subscribers) return -1;
+    } while (!__atomic_compare_exchange_n(&stream->subscriber_count, &count, count + 1, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return count;
+}
+
+// Give back a slot that never turned into a subscription
+static void stream_release_subscriber(stream_function_entry_t* stream) {
+    // The producer notices an empty audience on its next tick and parks itself
+    __atomic_sub_fetch(&stream->subscriber_count, 1, __ATOMIC_ACQ_REL);
+}
+
+// Attach a connection to a stream's shared producer using a reserved slot
+// (previous is what stream_reserve_subscriber returned)
+static bool connection_subscribe(stream_connection_t* conn, stream_function_entry_t* stream, int previous,
+                                 const stream_subscribe_options_t* options) {
+    stream_loop_t* loop = conn->loop;
+
+    stream_subscription_t* sub = calloc(1, sizeof(stream_subscription_t));
+    if (!sub) {
+        printf("Failed to allocate stream subscription\n");
+        stream_release_subscriber(stream);
+        return false;
+    }
+    sub->conn = conn;
+    sub->stream = stream;
+    sub->min_interval_ms = options->min_interval_ms;
+    sub->delta = options->delta;
+    sub->websocket = options->websocket;
+    sub->tagged = options->tagged;
+    if (sub->delta) __atomic_add_fetch(&stream->delta_subscribers, 1, __ATOMIC_RELAXED);
+    if (sub->websocket) __atomic_add_fetch(&stream->websocket_subscribers, 1, __ATOMIC_RELAXED);
+    if (sub->tagged) __atomic_add_fetch(&stream->tagged_subscribers, 1, __ATOMIC_RELAXED);
+
+    sub->next = loop->subscribers[stream->index];
+    if (sub->next) sub->next->prev = sub;
+    loop->subscribers[stream->index] = sub;
+
+    sub->conn_next = conn->subscriptions;
+    conn->subscriptions = sub;
+
+    __atomic_add_fetch(&stream->loop_subscribers[loop->index], 1, __ATOMIC_RELAXED);
+
+    // Catch up before the producer's next delivery reaches this loop
+    stream_frame_t* catch_up[STREAM_REPLAY_RING_SIZE];
+    size_t count = stream_collect_catch_up(stream, options, previous == 0, catch_up);
+    for (size_t i = 0; i < count; i++) {
+        sub->last_event_id = catch_up[i]->id;
+        stream_frame_t* frame = subscription_render(sub, catch_up[i]);
+        stream_frame_release(catch_up[i]);
+        if (frame) {
+            connection_send_frame(conn, frame, stream->index);
+            stream_frame_release(frame);
+        }
+    }
+    if (count > 0 && sub->min_interval_ms > 0) sub->next_due_ms = stream_now_ms() + sub->min_interval_ms;
+
+    if (previous == 0) {
+        // First subscriber: the owner loop starts sampling and fires immediately
+        stream_loop_t* owner = stream_owner_loop(stream);
+        if (owner == loop) {
+            stream_producer_start(loop, stream);
+        } else {
+            loop_post(owner, stream_producer_start, stream);
+        }
+    }
+    return true;
+}
+
+// Frames a new subscriber gets before live delivery, oldest first (references
+// owned by the caller). A resuming client gets every ring event after its
+// Last-Event-ID, or only the newest when it is throttled; an id from before a
+// restart counts as a fresh start. Otherwise a stream that is already running
+// hands over its latest sample, while a first subscriber waits for the
+// immediate tick.
+static size_t stream_collect_catch_up(stream_function_entry_t* stream, const stream_subscribe_options_t* options,
+                                      bool first, stream_frame_t** frames) {
+    size_t count = 0;
+
+    pthread_mutex_lock(&stream->latest_mutex);
+    uint64_t newest = stream->latest ? stream->latest->id : 0;
+    if (options->resume && options->last_event_id <= newest) {
+        uint64_t from = options->last_event_id + 1;
+        if (newest >= STREAM_REPLAY_RING_SIZE && from <= newest - STREAM_REPLAY_RING_SIZE) {
+            from = newest - STREAM_REPLAY_RING_SIZE + 1;
+        }
+        if (options->min_interval_ms > 0 && from <= newest) from = newest;
+
+        for (uint64_t id = from; id <= newest; id++) {
+            stream_frame_t* frame = stream->replay[id % STREAM_REPLAY_RING_SIZE];
+            if (frame && frame->id == id) frames[count++] = stream_frame_retain(frame);
+        }
+    } else if (!first && stream->latest) {
+        frames[count++] = stream_frame_retain(stream->latest);
+    }
+    pthread_mutex_unlock(&stream->latest_mutex);
+    return count;
+}
+
+// Detach a connection from one stream (no-op if it is not subscribed)
+static void connection_unsubscribe(stream_connection_t* conn, stream_function_entry_t* stream) {
+    for (stream_subscription_t** link = &conn->subscriptions; *link; link = &(*link)->conn_next) {
+        stream_subscription_t* sub = *link;
+        if (sub->stream == stream) {
+            *link = sub->conn_next;
+            subscription_detach(conn->loop, sub);
+            return;
+        }
+    }
+}
+
+// Detach a connection from every stream it is subscribed to
+static void connection_unsubscribe_all(stream_connection_t* conn) {
+    while (conn->subscriptions) {
+        stream_subscription_t* sub = conn->subscriptions;
+        conn->subscriptions = sub->conn_next;
+        subscription_detach(conn->loop, sub);
+    }
+}
+
+// A stored "data" frame in the subscription's wire format (new reference, NULL on failure).
+// The producer renders the other formats only while someone uses them, so catch-up
+// frames taken from latest or the replay ring are converted here.
+static stream_frame_t* subscription_render(const stream_subscription_t* sub, stream_frame_t* frame) {
+    if (sub->websocket) {
+        return render_ws_event(sub->stream, frame->id, frame->payload, frame->payload_length);
+    }
+    if (sub->tagged) {
+        return stream_frame_create_sse(sub->stream->name, frame->id, frame->payload, frame->payload_length);
+    }
+    return stream_frame_retain(frame);
+}
+
+// Remove a subscription (already off its connection's list) from the loop and free it
+static void subscription_detach(stream_loop_t* loop, stream_subscription_t* sub) {
+    if (sub->prev) {
+        sub->prev->next = sub->next;
+    } else {
+        loop->subscribers[sub->stream->index] = sub->next;
+    }
+    if (sub->next) sub->next->prev = sub->prev;
+
+    __atomic_sub_fetch(&sub->stream->loop_subscribers[loop->index], 1, __ATOMIC_RELAXED);
+    if (sub->delta) __atomic_sub_fetch(&sub->stream->delta_subscribers, 1, __ATOMIC_RELAXED);
+    if (sub->websocket) __atomic_sub_fetch(&sub->stream->websocket_subscribers, 1, __ATOMIC_RELAXED);
+    if (sub->tagged) __atomic_sub_fetch(&sub->stream->tagged_subscribers, 1, __ATOMIC_RELAXED);
+    stream_release_subscriber(sub->stream);
+    free(sub);
+}
+
+// Loop that runs a stream's producer
+static stream_loop_t* stream_owner_loop(const stream_function_entry_t* stream) {
+    streaming_server_t* server = g_streaming_server;
+    return &server->loops[stream->index % server->loop_count];
+}
+
+// Reset producer bookkeeping before the loops start
+static void stream_reset_producers(void) {
+    for (int i = 0; i < g_stream_function_count; i++) {
+        stream_function_entry_t* stream = &g_stream_functions[i];
+        stream_timer_init(&stream->producer_timer, stream_producer_tick, stream);
+        stream->producer_armed = false;
+        stream->subscriber_count = 0;
+        stream->delta_subscribers = 0;
+        stream->websocket_subscribers = 0;
+        stream->tagged_subscribers = 0;
+        stream->batch_count = 0;
+        memset(stream->loop_subscribers, 0, sizeof(stream->loop_subscribers));
+        // Samples published before a restart have no audience left
+        stream_discard_published(stream);
+    }
+}
+
+static bool stream_batching(const stream_function_entry_t* stream) {
+    return stream->batch_max_events > 1;
+}
+
+// Add a sample to the pending batch; true once the batch is due. The array is kept
+// closed after every sample so a flush sends batch_buffer as is.
+static bool stream_batch_append(stream_function_entry_t* stream, const char* data, size_t length,
+                                uint64_t now) {
+    // An empty sample would leave a hole in the array
+    if (length == 0) return false;
+
+    size_t needed = stream->batch_length + length + 2;     // '[' or ',' before, ']' after
+    if (stream->batch_count == 0) needed = length + 2;
+    if (needed > stream->batch_capacity) {
+        size_t capacity = stream->batch_capacity ? stream->batch_capacity : 4096;
+        while (capacity < needed) capacity *= 2;
+        char* buffer = realloc(stream->batch_buffer, capacity);
+        if (!buffer) {
+            // Drop this sample but do not hold back the ones already buffered
+            return stream->batch_count > 0;
+        }
+        stream->batch_buffer = buffer;
+        stream->batch_capacity = capacity;
+    }
+
+    if (stream->batch_count == 0) {
+        stream->batch_started_ms = now;
+        stream->batch_length = 0;
+    }
+    stream->batch_buffer[stream->batch_length++] = stream->batch_count == 0 ? '[' : ',';
+    memcpy(stream->batch_buffer + stream->batch_length, data, length);
+    stream->batch_length += length;
+    stream->batch_buffer[stream->batch_length] = ']';
+    stream->batch_count++;
+
+    return stream->batch_count >= stream->batch_max_events ||
+           (stream->batch_max_delay_ms > 0 &&
+            now - stream->batch_started_ms >= (uint64_t)stream->batch_max_delay_ms);
+}
+
+// Arm a stream's producer (runs on the owner loop)
+static void stream_producer_start(stream_loop_t* loop, void* arg) {
+    stream_function_entry_t* stream = (stream_function_entry_t*)arg;
+    if (!loop) return;
+
+    // A first subscriber gets no catch-up sample, so patches restart from a keyframe
+    // (even if the producer is still armed from the previous audience)
+    stream->delta_until_keyframe = 0;
+    if (stream->push || stream->producer_armed) return;
+
+    stream->producer_armed = true;
+    stream_timer_schedule(&loop->timers, &stream->producer_timer, stream_now_ms());
+}
+
+// Sample a stream into out. Legacy handlers are lent a fixed window of the buffer,
+// which is kept up to the terminator they wrote.
+static size_t stream_write_sample(stream_function_entry_t* stream, stream_buffer_t* out) {
+    if (stream->writer) {
+        size_t length = stream->writer(stream->name, out);
+        return length < out->length ? length : out->length;
+    }
+
+    char* window = stream_buffer_reserve(out, LEGACY_HANDLER_BUFFER_SIZE);
+    if (!window) return 0;
+    window[0] = '\0';
+    stream->handler(stream->name, window, LEGACY_HANDLER_BUFFER_SIZE);
+    const char* end = memchr(window, '\0', LEGACY_HANDLER_BUFFER_SIZE);
+    size_t length = end ? (size_t)(end - window) : LEGACY_HANDLER_BUFFER_SIZE - 1;
+    stream_buffer_commit(out, length);
+    return length;
+}
+
+// Producer tick: sample once, then emit the sample or add it to the pending batch
+static void stream_producer_tick(stream_timer_t* timer, void* user_data) {
+    stream_function_entry_t* stream = (stream_function_entry_t*)user_data;
+    stream_loop_t* owner = stream_owner_loop(stream);
+
+    if (__atomic_load_n(&stream->subscriber_count, __ATOMIC_ACQUIRE) == 0) {
+        // Samples buffered for the departed audience are not worth a late flush
+        stream->batch_count = 0;
+        stream->producer_armed = false;
+        return;
+    }
+
+    // Push streams only arm the timer to bound how long a partial batch waits
+    if (stream->push) {
+        stream->producer_armed = false;
+        if (stream->batch_count == 0) return;
+
+        uint64_t due = stream->batch_started_ms + (uint64_t)stream->batch_max_delay_ms;
+        if (stream_now_ms() >= due) {
+            stream_producer_emit(stream, "batch", stream->batch_buffer, stream->batch_length + 1);
+            stream->batch_count = 0;
+        } else {
+            // The batch that armed the timer was flushed full; wait for the newer one
+            stream->producer_armed = true;
+            stream_timer_schedule(&owner->timers, &stream->producer_timer, due);
+        }
+        return;
+    }
+
+    // Sample into the stream's reusable buffer; a failed allocation skips this tick
+    stream_buffer_reset(&stream->output);
+    size_t data_length = stream_write_sample(stream, &stream->output);
+    const char* data = stream->output.data ? stream->output.data : "";
+
+    if (stream->output.failed) {
+        printf("Stream %s: out of memory for sample, skipping\n", stream->name);
+    } else if (!stream_batching(stream)) {
+        stream_producer_emit(stream, "data", data, data_length);
+    } else if (stream_batch_append(stream, data, data_length, timer->deadline_ms)) {
+        stream_producer_emit(stream, "batch", stream->batch_buffer, stream->batch_length + 1);
+        stream->batch_count = 0;
+    }
+
+    // Next tick is anchored to the previous deadline so handler time does not drift it
+    stream_timer_schedule(&owner->timers, &stream->producer_timer,
+                          stream_timer_next_period(timer->deadline_ms,
+                                                   (uint64_t)stream->interval_ms,
+                                                   stream_now_ms()));
+}
+
+// Publish one sample to a push stream (any thread)
+bool streaming_publish(const char* stream_name, const char* payload, size_t length) {
+    streaming_server_t* server = g_streaming_server;
+    if (!stream_name || (!payload && length > 0) || !server || !server_is_running(server)) return false;
+
+    stream_http_view_t view = { stream_name, strlen(stream_name) };
+    stream_function_entry_t* stream = find_stream_by_name(view);
+    if (!stream || !stream->push) return false;
+
+    // Like polled streams, nothing is produced without an audience
+    if (__atomic_load_n(&stream->subscriber_count, __ATOMIC_ACQUIRE) == 0) return false;
+
+    // Bound the queue so a source outrunning the loop cannot exhaust memory
+    if (__atomic_add_fetch(&stream->publish_pending, 1, __ATOMIC_RELAXED) > STREAM_PUBLISH_MAX_PENDING) {
+        __atomic_sub_fetch(&stream->publish_pending, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    stream_published_t* sample = malloc(sizeof(stream_published_t) + length + 1);
+    if (!sample) {
+        __atomic_sub_fetch(&stream->publish_pending, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    sample->length = length;
+    if (length > 0) memcpy(sample->payload, payload, length);
+    sample->payload[length] = '\0';
+    stream_mpsc_push(&stream->publish_queue, &sample->node);
+
+    // One drain task covers every sample queued before it runs
+    if (!__atomic_exchange_n(&stream->publish_drain_posted, true, __ATOMIC_ACQ_REL)) {
+        loop_post(stream_owner_loop(stream), stream_drain_published, stream);
+    }
+    return true;
+}
+
+// Emit every sample published since the last drain, oldest first (owner loop)
+static void stream_drain_published(stream_loop_t* loop, void* arg) {
+    stream_function_entry_t* stream = (stream_function_entry_t*)arg;
+
+    // Cleared before popping: a publish that lands after this point posts the next drain.
+    // The exchange also makes every sample pushed before the last post visible.
+    (void)__atomic_exchange_n(&stream->publish_drain_posted, false, __ATOMIC_ACQ_REL);
+    if (!loop) return;
+
+    uint64_t now = stream_now_ms();
+    stream_mpsc_node_t* node;
+    while ((node = stream_mpsc_pop(&stream->publish_queue)) != NULL) {
+        stream_published_t* sample = (stream_published_t*)node;
+        __atomic_sub_fetch(&stream->publish_pending, 1, __ATOMIC_RELAXED);
+
+        if (!stream_batching(stream)) {
+            stream_producer_emit(stream, "data", sample->payload, sample->length);
+        } else if (stream_batch_append(stream, sample->payload, sample->length, now)) {
+            stream_producer_emit(stream, "batch", stream->batch_buffer, stream->batch_length + 1);
+            stream->batch_count = 0;
+        } else if (stream->batch_count == 1 && stream->batch_max_delay_ms > 0 && !stream->producer_armed) {
+            // No tick will come along, so the first sample of a batch sets its deadline
+            stream->producer_armed = true;
+            stream_timer_schedule(&loop->timers, &stream->producer_timer,
+                                  stream->batch_started_ms + (uint64_t)stream->batch_max_delay_ms);
+        }
+        free(sample);
+    }
+}
+
+// Free samples that will never be drained (loops stopped or not yet started)
+static void stream_discard_published(stream_function_entry_t* stream) {
+    stream_mpsc_node_t* node;
+    while ((node = stream_mpsc_pop(&stream->publish_queue)) != NULL) {
+        free(node);
+    }
+    stream->publish_pending = 0;
+    stream->publish_drain_posted = false;
+}
+
+// Render one event in every format in use, record it for catch-up and fan it out
+// to every loop with subscribers (owner loop only)
+static void stream_producer_emit(stream_function_entry_t* stream, const char* event_name,
+                                 const char* data, size_t data_length) {
+    streaming_server_t* server = g_streaming_server;
+    stream_loop_t* owner = stream_owner_loop(stream);
+
+    uint64_t id = stream->events_produced + 1;
+    stream_frame_t* frame = stream_frame_create_sse(event_name, id, data, data_length);
+    if (!frame) return;
+    __atomic_add_fetch(&stream->events_produced, 1, __ATOMIC_RELAXED);
+
+    // Patch against the previous sample for delta subscribers; latest is only
+    // replaced on this loop, so reading it here needs no lock
+    stream_frame_t* patch = NULL;
+    if (stream->delta_keyframe_interval > 0 && !stream_batching(stream) &&
+        __atomic_load_n(&stream->delta_subscribers, __ATOMIC_RELAXED) > 0) {
+        if (stream->delta_until_keyframe > 0 && stream->latest) {
+            // A patch is only sent when smaller than the sample, so that much room is enough
+            stream_buffer_reset(&stream->patch);
+            char* out = stream_buffer_reserve(&stream->patch, data_length);
+            size_t patch_length = out ? stream_delta_encode(stream->latest->payload,
+                                                            stream->latest->payload_length,
+                                                            data, data_length, out, data_length) : 0;
+            if (patch_length > 0) {
+                stream_buffer_commit(&stream->patch, patch_length);
+                patch = stream_frame_create_sse("patch", id, stream->patch.data, stream->patch.length);
+            }
+            stream->delta_until_keyframe--;
+        } else {
+            stream->delta_until_keyframe = stream->delta_keyframe_interval - 1;
+        }
+    }
+
+    stream_frame_t* ws_frame = NULL;
+    if (__atomic_load_n(&stream->websocket_subscribers, __ATOMIC_RELAXED) > 0) {
+        ws_frame = render_ws_event(stream, id, data, data_length);
+    }
+    stream_frame_t* tagged = NULL;
+    if (__atomic_load_n(&stream->tagged_subscribers, __ATOMIC_RELAXED) > 0) {
+        tagged = stream_frame_create_sse(stream->name, id, data, data_length);
+    }
+
+    pthread_mutex_lock(&stream->latest_mutex);
+    stream_frame_t* previous = stream->latest;
+    stream->latest = stream_frame_retain(frame);
+    stream_frame_t** slot = &stream->replay[id % STREAM_REPLAY_RING_SIZE];
+    stream_frame_t* evicted = *slot;
+    *slot = stream_frame_retain(frame);
+    pthread_mutex_unlock(&stream->latest_mutex);
+    stream_frame_release(previous);
+    stream_frame_release(evicted);
+
+    for (int i = 0; i < server->loop_count; i++) {
+        if (__atomic_load_n(&stream->loop_subscribers[i], __ATOMIC_RELAXED) == 0) continue;
+
+        stream_delivery_t* delivery = malloc(sizeof(stream_delivery_t));
+        if (!delivery) continue;
+        delivery->stream = stream;
+        delivery->frame = stream_frame_retain(frame);
+        delivery->patch = stream_frame_retain(patch);
+        delivery->ws_frame = stream_frame_retain(ws_frame);
+        delivery->tagged = stream_frame_retain(tagged);
+
+        if (&server->loops[i] == owner) {
+            stream_deliver(owner, delivery);
+        } else {
+            loop_post(&server->loops[i], stream_deliver, delivery);
+        }
+    }
+    stream_frame_release(tagged);
+    stream_frame_release(ws_frame);
+    stream_frame_release(patch);
+    stream_frame_release(frame);
+}
+
+// Queue a shared frame for this loop's subscribers of a stream
+static void stream_deliver(stream_loop_t* loop, void* arg) {
+    stream_delivery_t* delivery = (stream_delivery_t*)arg;
+
+    if (loop) {
+        uint64_t now = stream_now_ms();
+        stream_subscription_t* sub = loop->subscribers[delivery->stream->index];
+        while (sub) {
+            // A failed write closes the connection and frees its subscription
+            stream_subscription_t* next = sub->next;
+
+            // Already sent as catch-up when the subscription started
+            if (delivery->frame->id <= sub->last_event_id) {
+                sub = next;
+                continue;
+            }
+            if (sub->min_interval_ms > 0) {
+                if (now < sub->next_due_ms) {
+                    sub = next;
+                    continue;
+                }
+                // Anchored to the previous due time so the average rate matches the request
+                sub->next_due_ms = stream_timer_next_period(sub->next_due_ms ? sub->next_due_ms : now,
+                                                            sub->min_interval_ms, now);
+            }
+
+            // A backed-up connection may coalesce or drop what it has queued, which
+            // would break the patch chain, so it gets self-contained keyframes instead
+            stream_frame_t* frame = delivery->frame;
+            // Alternate formats are NULL if the subscription arrived after the producer rendered them
+            if (sub->websocket) {
+                frame = delivery->ws_frame;
+            } else if (sub->tagged) {
+                frame = delivery->tagged;
+            } else if (sub->delta && delivery->patch && sub->conn->backlog_since_ms == 0) {
+                frame = delivery->patch;
+            }
+            sub->last_event_id = delivery->frame->id;
+            if (frame) connection_send_frame(sub->conn, frame, delivery->stream->index);
+            sub = next;
+        }
+    }
+
+    stream_frame_release(delivery->tagged);
+    stream_frame_release(delivery->ws_frame);
+    stream_frame_release(delivery->patch);
+    stream_frame_release(delivery->frame);
+    free(delivery);
+}
+
+// Binary WebSocket message for one sample: a MessagePack map
+// {type, stream, id, timestamp, data} with the handler's JSON re-encoded
+static stream_frame_t* render_ws_event(const stream_function_entry_t* stream, uint64_t id,
+                                       const char* data, size_t length) {
+    // A JSON number can grow to a 9-byte float64; nothing else grows more than its header
+    size_t capacity = STREAM_WS_MAX_HEADER + length * 3 + 256;
+    char* buffer = malloc(capacity);
+    if (!buffer) return NULL;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t timestamp_ms = (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+
+    // Encode after a gap for the frame header, then place the header right before the payload
+    stream_msgpack_writer_t writer;
+    stream_msgpack_init(&writer, buffer + STREAM_WS_MAX_HEADER, capacity - STREAM_WS_MAX_HEADER);
+    stream_msgpack_map(&writer, 5);
+    stream_msgpack_str(&writer, "type", 4);
+    if (stream_batching(stream)) {
+        stream_msgpack_str(&writer, "batch", 5);
+    } else {
+        stream_msgpack_str(&writer, "data", 4);
+    }
+    stream_msgpack_str(&writer, "stream", 6);
+    stream_msgpack_str(&writer, stream->name, strlen(stream->name));
+    stream_msgpack_str(&writer, "id", 2);
+    stream_msgpack_uint(&writer, id);
+    stream_msgpack_str(&writer, "timestamp", 9);
+    stream_msgpack_uint(&writer, timestamp_ms);
+    stream_msgpack_str(&writer, "data", 4);
+    if (!stream_msgpack_json(&writer, data, length)) {
+        // Handlers that emit plain text still get through, as a string
+        stream_msgpack_str(&writer, data, length);
+    }
+
+    stream_frame_t* frame = NULL;
+    if (!writer.overflow) {
+        char header[STREAM_WS_MAX_HEADER];
+        size_t header_length = stream_ws_frame_header(STREAM_WS_OP_BINARY, writer.length, header);
+        char* start = buffer + STREAM_WS_MAX_HEADER - header_length;
+        memcpy(start, header, header_length);
+        frame = stream_frame_create_raw(start, header_length + writer.length);
+    }
+    free(buffer);
+    return frame;
+}
+
+// Handle one parsed HTTP request
+static void handle_http_request(stream_connection_t* conn, const stream_http_request_t* request) {
+    printf("HTTP Request: %.*s %.*s from %s:%d\n",
+           (int)request->method.length, request->method.data,
+           (int)request->target.length, request->target.data,
+           conn->client_ip, conn->client_port);
+
+    conn->keep_alive = request->keep_alive;
+
+    // Only handle GET requests
+    if (!stream_http_view_equals(request->method, "GET")) {
+        connection_respond(conn, "405 Method Not Allowed", "text/plain", "Method Not Allowed");
+        return;
+    }
+
+    const stream_http_view_t* upgrade = stream_http_find_header(request, "Upgrade");
+    if (upgrade && stream_http_view_has_token(*upgrade, "websocket")) {
+        handle_ws_upgrade(conn, request);
+        return;
+    }
+
+    stream_http_view_t path = request->path;
+    if (stream_http_view_equals(path, "/stats")) {
+        respond_stats(conn);
+        return;
+    }
+    if (stream_http_view_equals(path, "/streams")) {
+        respond_stream_list(conn);
+        return;
+    }
+    if (stream_http_view_equals(path, "/connections")) {
+        respond_connection_list(conn);
+        return;
+    }
+    if (path.length > 9 && memcmp(path.data, "/streams/", 9) == 0) {
+        stream_http_view_t name = { path.data + 9, path.length - 9 };
+        respond_stream_snapshot(conn, name);
+        return;
+    }
+
+    if (stream_http_view_equals(path, MULTI_STREAM_ENDPOINT)) {
+        handle_multi_subscribe(conn, request);
+        return;
+    }
+
+    // Find stream function for this endpoint
+    stream_function_entry_t* stream_func = find_stream_function(path);
+    if (!stream_func) {
+        connection_respond(conn, "404 Not Found", "text/plain", "Stream not found");
+        return;
+    }
+
+    if (!stream_func->enabled) {
+        connection_respond(conn, "503 Service Unavailable", "text/plain", "Stream disabled");
+        return;
+    }
+
+    stream_subscribe_options_t options;
+    if (!parse_subscribe_options(request->query, stream_func, &options)) {
+        connection_respond(conn, "400 Bad Request", "text/plain",
+                           "interval_ms must be 1-3600000 and max_rate 1-1000");
+        return;
+    }
+
+    // EventSource sends the header on its own reconnects; the query form is for fresh ones
+    const stream_http_view_t* last_event_id = stream_http_find_header(request, "Last-Event-ID");
+    stream_http_view_t query_last_event_id;
+    if (!last_event_id && stream_http_query_param(request->query, "last_event_id", &query_last_event_id)) {
+        last_event_id = &query_last_event_id;
+    }
+    unsigned long resume_id;
+    if (last_event_id && stream_http_view_to_uint(*last_event_id, ULONG_MAX, &resume_id)) {
+        options.resume = true;
+        options.last_event_id = resume_id;
+    }
+
+    // Claim a subscriber slot before committing to a 200
+    int previous = stream_reserve_subscriber(stream_func);
+    if (previous < 0) {
+        stats_add(&conn->loop->stats.rejected_subscriptions, 1);
+        connection_respond_busy(conn, "Stream at capacity");
+        return;
+    }
+
+    connection_start_event_stream(conn);
+
+    if (!conn->active) {
+        stream_release_subscriber(stream_func);
+    } else if (!connection_subscribe(conn, stream_func, previous, &options)) {
+        connection_close(conn);
+    }
+}
+
+// Switch to streaming: SSE headers, with a retry: hint so reconnects after an
+// outage do not all land at once, then heartbeats instead of the request timeout
+static void connection_start_event_stream(stream_connection_t* conn) {
+    char sse_headers[256];
+    int length = snprintf(sse_headers, sizeof(sse_headers),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "\r\n");
+    int retry_ms = loop_retry_hint(conn->loop);
+    if (retry_ms > 0) {
+        length += snprintf(sse_headers + length, sizeof(sse_headers) - (size_t)length, "retry: %d\n\n", retry_ms);
+    }
+
+    __atomic_store_n(&conn->state, STREAM_CONN_STREAMING, __ATOMIC_RELAXED);
+    connection_write(conn, sse_headers, (size_t)length);
+    connection_start_heartbeat(conn);
+}
+
+// GET /stream/multi?s=name,name,...: several streams interleaved on one SSE
+// response, each event named after its stream ("event: system.memory").
+// Streams may be given by name or endpoint; rate options apply to all of them.
+static void handle_multi_subscribe(stream_connection_t* conn, const stream_http_request_t* request) {
+    stream_function_entry_t* streams[MAX_STREAM_FUNCTIONS];
+    int previous[MAX_STREAM_FUNCTIONS];
+    int count = 0;
+
+    stream_http_view_t list;
+    if (!stream_http_query_param(request->query, "s", &list) || list.length == 0) {
+        connection_respond(conn, "400 Bad Request", "text/plain", "s must list stream names");
+        return;
+    }
+
+    // Comma separated, literal or percent-encoded
+    size_t start = 0;
+    while (start <= list.length) {
+        size_t end = start;
+        size_t separator = 0;
+        while (end < list.length) {
+            if (list.data[end] == ',') {
+                separator = 1;
+                break;
+            }
+            if (list.data[end] == '%' && end + 2 < list.length && list.data[end + 1] == '2' &&
+                (list.data[end + 2] == 'C' || list.data[end + 2] == 'c')) {
+                separator = 3;
+                break;
+            }
+            end++;
+        }
+
+        stream_http_view_t name = { list.data + start, end - start };
+        start = end + (separator ? separator : 1);
+        if (name.length == 0) continue;
+
+        stream_function_entry_t* stream = name.data[0] == '/' ? find_stream_function(name) : find_stream_by_name(name);
+        if (!stream) {
+            connection_respond(conn, "404 Not Found", "text/plain", "Stream not found");
+            return;
+        }
+        if (!stream->enabled) {
+            connection_respond(conn, "503 Service Unavailable", "text/plain", "Stream disabled");
+            return;
+        }
+
+        bool duplicate = false;
+        for (int i = 0; i < count; i++) {
+            if (streams[i] == stream) duplicate = true;
+        }
+        if (!duplicate) streams[count++] = stream;
+    }
+    if (count == 0) {
+        connection_respond(conn, "400 Bad Request", "text/plain", "s must list stream names");
+        return;
+    }
+
+    // Patches and resume ids are per stream, so a shared response only carries full samples
+    stream_subscribe_options_t options;
+    if (!parse_subscribe_options(request->query, streams[0], &options)) {
+        connection_respond(conn, "400 Bad Request", "text/plain",
+                           "interval_ms must be 1-3600000 and max_rate 1-1000");
+        return;
+    }
+    options.delta = false;
+    options.tagged = true;
+
+    // All or nothing: a capped stream refuses the whole request
+    for (int i = 0; i < count; i++) {
+        previous[i] = stream_reserve_subscriber(streams[i]);
+        if (previous[i] < 0) {
+            while (i-- > 0) stream_release_subscriber(streams[i]);
+            stats_add(&conn->loop->stats.rejected_subscriptions, 1);
+            connection_respond_busy(conn, "Stream at capacity");
+            return;
+        }
+    }
+
+    connection_start_event_stream(conn);
+
+    for (int i = 0; i < count; i++) {
+        if (!conn->active) {
+            stream_release_subscriber(streams[i]);
+        } else if (!connection_subscribe(conn, streams[i], previous[i], &options)) {
+            connection_close(conn);
+        }
+    }
+}
+
+// RFC 6455 opening handshake on / or /ws; the connection then carries any number
+// of stream subscriptions managed through JSON control messages
+static void handle_ws_upgrade(stream_connection_t* conn, const stream_http_request_t* request) {
+    if (!stream_http_view_equals(request->path, "/") && !stream_http_view_equals(request->path, "/ws")) {
+        connection_respond(conn, "404 Not Found", "text/plain", "WebSocket endpoint is /ws");
+        return;
+    }
+
+    const stream_http_view_t* connection = stream_http_find_header(request, "Connection");
+    const stream_http_view_t* version = stream_http_find_header(request, "Sec-WebSocket-Version");
+    const stream_http_view_t* key = stream_http_find_header(request, "Sec-WebSocket-Key");
+    if (!version || !stream_http_view_equals(*version, "13")) {
+        connection_respond_headers(conn, "426 Upgrade Required", "text/plain",
+                                   "Sec-WebSocket-Version: 13\r\n", "Unsupported WebSocket version");
+        return;
+    }
+
+    char accept[STREAM_WS_ACCEPT_SIZE];
+    if (!connection || !stream_http_view_has_token(*connection, "upgrade") || !key ||
+        !stream_ws_accept_key(*key, accept)) {
+        connection_respond(conn, "400 Bad Request", "text/plain", "Invalid WebSocket handshake");
+        return;
+    }
+
+    char response[256];
+    int length = snprintf(response, sizeof(response),
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: %s\r\n"
+            "\r\n",
+            accept);
+
+    __atomic_store_n(&conn->state, STREAM_CONN_WEBSOCKET, __ATOMIC_RELAXED);
+    conn->ws_message_length = 0;
+    conn->ws_in_message = false;
+    connection_write(conn, response, (size_t)length);
+    connection_start_heartbeat(conn);
+}
+
+// Render counters as a JSON object; returns the length written
+static size_t format_stats_json(const streaming_stats_t* stats, char* out, size_t size) {
+    int length = snprintf(out, size,
+             "{\"connections\":%d,\"connections_accepted\":%llu,\"queued_frames\":%llu,"
+             "\"queued_bytes\":%llu,\"queue_high_water\":%llu,\"frames_sent\":%llu,"
+             "\"frames_dropped\":%llu,\"frames_coalesced\":%llu,\"slow_disconnects\":%llu,"
+             "\"rejected_connections\":%llu,\"rejected_subscriptions\":%llu}",
+             stats->connections, (unsigned long long)stats->connections_accepted,
+             (unsigned long long)stats->queued_frames, (unsigned long long)stats->queued_bytes,
+             (unsigned long long)stats->queue_high_water, (unsigned long long)stats->frames_sent,
+             (unsigned long long)stats->frames_dropped, (unsigned long long)stats->frames_coalesced,
+             (unsigned long long)stats->slow_disconnects,
+             (unsigned long long)stats->rejected_connections,
+             (unsigned long long)stats->rejected_subscriptions);
+    if (length < 0) return 0;
+    return (size_t)length < size ? (size_t)length : size - 1;
+}
+
+// GET /stats: server totals plus one entry per shard
+static void respond_stats(stream_connection_t* conn) {
+    char body[512 * (STREAM_MAX_LOOPS + 1)];
+    streaming_stats_t stats;
+
+    streaming_get_stats(&stats);
+    size_t length = (size_t)snprintf(body, sizeof(body), "{\"total\":");
+    length += format_stats_json(&stats, body + length, sizeof(body) - length);
+    length += (size_t)snprintf(body + length, sizeof(body) - length, ",\"shards\":[");
+
+    int shards = streaming_get_shard_count();
+    for (int i = 0; i < shards; i++) {
+        streaming_get_shard_stats(i, &stats);
+        if (i > 0) body[length++] = ',';
+        length += format_stats_json(&stats, body + length, sizeof(body) - length);
+    }
+    snprintf(body + length, sizeof(body) - length, "]}");
+
+    connection_respond(conn, "200 OK", "application/json", body);
+}
+
+// Output buffer for respond_connection_list, grown as the registry is walked
+typedef struct {
+    char* body;
+    size_t length;
+    size_t capacity;
+    int count;
+    bool failed;
+} stream_connection_list_t;
+
+static void append_connection_info(const stream_connection_info_t* info, void* arg) {
+    stream_connection_list_t* list = (stream_connection_list_t*)arg;
+    if (list->failed) return;
+
+    // Worst case entry is well under 256 bytes
+    if (list->capacity - list->length < 256) {
+        size_t capacity = list->capacity * 2;
+        char* grown = realloc(list->body, capacity);
+        if (!grown) {
+            list->failed = true;
+            return;
+        }
+        list->body = grown;
+        list->capacity = capacity;
+    }
+
+    list->length += (size_t)snprintf(list->body + list->length, list->capacity - list->length,
+            "%s{\"client\":\"%s:%d\",\"shard\":%d,\"state\":\"%s\","
+            "\"events_sent\":%llu,\"age_ms\":%llu}",
+            list->count > 0 ? "," : "", info->client_ip, info->client_port, info->shard,
+            info->websocket ? "websocket" : info->streaming ? "streaming" : "request",
+            (unsigned long long)info->events_sent,
+            (unsigned long long)(stream_now_ms() - info->connected_ms));
+    list->count++;
+}
+
+// GET /connections: every open connection across all shards
+static void respond_connection_list(stream_connection_t* conn) {
+    stream_connection_list_t list = { malloc(4096), 1, 4096, 0, false };
+    if (!list.body) {
+        connection_respond(conn, "500 Internal Server Error", "text/plain", "Out of memory");
+        return;
+    }
+    list.body[0] = '[';
+
+    streaming_for_each_connection(append_connection_info, &list);
+    if (list.failed) {
+        free(list.body);
+        connection_respond(conn, "500 Internal Server Error", "text/plain", "Out of memory");
+        return;
+    }
+    snprintf(list.body + list.length, list.capacity - list.length, "]");
+
+    connection_respond(conn, "200 OK", "application/json", list.body);
+    free(list.body);
+}
+
+// Append text as a JSON string literal; returns the new length
+static size_t json_append_string(char* out, size_t size, size_t length, const char* text) {
+    if (length + 1 < size) out[length++] = '"';
+    for (const char* c = text; *c && length + 7 < size; c++) {
+        if (*c == '"' || *c == '\\') {
+            out[length++] = '\\';
+            out[length++] = *c;
+        } else if ((unsigned char)*c < 0x20) {
+            length += (size_t)snprintf(out + length, size - length, "\\u%04x", (unsigned char)*c);
+        } else {
+            out[length++] = *c;
+        }
+    }
+    if (length + 1 < size) out[length++] = '"';
+    out[length] = '\0';
+    return length;
+}
+
+// GET /streams: registered streams and their producer state
+static void respond_stream_list(stream_connection_t* conn) {
+    // Worst case per stream: every character of name, endpoint and description escaped
+    size_t size = (6 * (64 + 128 + 256) + 320) * MAX_STREAM_FUNCTIONS + 2;
+    char* body = malloc(size);
+    if (!body) {
+        connection_respond(conn, "500 Internal Server Error", "text/plain", "Out of memory");
+        return;
+    }
+
+    size_t length = (size_t)snprintf(body, size, "[");
+    pthread_mutex_lock(&g_functions_mutex);
+    for (int i = 0; i < g_stream_function_count; i++) {
+        const stream_function_entry_t* stream = &g_stream_functions[i];
+        if (i > 0) body[length++] = ',';
+        length += (size_t)snprintf(body + length, size - length, "{\"name\":");
+        length = json_append_string(body, size, length, stream->name);
+        length += (size_t)snprintf(body + length, size - length, ",\"endpoint\":");
+        length = json_append_string(body, size, length, stream->endpoint);
+        length += (size_t)snprintf(body + length, size - length, ",\"description\":");
+        length = json_append_string(body, size, length, stream->description);
+        length += (size_t)snprintf(body + length, size - length,
+                                   ",\"interval_ms\":%d,\"enabled\":%s,\"subscribers\":%d,"
+                                   "\"delta_keyframe_interval\":%d,\"batch_max_events\":%d,"
+                                   "\"batch_max_delay_ms\":%d,\"push\":%s,\"events_produced\":%llu}",
+                                   stream->interval_ms, stream->enabled ? "true" : "false",
+                                   __atomic_load_n(&stream->subscriber_count, __ATOMIC_RELAXED),
+                                   stream->delta_keyframe_interval, stream->batch_max_events,
+                                   stream->batch_max_delay_ms, stream->push ? "true" : "false",
+                                   (unsigned long long)__atomic_load_n(&stream->events_produced,
+                                                                       __ATOMIC_RELAXED));
+    }
+    pthread_mutex_unlock(&g_functions_mutex);
+    snprintf(body + length, size - length, "]");
+
+    connection_respond(conn, "200 OK", "application/json", body);
+    free(body);
+}
+
+// GET /streams/<name>: the stream's most recent sample (null before the first one)
+static void respond_stream_snapshot(stream_connection_t* conn, stream_http_view_t name) {
+    stream_function_entry_t* stream = find_stream_by_name(name);
+    if (!stream) {
+        connection_respond(conn, "404 Not Found", "text/plain", "Stream not found");
+        return;
+    }
+
+    pthread_mutex_lock(&stream->latest_mutex);
+    stream_frame_t* latest = stream_frame_retain(stream->latest);
+    pthread_mutex_unlock(&stream->latest_mutex);
+
+    connection_respond(conn, "200 OK", "application/json", latest ? latest->payload : "null");
+    stream_frame_release(latest);
+}
+
+// Map the configured slow-consumer policy name to its enum
+static stream_slow_consumer_policy_t resolve_slow_consumer_policy(const char* name) {
+    if (strcmp(name, "coalesce") == 0) return STREAM_SLOW_COALESCE;
+    if (strcmp(name, "disconnect") == 0) return STREAM_SLOW_DISCONNECT;
+    if (strcmp(name, "drop_oldest") != 0) {
+        printf("Unknown slow_consumer_policy '%s', using drop_oldest\n", name);
+    }
+    return STREAM_SLOW_DROP_OLDEST;
+}
+
+// Find stream function by endpoint (lock-free; entries are published through the route table)
+static stream_function_entry_t* find_stream_function(stream_http_view_t endpoint) {
+    int index = stream_route_lookup(&g_endpoint_routes, endpoint);
+    return index >= 0 ? &g_stream_functions[index] : NULL;
+}
+
+// Find stream function by name
+static stream_function_entry_t* find_stream_by_name(stream_http_view_t name) {
+    int index = stream_route_lookup(&g_name_routes, name);
+    return index >= 0 ? &g_stream_functions[index] : NULL;
+}
+
+// Per-subscriber rate from ?interval_ms=N or ?max_rate=N (events per second);
+// the slower of the two wins. Subscribers can only thin the shared producer's samples.
+// ?delta=1 asks for patches when the stream has delta mode enabled.
+static bool parse_subscribe_options(stream_http_view_t query, const stream_function_entry_t* stream,
+                                    stream_subscribe_options_t* options) {
+    stream_http_view_t interval_ms;
+    stream_http_view_t max_rate;
+    stream_http_view_t value;
+
+    options->delta = false;
+    options->websocket = false;
+    options->tagged = false;
+    options->resume = false;
+    options->last_event_id = 0;
+    if (!parse_subscription_rate(stream_http_query_param(query, "interval_ms", &interval_ms) ? &interval_ms : NULL,
+                                 stream_http_query_param(query, "max_rate", &max_rate) ? &max_rate : NULL,
+                                 &options->min_interval_ms)) {
+        return false;
+    }
+
+    // Patches only chain across consecutive samples, so thinned subscriptions stay on keyframes
+    if (stream_http_query_param(query, "delta", &value)) {
+        options->delta = !stream_http_view_equals(value, "0") && !stream_http_view_equals(value, "false") &&
+                         stream->delta_keyframe_interval > 0 && !stream_batching(stream) &&
+                         options->min_interval_ms == 0;
+    }
+    return true;
+}
+
+// Minimum spacing from interval_ms and/or max_rate (NULL when not given)
+static bool parse_subscription_rate(const stream_http_view_t* interval_ms, const stream_http_view_t* max_rate,
+                                    uint64_t* min_interval_ms) {
+    unsigned long number;
+
+    *min_interval_ms = 0;
+    if (interval_ms) {
+        if (!stream_http_view_to_uint(*interval_ms, MAX_SUBSCRIPTION_INTERVAL_MS, &number) || number == 0) {
+            return false;
+        }
+        *min_interval_ms = number;
+    }
+    if (max_rate) {
+        if (!stream_http_view_to_uint(*max_rate, MAX_SUBSCRIPTION_RATE, &number) || number == 0) {
+            return false;
+        }
+        uint64_t interval = (1000 + number - 1) / number;
+        if (interval > *min_interval_ms) *min_interval_ms = interval;
+    }
+    return true;
+}
+
+// Register stream function
+void streaming_register_function(const char* name, const char* endpoint,
+                                int interval_ms, stream_handler_t handler,
+                                const char* description) {
+    if (!handler) {
+        printf("Invalid parameters for stream function registration\n");
+        return;
+    }
+    register_stream_entry(name, endpoint, interval_ms, handler, NULL, description);
+}
+
+// Register stream function that writes into a growable buffer
+void streaming_register_writer(const char* name, const char* endpoint,
+                               int interval_ms, stream_writer_t writer,
+                               const char* description) {
+    if (!writer) {
+        printf("Invalid parameters for stream function registration\n");
+        return;
+    }
+    register_stream_entry(name, endpoint, interval_ms, NULL, writer, description);
+}
+
+// Register a push stream fed by streaming_publish
+void streaming_register_source(const char* name, const char* endpoint, const char* description) {
+    register_stream_entry(name, endpoint, 0, NULL, NULL, description);
+}
+
+// Shared by every registration flavour; handler, writer or neither (push stream)
+static void register_stream_entry(const char* name, const char* endpoint, int interval_ms,
+                                  stream_handler_t handler, stream_writer_t writer,
+                                  const char* description) {
+    if (!name || !endpoint || !description) {
+        printf("Invalid parameters for stream function registration\n");
+        return;
+    }
+
+    pthread_mutex_lock(&g_functions_mutex);
+
+    if (g_stream_function_count >= MAX_STREAM_FUNCTIONS) {
+        printf("Maximum stream functions reached\n");
+        pthread_mutex_unlock(&g_functions_mutex);
+        return;
+    }
+
+    stream_http_view_t name_view = { name, strlen(name) };
+    stream_http_view_t endpoint_view = { endpoint, strlen(endpoint) };
+    if (stream_route_lookup(&g_name_routes, name_view) >= 0 ||
+        stream_route_lookup(&g_endpoint_routes, endpoint_view) >= 0) {
+        printf("Stream '%s' or endpoint %s is already registered\n", name, endpoint);
+        pthread_mutex_unlock(&g_functions_mutex);
+        return;
+    }
+
+    stream_function_entry_t* entry = &g_stream_functions[g_stream_function_count];
+
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+
+    strncpy(entry->endpoint, endpoint, sizeof(entry->endpoint) - 1);
+    entry->endpoint[sizeof(entry->endpoint) - 1] = '\0';
+
+    entry->push = !handler && !writer;
+    entry->interval_ms = entry->push ? 0 : (interval_ms > 0 ? interval_ms : 1);
+    entry->enabled = true;
+    entry->handler = handler;
+    entry->writer = writer;
+    stream_mpsc_init(&entry->publish_queue);
+    entry->publish_pending = 0;
+    entry->publish_drain_posted = false;
+    stream_buffer_init(&entry->output);
+    stream_buffer_init(&entry->patch);
+    entry->index = g_stream_function_count;
+    entry->producer_armed = false;
+    entry->subscriber_count = 0;
+    memset(entry->loop_subscribers, 0, sizeof(entry->loop_subscribers));
+    entry->events_produced = 0;
+    entry->max_subscribers = 0;
+    entry->delta_keyframe_interval = 0;
+    entry->delta_subscribers = 0;
+    entry->delta_until_keyframe = 0;
+    entry->batch_max_events = 0;
+    entry->batch_max_delay_ms = 0;
+    entry->batch_buffer = NULL;
+    entry->batch_length = 0;
+    entry->batch_capacity = 0;
+    entry->batch_count = 0;
+    entry->latest = NULL;
+    memset(entry->replay, 0, sizeof(entry->replay));
+    pthread_mutex_init(&entry->latest_mutex, NULL);
+    stream_timer_init(&entry->producer_timer, stream_producer_tick, entry);
+
+    strncpy(entry->description, description, sizeof(entry->description) - 1);
+    entry->description[sizeof(entry->description) - 1] = '\0';
+
+    // Publish only once the entry is complete; lookups do not take the mutex
+    stream_route_insert(&g_name_routes, entry->name, entry->index);
+    stream_route_insert(&g_endpoint_routes, entry->endpoint, entry->index);
+    g_stream_function_count++;
+
+    if (entry->push) {
+        printf("Registered push stream: %s -> %s\n", name, endpoint);
+    } else {
+        printf("Registered stream function: %s -> %s (%d ms)\n", name, endpoint, interval_ms);
+    }
+
+    pthread_mutex_unlock(&g_functions_mutex);
+}
+
+// Send HTTP response
+void streaming_send_http_response(int client_socket, const char* status,
+                                 const char* content_type, const char* body) {
+    char response[2048];
+    snprintf(response, sizeof(response),
+            "HTTP/1.1 %s\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n"
+            "\r\n"
+            "%s",
+            status, content_type, strlen(body), body);
+
+    send(client_socket, response, strlen(response), STREAM_SEND_FLAGS);
+    close(client_socket);
+}
+
+// Send SSE event
+void streaming_send_sse_event(int client_socket, const char* event_name,
+                             uint64_t id, const char* data) {
+    stream_frame_t* frame = stream_frame_create_sse(event_name, id, data, strlen(data));
+    if (!frame) {
+        printf("Failed to render SSE event\n");
+        return;
+    }
+
+    struct iovec iov[STREAM_FRAME_MAX_SEGMENTS];
+    int iov_count = stream_frame_segments(frame, 0, iov, STREAM_FRAME_MAX_SEGMENTS);
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+
+    ssize_t sent = sendmsg(client_socket, &msg, STREAM_SEND_FLAGS);
+    if (sent < 0) {
+        printf("Failed to send SSE event: %s\n", strerror(errno));
+    }
+    stream_frame_release(frame);
+}
+
+// Add one loop's counters into stats
+static void loop_collect_stats(stream_loop_t* loop, streaming_stats_t* stats) {
+    stats->connections += __atomic_load_n(&loop->connection_count, __ATOMIC_RELAXED);
+    stats->connections_accepted += __atomic_load_n(&loop->stats.connections_accepted, __ATOMIC_RELAXED);
+    stats->queued_frames += __atomic_load_n(&loop->stats.queued_frames, __ATOMIC_RELAXED);
+    stats->queued_bytes += __atomic_load_n(&loop->stats.queued_bytes, __ATOMIC_RELAXED);
+    uint64_t high_water = __atomic_load_n(&loop->stats.queue_high_water, __ATOMIC_RELAXED);
+    if (high_water > stats->queue_high_water) stats->queue_high_water = high_water;
+    stats->frames_sent += __atomic_load_n(&loop->stats.frames_sent, __ATOMIC_RELAXED);
+    stats->frames_dropped += __atomic_load_n(&loop->stats.frames_dropped, __ATOMIC_RELAXED);
+    stats->frames_coalesced += __atomic_load_n(&loop->stats.frames_coalesced, __ATOMIC_RELAXED);
+    stats->slow_disconnects += __atomic_load_n(&loop->stats.slow_disconnects, __ATOMIC_RELAXED);
+    stats->rejected_connections += __atomic_load_n(&loop->stats.rejected_connections, __ATOMIC_RELAXED);
+    stats->rejected_subscriptions += __atomic_load_n(&loop->stats.rejected_subscriptions, __ATOMIC_RELAXED);
+}
+
+// Sum the per-loop counters
+bool streaming_get_stats(streaming_stats_t* stats) {
+    if (!stats) return false;
+    memset(stats, 0, sizeof(*stats));
+
+    streaming_server_t* server = g_streaming_server;
+    if (!server || !server->loops || !server_is_running(server)) return false;
+
+    for (int i = 0; i < server->loop_count; i++) {
+        loop_collect_stats(&server->loops[i], stats);
+    }
+    return true;
+}
+
+// Number of shards (event loops) while the server is running
+int streaming_get_shard_count(void) {
+    streaming_server_t* server = g_streaming_server;
+    if (!server || !server->loops || !server_is_running(server)) return 0;
+    return server->loop_count;
+}
+
+// Counters of a single shard
+bool streaming_get_shard_stats(int shard, streaming_stats_t* stats) {
+    if (!stats) return false;
+    memset(stats, 0, sizeof(*stats));
+
+    if (shard < 0 || shard >= streaming_get_shard_count()) return false;
+    loop_collect_stats(&g_streaming_server->loops[shard], stats);
+    return true;
+}
+
+// Cap concurrent subscribers of a registered stream
+bool streaming_set_stream_max_subscribers(const char* name, int max_subscribers) {
+    if (!name) return false;
+
+    stream_http_view_t view = { name, strlen(name) };
+    stream_function_entry_t* stream = find_stream_by_name(view);
+    if (!stream) return false;
+
+    stream->max_subscribers = max_subscribers > 0 ? max_subscribers : 0;
+    return true;
+}
+
+// Turn delta mode on for a registered stream
+bool streaming_set_stream_delta(const char* name, int keyframe_interval) {
+    if (!name) return false;
+
+    stream_http_view_t view = { name, strlen(name) };
+    stream_function_entry_t* stream = find_stream_by_name(view);
+    if (!stream) return false;
+
+    stream->delta_keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 0;
+    return true;
+}
+
+// Turn micro-batching on for a registered stream (max_events <= 1 turns it off)
+bool streaming_set_stream_batch(const char* name, int max_events, int max_delay_ms) {
+    if (!name) return false;
+
+    stream_http_view_t view = { name, strlen(name) };
+    stream_function_entry_t* stream = find_stream_by_name(view);
+    if (!stream) return false;
+
+    stream->batch_max_events = max_events > 1 ? max_events : 0;
+    stream->batch_max_delay_ms = max_delay_ms > 0 ? max_delay_ms : 0;
+    return true;
+}
+
+// Publish a connection in its loop's registry shard (owner loop only)
+void streaming_add_connection(stream_connection_t* conn) {
+    if (!conn || !conn->loop) return;
+
+    stream_loop_t* loop = conn->loop;
+    stream_connection_t* head = loop->connections;
+
+    conn->loop_prev = NULL;
+    conn->loop_next = head;
+    if (head) head->loop_prev = conn;
+    __atomic_store_n(&loop->connections, conn, __ATOMIC_RELEASE);
+}
+
+// Unlink a connection from its shard and retire it (owner loop only). Its own
+// loop_next is left intact so a walker standing on it can still move on.
+void streaming_remove_connection(stream_connection_t* conn) {
+    if (!g_streaming_server || !conn || !conn->loop) return;
+
+    stream_loop_t* loop = conn->loop;
+    stream_connection_t* next = conn->loop_next;
+
+    if (conn->loop_prev) {
+        __atomic_store_n(&conn->loop_prev->loop_next, next, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&loop->connections, next, __ATOMIC_RELEASE);
+    }
+    if (next) next->loop_prev = conn->loop_prev;
+    conn->loop_prev = NULL;
+
+    conn->retired_epoch = stream_epoch_current(&g_streaming_server->registry_epoch);
+    conn->retire_next = loop->closed;
+    loop->closed = conn;
+}
+
+// Event loops close and reclaim their own connections on exit; only the
+// admission counter is left to reset
+void streaming_cleanup_connections(void) {
+    if (!g_streaming_server) return;
+    __atomic_store_n(&g_streaming_server->connection_count, 0, __ATOMIC_RELEASE);
+}
+
+// Walk every shard inside one epoch; loops keep accepting and closing meanwhile
+int streaming_for_each_connection(void (*visit)(const stream_connection_info_t* info, void* arg),
+                                  void* arg) {
+    streaming_server_t* server = g_streaming_server;
+    if (!visit || !server || !server->loops || !server_is_running(server)) return 0;
+
+    int visited = 0;
+    uint64_t token = stream_epoch_enter(&server->registry_epoch);
+    for (int i = 0; i < server->loop_count; i++) {
+        stream_connection_t* conn = __atomic_load_n(&server->loops[i].connections, __ATOMIC_ACQUIRE);
+        while (conn) {
+            if (__atomic_load_n(&conn->active, __ATOMIC_ACQUIRE)) {
+                stream_connection_info_t info;
+                memcpy(info.client_ip, conn->client_ip, sizeof(info.client_ip));
+                info.client_port = conn->client_port;
+                info.shard = i;
+                stream_connection_state_t state = __atomic_load_n(&conn->state, __ATOMIC_RELAXED);
+                info.streaming = state == STREAM_CONN_STREAMING || state == STREAM_CONN_WEBSOCKET;
+                info.websocket = state == STREAM_CONN_WEBSOCKET;
+                info.events_sent = __atomic_load_n(&conn->events_sent, __ATOMIC_RELAXED);
+                info.connected_ms = conn->connected_ms;
+                visit(&info, arg);
+                visited++;
+            }
+            conn = __atomic_load_n(&conn->loop_next, __ATOMIC_ACQUIRE);
+        }
+    }
+    stream_epoch_exit(&server->registry_epoch, token);
+    return visited;
+}
@@ -7,41 +7,195 @@
 #include <sys/socket.h>
 #include "config.h"
 #include "platform.h"
+#include "streaming_poll.h"
+#include "streaming_timer.h"
+#include "streaming_frame.h"
+#include "streaming_http.h"
+#include "streaming_epoch.h"
+#include "streaming_buffer.h"
+#include "streaming_mpsc.h"
 
-// Stream connection structure
+#define STREAM_MAX_LOOPS 16
+#define STREAM_REQUEST_BUFFER_SIZE 4096
+#define STREAM_REPLAY_RING_SIZE 64                // Events kept per stream for Last-Event-ID resume
+#define STREAM_PUBLISH_MAX_PENDING 4096           // Published samples waiting for the owner loop, per stream
+
+struct stream_loop;
+struct stream_function_entry;
+struct stream_zerocopy_pending;
+
+// What to do when a subscriber's send queue exceeds its bounds
+typedef enum {
+    STREAM_SLOW_DROP_OLDEST,          // Discard the oldest unsent events
+    STREAM_SLOW_COALESCE,             // Keep only the newest unsent event per stream
+    STREAM_SLOW_DISCONNECT            // Close once the backlog is older than slow_consumer_timeout_ms
+} stream_slow_consumer_policy_t;
+
+// Queued outbound frame; stream is -1 for protocol frames that must never be dropped
+typedef struct {
+    stream_frame_t* frame;
+    int stream;
+} stream_queued_frame_t;
+
+// Connection lifecycle state
+typedef enum {
+    STREAM_CONN_READING_REQUEST,      // Parsing requests (idle keep-alive connections included)
+    STREAM_CONN_STREAMING,            // Subscribed to an SSE stream
+    STREAM_CONN_WEBSOCKET,            // Upgraded; JSON control messages in, binary events out
+    STREAM_CONN_CLOSING               // Flushing a final response before close
+} stream_connection_state_t;
+
+// Stream connection structure (owned by exactly one event loop)
 typedef struct stream_connection {
     int socket;
     bool active;
-    pthread_t thread;
     char client_ip[16];
+    uint32_t client_addr;                        // IPv4 address, network order (per-IP cap key)
     uint16_t client_port;
-    struct stream_connection* next;
+    struct stream_loop* loop;                    // Owning event loop
+    stream_connection_state_t state;
+
+    // Inbound request bytes; parsed in place, pipelined requests are consumed in order
+    char request_buffer[STREAM_REQUEST_BUFFER_SIZE];
+    size_t request_length;
+    stream_http_parser_t parser;
+    bool keep_alive;                             // Current request allows another one after it
+    bool read_paused;                            // Responses backed up; stop parsing until flushed
+    bool read_eof;                               // Client half-closed; answer what is buffered, then close
+
+    // WebSocket control message being reassembled from fragments
+    char ws_message[256];
+    size_t ws_message_length;
+    bool ws_in_message;                          // Between a text frame without FIN and its last fragment
+
+    // Outbound frames not yet accepted by the kernel (ring of shared references)
+    stream_queued_frame_t* send_queue;
+    size_t send_queue_capacity;
+    size_t send_queue_head;
+    size_t send_queue_count;
+    size_t send_queue_bytes;                     // Wire bytes of every queued frame
+    size_t send_head_offset;                     // Bytes of the head frame already sent
+    uint64_t backlog_since_ms;                   // When the socket last refused data (0 = drained)
+    uint64_t frames_dropped;                     // Events discarded by the slow-consumer policy
+    bool slow_reported;                          // Backlog already logged for this episode
+
+    // MSG_ZEROCOPY bookkeeping (Linux only)
+    bool zerocopy_enabled;
+    uint32_t zerocopy_next_seq;                  // Sequence of the next zerocopy send
+    uint32_t zerocopy_completed;                 // All sends below this have completed
+    int64_t head_zerocopy_seq;                   // Zerocopy send that touched the head frame
+    struct stream_zerocopy_pending* zerocopy_pending;
+    struct stream_zerocopy_pending* zerocopy_pending_tail;
+
+    // Stream subscriptions (fed by each stream's shared producer)
+    struct stream_subscription* subscriptions;
+    uint64_t events_sent;                        // Atomic (read by registry walkers)
+
+    // Request timeout while reading, heartbeat while streaming
+    stream_timer_t idle_timer;
+    uint64_t last_activity_ms;
+
+    // Registry: each loop's shard is a list only the owning loop modifies;
+    // other threads walk loop_next inside an epoch (see streaming_epoch.h)
+    uint64_t connected_ms;
+    struct stream_connection* loop_prev;         // Owner-only back link
+    struct stream_connection* loop_next;         // Published with release stores
+    struct stream_connection* retire_next;       // Closed list, then recycle pool
+    uint64_t retired_epoch;
 } stream_connection_t;
 
+// One connection's interest in one stream; linked into the owning loop's subscriber list
+typedef struct stream_subscription {
+    stream_connection_t* conn;
+    struct stream_function_entry* stream;
+    struct stream_subscription* prev;            // Loop-local subscriber list
+    struct stream_subscription* next;
+    struct stream_subscription* conn_next;       // Connection's subscription list
+    uint64_t min_interval_ms;                    // Per-subscriber rate limit (0 = every sample)
+    uint64_t next_due_ms;                        // Earliest delivery of the next sample
+    bool delta;                                  // Receives "patch" events between keyframes
+    bool websocket;                              // Receives binary MessagePack frames instead of SSE
+    bool tagged;                                 // SSE events named after the stream (multi-stream response)
+    uint64_t last_event_id;                      // Newest event queued; older deliveries are duplicates
+} stream_subscription_t;
+
 // Streaming server structure
 typedef struct streaming_server {
     int server_socket;
     bool running;
-    pthread_t server_thread;
-    stream_connection_t* connections;
-    pthread_mutex_t connections_mutex;
-    int connection_count;
+    struct stream_loop* loops;                   // Fixed set of event loops
+    int loop_count;
+    bool reuse_port;                             // Every loop accepts on its own listener
+    stream_epoch_t registry_epoch;               // Guards unlocked walks of the loop shards
+    int connection_count;                        // Atomic; admitted connections, checked at accept
     int max_connections;
+    stream_slow_consumer_policy_t slow_consumer_policy;
     const streaming_config_t* config;
     app_window_t* window;
 } streaming_server_t;
 
-// Stream handler function type
+// Send queue and connection counters for the whole server or one shard (event loop)
+typedef struct {
+    int connections;
+    uint64_t connections_accepted;               // Connections adopted since start
+    uint64_t queued_frames;                      // Frames waiting in send queues
+    uint64_t queued_bytes;
+    uint64_t queue_high_water;                   // Deepest single send queue seen
+    uint64_t frames_sent;                        // Events handed to connections
+    uint64_t frames_dropped;                     // Events discarded (drop-oldest or overflow)
+    uint64_t frames_coalesced;                   // Events replaced by a newer sample
+    uint64_t slow_disconnects;                   // Connections closed for falling behind
+    uint64_t rejected_connections;               // Refused at accept (server or per-IP cap)
+    uint64_t rejected_subscriptions;             // Refused by a stream's subscriber cap
+} streaming_stats_t;
+
+// Stream handler function type: writes a NUL-terminated sample into a fixed buffer
+// (1024 bytes). Kept for existing handlers; new ones should be stream_writer_t.
 typedef void (*stream_handler_t)(const char* stream_name, char* output_buffer, size_t buffer_size);
 
+// Stream writer: appends one sample to out (empty on entry, grows as needed) and
+// returns the sample's length, normally out->length
+typedef size_t (*stream_writer_t)(const char* stream_name, stream_buffer_t* out);
+
 // Stream function registry entry
-typedef struct {
+typedef struct stream_function_entry {
     char name[64];
     char endpoint[128];
     int interval_ms;
     bool enabled;
-    stream_handler_t handler;
+    stream_handler_t handler;                    // Legacy handler, called through an adapter
+    stream_writer_t writer;                      // Used instead of handler when set
+    bool push;                                   // No handler or timer; fed by streaming_publish
     char description[256];
+    int max_subscribers;                         // 0 = unlimited
+    int delta_keyframe_interval;                 // Events per keyframe in delta mode (0 = off)
+    int batch_max_events;                        // Samples per "batch" event (0 or 1 = off)
+    int batch_max_delay_ms;                      // Flush once the oldest sample is this old (0 = count only)
+
+    // Shared producer: one handler call per tick, fanned out to every subscriber
+    int index;                                   // Slot in the stream registry
+    stream_timer_t producer_timer;               // Armed on the owner loop only
+    bool producer_armed;
+    int subscriber_count;                        // Atomic, across all loops
+    int loop_subscribers[STREAM_MAX_LOOPS];      // Atomic, per loop
+    int delta_subscribers;                       // Atomic; patches are only rendered when > 0
+    int delta_until_keyframe;                    // Producer-only countdown
+    int websocket_subscribers;                   // Atomic; binary frames are only rendered when > 0
+    int tagged_subscribers;                      // Atomic; tagged SSE frames are only rendered when > 0
+    uint64_t events_produced;
+    stream_buffer_t output;                      // Producer-only: the current sample, reused every tick
+    stream_buffer_t patch;                       // Producer-only: delta patch of the current sample
+    char* batch_buffer;                          // Producer-only: JSON array of pending samples
+    size_t batch_length;                         // Up to the closing ']'
+    size_t batch_capacity;
+    int batch_count;
+    uint64_t batch_started_ms;                   // Tick that took the first pending sample
+    stream_mpsc_t publish_queue;                 // Push streams: samples from any thread, popped on the owner loop
+    int publish_pending;                         // Atomic; samples in publish_queue
+    bool publish_drain_posted;                   // Atomic; a drain task is on its way to the owner loop
+    pthread_mutex_t latest_mutex;
+    stream_frame_t* latest;                      // Most recent frame (refcounted)
+    stream_frame_t* replay[STREAM_REPLAY_RING_SIZE]; // Recent frames in slot id % size (latest_mutex)
 } stream_function_entry_t;
 
 // Streaming server management
@@ -50,29 +204,92 @@ void streaming_cleanup(void);
 bool streaming_start_server(void);
 void streaming_stop_server(void);
 
+// Snapshot of send queue depth and drop counters (false if the server is not running)
+bool streaming_get_stats(streaming_stats_t* stats);
+
+// Per-shard counters, to check how evenly connections spread across event loops
+int streaming_get_shard_count(void);
+bool streaming_get_shard_stats(int shard, streaming_stats_t* stats);
+
 // Stream function registration
-void streaming_register_function(const char* name, const char* endpoint, 
-                                int interval_ms, stream_handler_t handler, 
+void streaming_register_function(const char* name, const char* endpoint,
+                                int interval_ms, stream_handler_t handler,
                                 const char* description);
+void streaming_register_writer(const char* name, const char* endpoint,
+                               int interval_ms, stream_writer_t writer,
+                               const char* description);
+
+// Push-based stream for event sources (packets, log lines, bridge calls): there is no
+// timer, every sample handed to streaming_publish is sent as soon as the owner loop
+// picks it up
+void streaming_register_source(const char* name, const char* endpoint, const char* description);
+
+// Publish one sample to a push stream; safe from any thread and never blocks. The
+// payload is copied. False if the stream is not a push stream, nobody is subscribed,
+// the server is not running or STREAM_PUBLISH_MAX_PENDING samples are already queued.
+// Sources must stop publishing before streaming_cleanup.
+bool streaming_publish(const char* stream_name, const char* payload, size_t length);
+
+// Replay a .pcap or .pcapng capture into a push stream, one tcpdump-style sample per
+// packet, while the server runs. speed 1 keeps the original timing, N plays N times
+// faster (samples the stream cannot take are dropped to stay on time), 0 publishes
+// as fast as the stream drains. The file is mapped here and decoded in place.
+bool streaming_add_replay(const char* stream_name, const char* path, double speed, bool loop);
+
+// Capture live traffic into a push stream through an AF_PACKET TPACKET_V3 ring (Linux;
+// needs CAP_NET_RAW). interface may be "any". filter is optional classic BPF in
+// `tcpdump -ddd` form. Packets are read straight from the mapped ring blocks and a
+// tcpdump-style sample, with the kernel's drop count, is published as blocks retire.
+bool streaming_add_capture(const char* stream_name, const char* interface, const char* filter);
 
 // Built-in and custom handler registration (defined in separate files)
 void streaming_register_builtin_handlers(void);
 void streaming_register_config_streams(const streaming_config_t* config);
 void streaming_register_custom_handlers(void);
 
+// Cap concurrent subscribers of a registered stream (0 = unlimited)
+bool streaming_set_stream_max_subscribers(const char* name, int max_subscribers);
+
+// Enable delta mode: subscribers that ask for ?delta=1 get a full keyframe every
+// keyframe_interval events and patches in between (0 turns it off)
+bool streaming_set_stream_delta(const char* name, int keyframe_interval);
+
+// Enable micro-batching: the producer buffers up to max_events samples (or for at most
+// max_delay_ms) and sends them as one "batch" event holding a JSON array. Each sample
+// keeps its own timestamp; event ids count batches. Delta mode is off while batching.
+bool streaming_set_stream_batch(const char* name, int max_events, int max_delay_ms);
+
 // Custom handler registration (for user-defined functions)
 bool streaming_register_custom_handler(const char* name, stream_handler_t handler);
+bool streaming_register_custom_writer(const char* name, stream_writer_t writer);
 void streaming_cleanup_custom_handlers(void);
 
-// HTTP response utilities
-void streaming_send_http_response(int client_socket, const char* status, 
+// HTTP response utilities (blocking sockets outside the event loops)
+void streaming_send_http_response(int client_socket, const char* status,
                                  const char* content_type, const char* body);
-void streaming_send_sse_event(int client_socket, const char* event_name, 
-                             const char* data);
+void streaming_send_sse_event(int client_socket, const char* event_name,
+                             uint64_t id, const char* data);         // id 0 = none
 
-// Connection management
+// Connection management (add/remove run on the connection's own loop)
 void streaming_add_connection(stream_connection_t* conn);
 void streaming_remove_connection(stream_connection_t* conn);
 void streaming_cleanup_connections(void);
 
-#endif // STREAMING_H 
\ No newline at end of file
+// Point-in-time view of one connection handed to registry visitors
+typedef struct {
+    char client_ip[16];
+    int client_port;
+    int shard;                                   // Owning event loop
+    bool streaming;
+    bool websocket;
+    uint64_t events_sent;
+    uint64_t connected_ms;                       // Monotonic clock (stream_now_ms)
+} stream_connection_info_t;
+
+// Visit every open connection from any thread without blocking the event loops;
+// connections opened or closed during the walk may or may not be seen.
+// Returns the number visited.
+int streaming_for_each_connection(void (*visit)(const stream_connection_info_t* info, void* arg),
+                                  void* arg);
+
+#endif // STREAMING_H
\ No newline at end of file
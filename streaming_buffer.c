@@ -0,0 +1,157 @@
+#include "streaming_buffer.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_INITIAL_CAPACITY 1024
+
+void stream_buffer_init(stream_buffer_t* buffer) {
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->failed = false;
+}
+
+void stream_buffer_free(stream_buffer_t* buffer) {
+    free(buffer->data);
+    stream_buffer_init(buffer);
+}
+
+void stream_buffer_reset(stream_buffer_t* buffer) {
+    buffer->length = 0;
+    buffer->failed = false;
+    if (buffer->data) buffer->data[0] = '\0';
+}
+
+char* stream_buffer_reserve(stream_buffer_t* buffer, size_t size) {
+    if (buffer->failed) return NULL;
+
+    if (size > buffer->capacity - buffer->length || !buffer->data) {
+        size_t capacity = buffer->capacity ? buffer->capacity : BUFFER_INITIAL_CAPACITY;
+        while (capacity - buffer->length < size) {
+            if (capacity > SIZE_MAX / 2) {
+                buffer->failed = true;
+                return NULL;
+            }
+            capacity *= 2;
+        }
+        char* data = realloc(buffer->data, capacity + 1);
+        if (!data) {
+            buffer->failed = true;
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    return buffer->data + buffer->length;
+}
+
+void stream_buffer_commit(stream_buffer_t* buffer, size_t length) {
+    if (buffer->failed || !buffer->data) return;
+    if (length > buffer->capacity - buffer->length) length = buffer->capacity - buffer->length;
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+void stream_buffer_append(stream_buffer_t* buffer, const char* data, size_t length) {
+    char* out = stream_buffer_reserve(buffer, length);
+    if (!out) return;
+    memcpy(out, data, length);
+    stream_buffer_commit(buffer, length);
+}
+
+void stream_buffer_append_str(stream_buffer_t* buffer, const char* text) {
+    stream_buffer_append(buffer, text, strlen(text));
+}
+
+void stream_buffer_append_char(stream_buffer_t* buffer, char c) {
+    char* out = stream_buffer_reserve(buffer, 1);
+    if (!out) return;
+    *out = c;
+    stream_buffer_commit(buffer, 1);
+}
+
+void stream_buffer_append_uint(stream_buffer_t* buffer, uint64_t value) {
+    // Digits are produced backwards into a scratch array
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - ++count] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    stream_buffer_append(buffer, digits + sizeof(digits) - count, count);
+}
+
+void stream_buffer_append_int(stream_buffer_t* buffer, int64_t value) {
+    if (value < 0) {
+        stream_buffer_append_char(buffer, '-');
+        // Negate in unsigned arithmetic so INT64_MIN does not overflow
+        stream_buffer_append_uint(buffer, (uint64_t)0 - (uint64_t)value);
+        return;
+    }
+    stream_buffer_append_uint(buffer, (uint64_t)value);
+}
+
+void stream_buffer_append_double(stream_buffer_t* buffer, double value) {
+    if (!isfinite(value)) {
+        stream_buffer_append(buffer, "null", 4);
+        return;
+    }
+    // Integral values skip the printf machinery
+    if (value >= -9007199254740992.0 && value <= 9007199254740992.0 && value == (double)(int64_t)value) {
+        stream_buffer_append_int(buffer, (int64_t)value);
+        return;
+    }
+    stream_buffer_appendf(buffer, "%.17g", value);
+}
+
+void stream_buffer_append_json_string(stream_buffer_t* buffer, const char* text) {
+    static const char hex[] = "0123456789abcdef";
+
+    stream_buffer_append_char(buffer, '"');
+    const char* run = text;
+    for (const char* p = text; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Copy the plain run before the character that needs escaping
+        stream_buffer_append(buffer, run, (size_t)(p - run));
+        run = p + 1;
+        switch (c) {
+        case '"': stream_buffer_append(buffer, "\\\"", 2); break;
+        case '\\': stream_buffer_append(buffer, "\\\\", 2); break;
+        case '\n': stream_buffer_append(buffer, "\\n", 2); break;
+        case '\r': stream_buffer_append(buffer, "\\r", 2); break;
+        case '\t': stream_buffer_append(buffer, "\\t", 2); break;
+        default: {
+            char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            stream_buffer_append(buffer, escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    stream_buffer_append_str(buffer, run);
+    stream_buffer_append_char(buffer, '"');
+}
+
+void stream_buffer_appendf(stream_buffer_t* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    // First try in place; the terminator slot past capacity is always there
+    char* out = buffer->data && !buffer->failed ? buffer->data + buffer->length : NULL;
+    size_t room = out ? buffer->capacity - buffer->length : 0;
+    int needed = vsnprintf(out, out ? room + 1 : 0, format, args);
+    va_end(args);
+    if (needed < 0) return;
+
+    if ((size_t)needed > room || !out) {
+        out = stream_buffer_reserve(buffer, (size_t)needed);
+        if (!out) return;
+        va_start(args, format);
+        vsnprintf(out, (size_t)needed + 1, format, args);
+        va_end(args);
+    }
+    stream_buffer_commit(buffer, (size_t)needed);
+}
@@ -0,0 +1,43 @@
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Growable byte buffer that stream writers append their sample to. The
+// producer owns one per stream and resets it every tick, so the memory is
+// kept between samples and steady-state ticks do not allocate. Contents stay
+// NUL-terminated for debugging, but length is authoritative.
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;                  // Usable bytes, not counting the terminator
+    bool failed;                      // An allocation failed; later appends are dropped
+} stream_buffer_t;
+
+void stream_buffer_init(stream_buffer_t* buffer);
+void stream_buffer_free(stream_buffer_t* buffer);
+
+// Empty the buffer but keep its memory
+void stream_buffer_reset(stream_buffer_t* buffer);
+
+// Room for at least size more bytes; returns where they go (NULL on failure).
+// Write into it, then stream_buffer_commit what was actually used.
+char* stream_buffer_reserve(stream_buffer_t* buffer, size_t size);
+void stream_buffer_commit(stream_buffer_t* buffer, size_t length);
+
+void stream_buffer_append(stream_buffer_t* buffer, const char* data, size_t length);
+void stream_buffer_append_str(stream_buffer_t* buffer, const char* text);
+void stream_buffer_append_char(stream_buffer_t* buffer, char c);
+void stream_buffer_append_uint(stream_buffer_t* buffer, uint64_t value);
+void stream_buffer_append_int(stream_buffer_t* buffer, int64_t value);
+void stream_buffer_append_double(stream_buffer_t* buffer, double value);   // null if not finite
+
+// Quoted and escaped JSON string
+void stream_buffer_append_json_string(stream_buffer_t* buffer, const char* text);
+
+void stream_buffer_appendf(stream_buffer_t* buffer, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#endif // STREAMING_BUFFER_H
@@ -0,0 +1,379 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "streaming.h"
+#include "streaming_capture.h"
+#include "streaming_pcap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define CAPTURE_BLOCK_SIZE (1u << 20)         // Ring block; the kernel hands these over whole
+#define CAPTURE_BLOCK_COUNT 32
+#define CAPTURE_FRAME_SIZE 2048               // Only sizes the ring; V3 packs packets tightly
+#define CAPTURE_BLOCK_TIMEOUT_MS 20           // Partly filled blocks are retired after this long
+#define CAPTURE_POLL_TIMEOUT_MS 100           // Longest wait between checks for stop
+#define CAPTURE_PUBLISH_INTERVAL_NS 100000000ull  // Busy rings publish at most this often
+
+typedef struct stream_capture {
+    char stream_name[64];
+    char interface[32];
+
+    int fd;
+    uint8_t* ring;                    // CAPTURE_BLOCK_COUNT blocks, shared with the kernel
+    size_t ring_size;
+    unsigned block_index;             // Next block to hand back
+
+    pthread_t thread;
+    bool thread_started;
+    bool stop;                        // Atomic
+
+    // Capture thread only
+    uint64_t kernel_packets;          // Summed from PACKET_STATISTICS, which resets on read
+    uint64_t kernel_drops;
+    uint64_t samples_published;
+
+    struct stream_capture* next;
+} stream_capture_t;
+
+static stream_capture_t* g_captures = NULL;
+
+static uint64_t capture_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Classic BPF as printed by `tcpdump -ddd`: the instruction count, then one
+// "code jt jf k" line per instruction, separated by commas (the bytecode form
+// iptables' bpf match takes). Newlines also separate lines, but config.json
+// strings are not unescaped, so a "\n" there does not; use commas in config.
+static bool capture_parse_filter(const char* text, struct sock_fprog* program) {
+    char* end;
+    unsigned long count = strtoul(text, &end, 10);
+    if (end == text || count == 0 || count > BPF_MAXINSNS) return false;
+
+    struct sock_filter* code = calloc(count, sizeof(struct sock_filter));
+    if (!code) return false;
+
+    const char* p = end;
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long fields[4];
+        for (int f = 0; f < 4; f++) {
+            while (*p == ',' || *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+            fields[f] = strtoul(p, &end, 10);
+            if (end == p) {
+                free(code);
+                return false;
+            }
+            p = end;
+        }
+        code[i].code = (uint16_t)fields[0];
+        code[i].jt = (uint8_t)fields[1];
+        code[i].jf = (uint8_t)fields[2];
+        code[i].k = (uint32_t)fields[3];
+    }
+
+    program->len = (unsigned short)count;
+    program->filter = code;
+    return true;
+}
+
+// Socket, filter, TPACKET_V3 ring and binding. The socket is opened with
+// protocol 0 so it receives nothing until bind() names ETH_P_ALL and the
+// interface, after the filter and ring are in place (as libpcap does); no
+// unfiltered packet or packet from another interface lands in the ring.
+static bool capture_open(stream_capture_t* capture, const char* filter) {
+    unsigned int ifindex = 0;
+    if (strcmp(capture->interface, "any") != 0) {
+        ifindex = if_nametoindex(capture->interface);
+        if (ifindex == 0) {
+            printf("Capture %s: no interface %s\n", capture->stream_name, capture->interface);
+            return false;
+        }
+    }
+
+    capture->fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (capture->fd < 0) {
+        printf("Capture %s: AF_PACKET socket failed: %s\n", capture->stream_name, strerror(errno));
+        return false;
+    }
+
+    if (filter && filter[0]) {
+        struct sock_fprog program;
+        if (!capture_parse_filter(filter, &program)) {
+            printf("Capture %s: filter is not `tcpdump -ddd` output\n", capture->stream_name);
+            return false;
+        }
+        int result = setsockopt(capture->fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program));
+        free(program.filter);
+        if (result != 0) {
+            printf("Capture %s: kernel rejected the filter: %s\n", capture->stream_name, strerror(errno));
+            return false;
+        }
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(capture->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        printf("Capture %s: TPACKET_V3 unsupported: %s\n", capture->stream_name, strerror(errno));
+        return false;
+    }
+
+    struct tpacket_req3 request;
+    memset(&request, 0, sizeof(request));
+    request.tp_block_size = CAPTURE_BLOCK_SIZE;
+    request.tp_block_nr = CAPTURE_BLOCK_COUNT;
+    request.tp_frame_size = CAPTURE_FRAME_SIZE;
+    request.tp_frame_nr = CAPTURE_BLOCK_SIZE / CAPTURE_FRAME_SIZE * CAPTURE_BLOCK_COUNT;
+    request.tp_retire_blk_tov = CAPTURE_BLOCK_TIMEOUT_MS;
+    if (setsockopt(capture->fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0) {
+        printf("Capture %s: PACKET_RX_RING failed: %s\n", capture->stream_name, strerror(errno));
+        return false;
+    }
+
+    capture->ring_size = (size_t)CAPTURE_BLOCK_SIZE * CAPTURE_BLOCK_COUNT;
+    void* ring = mmap(NULL, capture->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
+                      capture->fd, 0);
+    if (ring == MAP_FAILED) {
+        // Locked memory is a nicety; RLIMIT_MEMLOCK often forbids it
+        ring = mmap(NULL, capture->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, capture->fd, 0);
+    }
+    if (ring == MAP_FAILED) {
+        printf("Capture %s: ring mmap failed: %s\n", capture->stream_name, strerror(errno));
+        return false;
+    }
+    capture->ring = ring;
+
+    struct sockaddr_ll address;
+    memset(&address, 0, sizeof(address));
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = (int)ifindex;
+    if (bind(capture->fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Capture %s: bind to %s failed: %s\n", capture->stream_name, capture->interface,
+               strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static void capture_close(stream_capture_t* capture) {
+    if (capture->ring) munmap(capture->ring, capture->ring_size);
+    if (capture->fd >= 0) close(capture->fd);
+    capture->ring = NULL;
+    capture->fd = -1;
+}
+
+// Link type of a ring packet, from the device type the kernel reports with it
+static uint32_t capture_linktype(const struct sockaddr_ll* address) {
+    switch (address->sll_hatype) {
+    case ARPHRD_ETHER:
+    case ARPHRD_LOOPBACK:
+        return STREAM_LINKTYPE_ETHERNET;
+    case ARPHRD_NONE:
+#ifdef ARPHRD_RAWIP
+    case ARPHRD_RAWIP:
+#endif
+        return STREAM_LINKTYPE_RAW;
+    default:
+        return UINT32_MAX;            // Nothing stream_packet_decode understands
+    }
+}
+
+// Walk one retired block. Every packet is counted, but only the newest few can
+// show up in the sample, so only those are decoded and formatted.
+static void capture_read_block(const struct tpacket_block_desc* block, stream_packet_window_t* window) {
+    const struct tpacket3_hdr* newest[STREAM_PACKET_WINDOW_SIZE];
+    uint32_t packet_total = block->hdr.bh1.num_pkts;
+    uint32_t kept = 0;
+
+    const uint8_t* cursor = (const uint8_t*)block + block->hdr.bh1.offset_to_first_pkt;
+    for (uint32_t i = 0; i < packet_total; i++) {
+        const struct tpacket3_hdr* header = (const struct tpacket3_hdr*)cursor;
+        const struct sockaddr_ll* address =
+            (const struct sockaddr_ll*)((const uint8_t*)header + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+        // Loopback shows every packet twice, leaving and arriving; keep the arrival like tcpdump
+        if (address->sll_hatype != ARPHRD_LOOPBACK || address->sll_pkttype != PACKET_OUTGOING) {
+            newest[kept % STREAM_PACKET_WINDOW_SIZE] = header;
+            kept++;
+        }
+        cursor += header->tp_next_offset;
+    }
+
+    uint32_t first = kept > STREAM_PACKET_WINDOW_SIZE ? kept - STREAM_PACKET_WINDOW_SIZE : 0;
+    window->packet_count += first;
+    for (uint32_t i = first; i < kept; i++) {
+        const struct tpacket3_hdr* header = newest[i % STREAM_PACKET_WINDOW_SIZE];
+        const struct sockaddr_ll* address =
+            (const struct sockaddr_ll*)((const uint8_t*)header + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+        stream_pcap_packet_t packet = {
+            .timestamp_ns = (uint64_t)header->tp_sec * 1000000000ull + header->tp_nsec,
+            .data = (const uint8_t*)header + header->tp_mac,
+            .captured_length = header->tp_snaplen,
+            .original_length = header->tp_len,
+            .linktype = capture_linktype(address),
+        };
+        stream_packet_info_t info;
+        stream_packet_decode(&packet, &info);
+        stream_packet_window_add(window, &packet, &info);
+    }
+}
+
+static void capture_publish(stream_capture_t* capture, stream_packet_window_t* window, stream_buffer_t* sample) {
+    struct tpacket_stats_v3 stats;
+    socklen_t length = sizeof(stats);
+    if (getsockopt(capture->fd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) == 0) {
+        capture->kernel_packets += stats.tp_packets;
+        capture->kernel_drops += stats.tp_drops;
+    }
+    window->has_drops = true;
+    window->drops = capture->kernel_drops;
+
+    stream_buffer_reset(sample);
+    stream_packet_window_write(window, sample);
+    if (!sample->failed && streaming_publish(capture->stream_name, sample->data, sample->length)) {
+        capture->samples_published++;
+    }
+}
+
+static void* capture_thread_func(void* arg) {
+    stream_capture_t* capture = (stream_capture_t*)arg;
+    stream_packet_window_t window;
+    stream_buffer_t sample;
+    stream_packet_window_init(&window);
+    stream_buffer_init(&sample);
+
+    uint64_t last_publish_ns = 0;
+    uint64_t published_count = 0;
+    while (!__atomic_load_n(&capture->stop, __ATOMIC_ACQUIRE)) {
+        struct tpacket_block_desc* block =
+            (struct tpacket_block_desc*)(capture->ring + (size_t)capture->block_index * CAPTURE_BLOCK_SIZE);
+
+        if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+            // Ring drained: publish what has changed, then sleep until the kernel retires a block
+            if (window.packet_count != published_count) {
+                capture_publish(capture, &window, &sample);
+                published_count = window.packet_count;
+                last_publish_ns = capture_now_ns();
+            }
+            struct pollfd pfd = { capture->fd, POLLIN | POLLERR, 0 };
+            poll(&pfd, 1, CAPTURE_POLL_TIMEOUT_MS);
+            continue;
+        }
+
+        capture_read_block(block, &window);
+
+        // Hand the block back to the kernel
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        capture->block_index = (capture->block_index + 1) % CAPTURE_BLOCK_COUNT;
+
+        // A ring that never drains still publishes now and then
+        uint64_t now = capture_now_ns();
+        if (now - last_publish_ns >= CAPTURE_PUBLISH_INTERVAL_NS) {
+            capture_publish(capture, &window, &sample);
+            published_count = window.packet_count;
+            last_publish_ns = now;
+        }
+    }
+
+    stream_buffer_free(&sample);
+    return NULL;
+}
+
+// Capture live traffic into a push stream
+bool streaming_add_capture(const char* stream_name, const char* interface, const char* filter) {
+    if (!stream_name || !interface || !interface[0]) {
+        printf("Invalid parameters for live capture\n");
+        return false;
+    }
+
+    stream_capture_t* capture = calloc(1, sizeof(stream_capture_t));
+    if (!capture) {
+        printf("Failed to allocate live capture for %s\n", stream_name);
+        return false;
+    }
+    strncpy(capture->stream_name, stream_name, sizeof(capture->stream_name) - 1);
+    strncpy(capture->interface, interface, sizeof(capture->interface) - 1);
+    capture->fd = -1;
+
+    // Opened now so missing privileges or a bad filter are reported at startup
+    if (!capture_open(capture, filter)) {
+        capture_close(capture);
+        free(capture);
+        return false;
+    }
+
+    capture->next = g_captures;
+    g_captures = capture;
+    printf("Capture %s: %s%s (TPACKET_V3, %u x %u KB ring)\n", stream_name, interface,
+           filter && filter[0] ? ", filtered" : "", CAPTURE_BLOCK_COUNT, CAPTURE_BLOCK_SIZE / 1024);
+    return true;
+}
+
+void stream_capture_start_all(void) {
+    for (stream_capture_t* capture = g_captures; capture; capture = capture->next) {
+        if (capture->thread_started) continue;
+        __atomic_store_n(&capture->stop, false, __ATOMIC_RELEASE);
+        if (pthread_create(&capture->thread, NULL, capture_thread_func, capture) != 0) {
+            printf("Capture %s: failed to create thread\n", capture->stream_name);
+            continue;
+        }
+        capture->thread_started = true;
+    }
+}
+
+void stream_capture_stop_all(void) {
+    for (stream_capture_t* capture = g_captures; capture; capture = capture->next) {
+        __atomic_store_n(&capture->stop, true, __ATOMIC_RELEASE);
+    }
+    for (stream_capture_t* capture = g_captures; capture; capture = capture->next) {
+        if (!capture->thread_started) continue;
+        pthread_join(capture->thread, NULL);
+        capture->thread_started = false;
+        printf("Capture %s: %llu packets seen by the kernel, %llu dropped, %llu samples published\n",
+               capture->stream_name, (unsigned long long)capture->kernel_packets,
+               (unsigned long long)capture->kernel_drops, (unsigned long long)capture->samples_published);
+    }
+}
+
+void stream_capture_cleanup(void) {
+    stream_capture_stop_all();
+    while (g_captures) {
+        stream_capture_t* capture = g_captures;
+        g_captures = capture->next;
+        capture_close(capture);
+        free(capture);
+    }
+}
+
+#else
+
+// AF_PACKET is Linux only; replay a capture file elsewhere
+bool streaming_add_capture(const char* stream_name, const char* interface, const char* filter) {
+    (void)interface;
+    (void)filter;
+    printf("Capture %s: live capture is not implemented for this platform\n", stream_name ? stream_name : "");
+    return false;
+}
+
+void stream_capture_start_all(void) {}
+void stream_capture_stop_all(void) {}
+void stream_capture_cleanup(void) {}
+
+#endif
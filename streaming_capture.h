@@ -0,0 +1,17 @@
+#ifndef STREAMING_CAPTURE_H
+#define STREAMING_CAPTURE_H
+
+// Live captures added with streaming_add_capture (Linux AF_PACKET). Each runs
+// on its own thread while the server is running and publishes tcpdump-style
+// samples as ring blocks fill.
+
+// Start every capture thread (after the event loops are up)
+void stream_capture_start_all(void);
+
+// Stop and join every capture thread (before the event loops go down)
+void stream_capture_stop_all(void);
+
+// Stop, unmap the rings and close every capture socket
+void stream_capture_cleanup(void);
+
+#endif // STREAMING_CAPTURE_H
@@ -1,3 +1,7 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include "streaming.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,22 +14,30 @@
 #include <mach/vm_statistics.h>
 #endif
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 // Custom stream handler registry
 typedef struct custom_stream_handler {
     char name[64];
-    stream_handler_t handler;
+    stream_handler_t handler;         // Exactly one of handler and writer is set
+    stream_writer_t writer;
     struct custom_stream_handler* next;
 } custom_stream_handler_t;
 
 static custom_stream_handler_t* g_custom_handlers = NULL;
 
 // Forward declarations
-static stream_handler_t find_custom_handler(const char* name);
-static void default_custom_handler(const char* stream_name, char* output_buffer, size_t buffer_size);
+static const custom_stream_handler_t* find_custom_handler(const char* name);
+static bool add_custom_handler(const char* name, stream_handler_t handler, stream_writer_t writer);
+static size_t default_custom_handler(const char* stream_name, stream_buffer_t* out);
 
 // Custom handler implementations (user-provided via config)
-void stream_system_memory(const char* stream_name, char* output_buffer, size_t buffer_size);
-void stream_network_tcpdump(const char* stream_name, char* output_buffer, size_t buffer_size);
+size_t stream_system_memory(const char* stream_name, stream_buffer_t* out);
+size_t stream_network_tcpdump(const char* stream_name, stream_buffer_t* out);
 
 // Register stream functions from configuration
 void streaming_register_config_streams(const streaming_config_t* config) {
@@ -45,19 +57,52 @@ void streaming_register_config_streams(const streaming_config_t* config) {
         }
         
         // Map handler name from config to actual handler function
-        stream_handler_t handler = find_custom_handler(stream_config->handler);
-        if (!handler) {
-            printf("No handler found for '%s', using default handler\n", stream_config->handler);
-            handler = default_custom_handler;
+        const custom_stream_handler_t* custom = find_custom_handler(stream_config->handler);
+        if (stream_config->push || stream_config->replay_file[0] || stream_config->capture_interface[0]) {
+            // Native sources publish into it; there is nothing to poll
+            streaming_register_source(
+                stream_config->name,
+                stream_config->endpoint,
+                stream_config->description
+            );
+        } else if (custom && custom->handler) {
+            streaming_register_function(
+                stream_config->name,
+                stream_config->endpoint,
+                stream_config->interval_ms,
+                custom->handler,
+                stream_config->description
+            );
+        } else {
+            if (!custom) {
+                printf("No handler found for '%s', using default handler\n", stream_config->handler);
+            }
+            streaming_register_writer(
+                stream_config->name,
+                stream_config->endpoint,
+                stream_config->interval_ms,
+                custom ? custom->writer : default_custom_handler,
+                stream_config->description
+            );
+        }
+        if (stream_config->max_subscribers > 0) {
+            streaming_set_stream_max_subscribers(stream_config->name, stream_config->max_subscribers);
+        }
+        if (stream_config->delta_keyframe_interval > 0) {
+            streaming_set_stream_delta(stream_config->name, stream_config->delta_keyframe_interval);
+        }
+        if (stream_config->batch_max_events > 1) {
+            streaming_set_stream_batch(stream_config->name, stream_config->batch_max_events,
+                                       stream_config->batch_max_delay_ms);
+        }
+        if (stream_config->replay_file[0]) {
+            streaming_add_replay(stream_config->name, stream_config->replay_file,
+                                 stream_config->replay_speed, stream_config->replay_loop);
+        }
+        if (stream_config->capture_interface[0]) {
+            streaming_add_capture(stream_config->name, stream_config->capture_interface,
+                                  stream_config->capture_filter);
         }
-        
-        streaming_register_function(
-            stream_config->name,
-            stream_config->endpoint,
-            stream_config->interval_ms,
-            handler,
-            stream_config->description
-        );
         
         printf("Registered: %s -> %s (handler: %s)\n", 
                stream_config->endpoint, stream_config->name, stream_config->handler);
@@ -71,8 +116,8 @@ void streaming_register_custom_handlers(void) {
     printf("Registering user-provided custom handlers...\n");
     
     // Register the handlers that users provide via config
-    streaming_register_custom_handler("stream_system_memory", stream_system_memory);
-    streaming_register_custom_handler("stream_network_tcpdump", stream_network_tcpdump);
+    streaming_register_custom_writer("stream_system_memory", stream_system_memory);
+    streaming_register_custom_writer("stream_network_tcpdump", stream_network_tcpdump);
     
     printf("Custom handlers registered successfully\n");
 }
@@ -83,6 +128,19 @@ bool streaming_register_custom_handler(const char* name, stream_handler_t handle
         printf("Invalid parameters for custom handler registration\n");
         return false;
     }
+    return add_custom_handler(name, handler, NULL);
+}
+
+// Register a custom stream writer (growable output buffer)
+bool streaming_register_custom_writer(const char* name, stream_writer_t writer) {
+    if (!name || !writer) {
+        printf("Invalid parameters for custom handler registration\n");
+        return false;
+    }
+    return add_custom_handler(name, NULL, writer);
+}
+
+static bool add_custom_handler(const char* name, stream_handler_t handler, stream_writer_t writer) {
     
     // Create new handler entry
     custom_stream_handler_t* new_handler = malloc(sizeof(custom_stream_handler_t));
@@ -94,6 +152,7 @@ bool streaming_register_custom_handler(const char* name, stream_handler_t handle
     strncpy(new_handler->name, name, sizeof(new_handler->name) - 1);
     new_handler->name[sizeof(new_handler->name) - 1] = '\0';
     new_handler->handler = handler;
+    new_handler->writer = writer;
     new_handler->next = g_custom_handlers;
     
     g_custom_handlers = new_handler;
@@ -103,11 +162,11 @@ bool streaming_register_custom_handler(const char* name, stream_handler_t handle
 }
 
 // Find a custom handler by name
-static stream_handler_t find_custom_handler(const char* name) {
+static const custom_stream_handler_t* find_custom_handler(const char* name) {
     custom_stream_handler_t* current = g_custom_handlers;
     while (current) {
         if (strcmp(current->name, name) == 0) {
-            return current->handler;
+            return current;
         }
         current = current->next;
     }
@@ -115,13 +174,16 @@ static stream_handler_t find_custom_handler(const char* name) {
 }
 
 // Default handler for custom streams that don't have specific implementations
-static void default_custom_handler(const char* stream_name, char* output_buffer, size_t buffer_size) {
+static size_t default_custom_handler(const char* stream_name, stream_buffer_t* out) {
     time_t now = time(NULL);
     
     // Generate a default response indicating this is a placeholder
-    snprintf(output_buffer, buffer_size,
-            "{\"timestamp\":%ld,\"stream\":\"%s\",\"status\":\"placeholder\",\"message\":\"This is a default handler. Implement a custom handler for this stream.\"}",
-            now, stream_name);
+    stream_buffer_append_str(out, "{\"timestamp\":");
+    stream_buffer_append_int(out, (int64_t)now);
+    stream_buffer_append_str(out, ",\"stream\":");
+    stream_buffer_append_json_string(out, stream_name);
+    stream_buffer_append_str(out, ",\"status\":\"placeholder\",\"message\":\"This is a default handler. Implement a custom handler for this stream.\"}");
+    return out->length;
 }
 
 // Cleanup custom handlers
@@ -135,8 +197,199 @@ void streaming_cleanup_custom_handlers(void) {
     g_custom_handlers = NULL;
 }
 
+// Error sample shared by the memory handler's failure paths
+static size_t memory_error(stream_buffer_t* out, const char* message) {
+    stream_buffer_append_str(out, "{\"timestamp\":");
+    stream_buffer_append_int(out, (int64_t)time(NULL));
+    stream_buffer_append_str(out, ",\"error\":");
+    stream_buffer_append_json_string(out, message);
+    stream_buffer_append_char(out, '}');
+    return out->length;
+}
+
+#if defined(__APPLE__) || defined(__linux__)
+// "key":value member with a leading comma
+static void append_uint_member(stream_buffer_t* out, const char* key, uint64_t value) {
+    stream_buffer_append_str(out, ",\"");
+    stream_buffer_append_str(out, key);
+    stream_buffer_append_str(out, "\":");
+    stream_buffer_append_uint(out, value);
+}
+
+// The memory sample schema, shared by every platform (values in MB)
+static size_t memory_sample(stream_buffer_t* out, uint64_t total, uint64_t used, uint64_t free,
+                            uint64_t active, uint64_t inactive, uint64_t wired, uint64_t compressed) {
+    stream_buffer_append_str(out, "{\"timestamp\":");
+    stream_buffer_append_int(out, (int64_t)time(NULL));
+    append_uint_member(out, "total_mb", total);
+    append_uint_member(out, "used_mb", used);
+    append_uint_member(out, "free_mb", free);
+    append_uint_member(out, "active_mb", active);
+    append_uint_member(out, "inactive_mb", inactive);
+    append_uint_member(out, "wired_mb", wired);
+    append_uint_member(out, "compressed_mb", compressed);
+    stream_buffer_append_char(out, '}');
+    return out->length;
+}
+#endif
+
+#ifdef __linux__
+// /proc/meminfo and the cgroup v2 memory files are opened once and re-read with
+// pread, which regenerates their contents at offset 0. Parsing happens in place on
+// a stack buffer, so a sample costs a few syscalls and no allocations.
+#define MEMINFO_READ_SIZE 8192
+
+typedef struct {
+    const char* key;                  // With its separator ("MemTotal:", "anon ") so prefixes do not match
+    uint64_t* value;
+} meminfo_field_t;
+
+static pthread_once_t g_meminfo_once = PTHREAD_ONCE_INIT;
+static int g_meminfo_fd = -1;
+static int g_cgroup_max_fd = -1;              // -1 unless this process sits in a non-root cgroup v2
+static int g_cgroup_current_fd = -1;
+static int g_cgroup_stat_fd = -1;
+
+static size_t meminfo_read(int fd, char* buffer, size_t size) {
+    ssize_t length = pread(fd, buffer, size - 1, 0);
+    if (length <= 0) return 0;
+    buffer[length] = '\0';
+    return (size_t)length;
+}
+
+// Leading decimal number after optional blanks; false if there is none
+static bool meminfo_parse_number(const char* text, const char* end, uint64_t* value) {
+    while (text < end && (*text == ' ' || *text == '\t')) text++;
+    if (text >= end || *text < '0' || *text > '9') return false;
+
+    uint64_t number = 0;
+    while (text < end && *text >= '0' && *text <= '9') {
+        number = number * 10 + (uint64_t)(*text - '0');
+        text++;
+    }
+    *value = number;
+    return true;
+}
+
+// One pass over "key value" lines, filling every field whose key starts a line.
+// Fields that are absent keep their value. Returns how many were found.
+static int meminfo_parse(const char* text, size_t length, const meminfo_field_t* fields, int count) {
+    const char* end = text + length;
+    int found = 0;
+
+    for (const char* line = text; line < end && found < count; ) {
+        const char* eol = memchr(line, '\n', (size_t)(end - line));
+        if (!eol) eol = end;
+
+        for (int i = 0; i < count; i++) {
+            size_t key_length = strlen(fields[i].key);
+            if ((size_t)(eol - line) > key_length && memcmp(line, fields[i].key, key_length) == 0) {
+                if (meminfo_parse_number(line + key_length, eol, fields[i].value)) found++;
+                break;
+            }
+        }
+        line = eol + 1;
+    }
+    return found;
+}
+
+// Open the memory files of this process's cgroup v2 under a mount point
+static bool meminfo_open_cgroup(const char* mount, const char* path) {
+    char file[512];
+    snprintf(file, sizeof(file), "%s%s/memory.max", mount, path);
+    int max_fd = open(file, O_RDONLY | O_CLOEXEC);
+    snprintf(file, sizeof(file), "%s%s/memory.current", mount, path);
+    int current_fd = open(file, O_RDONLY | O_CLOEXEC);
+    snprintf(file, sizeof(file), "%s%s/memory.stat", mount, path);
+    int stat_fd = open(file, O_RDONLY | O_CLOEXEC);
+
+    if (max_fd < 0 || current_fd < 0 || stat_fd < 0) {
+        if (max_fd >= 0) close(max_fd);
+        if (current_fd >= 0) close(current_fd);
+        if (stat_fd >= 0) close(stat_fd);
+        return false;
+    }
+    g_cgroup_max_fd = max_fd;
+    g_cgroup_current_fd = current_fd;
+    g_cgroup_stat_fd = stat_fd;
+    return true;
+}
+
+static void meminfo_open(void) {
+    g_meminfo_fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+
+    // The cgroup v2 membership is the "0::<path>" line; the root cgroup has no limit
+    int fd = open("/proc/self/cgroup", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    char text[4096];
+    size_t length = meminfo_read(fd, text, sizeof(text));
+    close(fd);
+
+    const char* line = text;
+    while (line && line < text + length && strncmp(line, "0::", 3) != 0) {
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    if (!line || line >= text + length) return;
+
+    char path[256];
+    size_t path_length = strcspn(line + 3, "\n");
+    if (path_length == 0 || path_length >= sizeof(path)) return;
+    memcpy(path, line + 3, path_length);
+    path[path_length] = '\0';
+    if (strcmp(path, "/") == 0) return;
+
+    // Unified hierarchy, or hybrid systems that mount it separately
+    if (!meminfo_open_cgroup("/sys/fs/cgroup", path)) {
+        meminfo_open_cgroup("/sys/fs/cgroup/unified", path);
+    }
+}
+
+// Memory as seen by a limited cgroup v2; false when unlimited or unreadable, so the
+// caller falls back to the host view
+static bool meminfo_cgroup_sample(stream_buffer_t* out, uint64_t host_total_bytes) {
+    if (g_cgroup_max_fd < 0) return false;
+
+    char text[MEMINFO_READ_SIZE];
+    size_t length = meminfo_read(g_cgroup_max_fd, text, sizeof(text));
+    uint64_t limit = 0;
+    // "max" means unlimited, and a limit above physical memory changes nothing
+    if (!meminfo_parse_number(text, text + length, &limit) || limit == 0 || limit >= host_total_bytes) {
+        return false;
+    }
+
+    uint64_t current = 0;
+    length = meminfo_read(g_cgroup_current_fd, text, sizeof(text));
+    if (!meminfo_parse_number(text, text + length, &current)) return false;
+
+    uint64_t active_anon = 0, inactive_anon = 0, active_file = 0, inactive_file = 0;
+    uint64_t unevictable = 0, kernel_stack = 0, slab_unreclaimable = 0, pagetables = 0, zswap = 0;
+    const meminfo_field_t fields[] = {
+        { "active_anon ", &active_anon },
+        { "inactive_anon ", &inactive_anon },
+        { "active_file ", &active_file },
+        { "inactive_file ", &inactive_file },
+        { "unevictable ", &unevictable },
+        { "kernel_stack ", &kernel_stack },
+        { "slab_unreclaimable ", &slab_unreclaimable },
+        { "pagetables ", &pagetables },
+        { "zswap ", &zswap },
+    };
+    length = meminfo_read(g_cgroup_stat_fd, text, sizeof(text));
+    if (meminfo_parse(text, length, fields, (int)(sizeof(fields) / sizeof(fields[0]))) == 0) return false;
+
+    // Inactive page cache is reclaimed before the limit bites, so it does not count as used
+    uint64_t used = current > inactive_file ? current - inactive_file : 0;
+    uint64_t mb = 1024 * 1024;
+    return memory_sample(out, limit / mb, used / mb, (current < limit ? limit - current : 0) / mb,
+                         (active_anon + active_file) / mb, (inactive_anon + inactive_file) / mb,
+                         (unevictable + kernel_stack + slab_unreclaimable + pagetables) / mb,
+                         zswap / mb) > 0;
+}
+#endif
+
 // System memory stream handler (user-provided)
-void stream_system_memory(const char* stream_name, char* output_buffer, size_t buffer_size) {
+size_t stream_system_memory(const char* stream_name, stream_buffer_t* out) {
     (void)stream_name; // Unused parameter
     
 #ifdef __APPLE__
@@ -148,21 +401,13 @@ void stream_system_memory(const char* stream_name, char* output_buffer, size_t b
     mib[0] = CTL_HW;
     mib[1] = HW_MEMSIZE;
     if (sysctl(mib, 2, &physical_memory, &size, NULL, 0) != 0) {
-        time_t now = time(NULL);
-        snprintf(output_buffer, buffer_size,
-                "{\"timestamp\":%ld,\"error\":\"Failed to get total memory size\"}",
-                now);
-        return;
+        return memory_error(out, "Failed to get total memory size");
     }
     
     // Get page size
     vm_size_t page_size;
     if (host_page_size(mach_host_self(), &page_size) != KERN_SUCCESS) {
-        time_t now = time(NULL);
-        snprintf(output_buffer, buffer_size,
-                "{\"timestamp\":%ld,\"error\":\"Failed to get page size\"}",
-                now);
-        return;
+        return memory_error(out, "Failed to get page size");
     }
     
     // Get VM statistics for detailed breakdown
@@ -184,35 +429,65 @@ void stream_system_memory(const char* stream_name, char* output_buffer, size_t b
         uint64_t available_memory = free_memory + inactive_memory;
         uint64_t used_memory = total_memory - available_memory;
         
-        // Get current timestamp
-        time_t now = time(NULL);
-        
         // Format JSON response with corrected memory calculations
-        snprintf(output_buffer, buffer_size,
-                "{\"timestamp\":%ld,\"total_mb\":%llu,\"used_mb\":%llu,\"free_mb\":%llu,\"active_mb\":%llu,\"inactive_mb\":%llu,\"wired_mb\":%llu,\"compressed_mb\":%llu}",
-                now, total_memory, used_memory, free_memory, active_memory, inactive_memory, wired_memory, compressed_memory);
-    } else {
-        // Fallback data
-        time_t now = time(NULL);
-        snprintf(output_buffer, buffer_size,
-                "{\"timestamp\":%ld,\"error\":\"Failed to get memory statistics\"}",
-                now);
+        return memory_sample(out, total_memory, used_memory, free_memory, active_memory,
+                             inactive_memory, wired_memory, compressed_memory);
     }
+
+    // Fallback data
+    return memory_error(out, "Failed to get memory statistics");
+#elif defined(__linux__)
+    pthread_once(&g_meminfo_once, meminfo_open);
+
+    char text[MEMINFO_READ_SIZE];
+    size_t length = g_meminfo_fd >= 0 ? meminfo_read(g_meminfo_fd, text, sizeof(text)) : 0;
+
+    // Fields missing on older kernels stay 0
+    uint64_t total_kb = 0, free_kb = 0, available_kb = 0, active_kb = 0, inactive_kb = 0;
+    uint64_t unevictable_kb = 0, slab_unreclaimable_kb = 0, kernel_stack_kb = 0, page_tables_kb = 0;
+    uint64_t zswap_kb = 0;
+    const meminfo_field_t fields[] = {
+        { "MemTotal:", &total_kb },
+        { "MemFree:", &free_kb },
+        { "MemAvailable:", &available_kb },
+        { "Active:", &active_kb },
+        { "Inactive:", &inactive_kb },
+        { "Unevictable:", &unevictable_kb },
+        { "SUnreclaim:", &slab_unreclaimable_kb },
+        { "KernelStack:", &kernel_stack_kb },
+        { "PageTables:", &page_tables_kb },
+        { "Zswap:", &zswap_kb },
+    };
+    if (length == 0 || meminfo_parse(text, length, fields, (int)(sizeof(fields) / sizeof(fields[0]))) == 0 ||
+        total_kb == 0) {
+        return memory_error(out, "Failed to read /proc/meminfo");
+    }
+
+    // Inside a memory-limited container its own budget is what matters
+    if (meminfo_cgroup_sample(out, total_kb * 1024)) return out->length;
+
+    // Kernels before 3.14 lack MemAvailable; free plus inactive is the macOS estimate
+    if (available_kb == 0) available_kb = free_kb + inactive_kb;
+    uint64_t used_kb = total_kb > available_kb ? total_kb - available_kb : 0;
+
+    // Wired: what can never be paged out (mlocked pages and unreclaimable kernel memory)
+    return memory_sample(out, total_kb / 1024, used_kb / 1024, free_kb / 1024, active_kb / 1024,
+                         inactive_kb / 1024,
+                         (unevictable_kb + slab_unreclaimable_kb + kernel_stack_kb + page_tables_kb) / 1024,
+                         zswap_kb / 1024);
 #else
     // Fallback for other platforms
-    time_t now = time(NULL);
-    snprintf(output_buffer, buffer_size,
-            "{\"timestamp\":%ld,\"error\":\"Memory monitoring not implemented for this platform\"}",
-            now);
+    return memory_error(out, "Memory monitoring not implemented for this platform");
 #endif
 }
 
 // Network TCP dump stream handler (user-provided)
-void stream_network_tcpdump(const char* stream_name, char* output_buffer, size_t buffer_size) {
+size_t stream_network_tcpdump(const char* stream_name, stream_buffer_t* out) {
     (void)stream_name; // Unused parameter
     
     static int packet_count = 0;
     static char recent_packets[5][256]; // Store last 5 packets
+    static size_t recent_lengths[5];
     static int packet_index = 0;
     
     // Simulate TCP dump data (in real implementation, this would capture actual network traffic)
@@ -231,31 +506,37 @@ void stream_network_tcpdump(const char* stream_name, char* output_buffer, size_t
     int dst_port = (protocol_idx == 3) ? 80 : ((protocol_idx == 4) ? 443 : (packet_count % 65535));
     int packet_size = 64 + (packet_count % 1400);
     
-    // Create packet entry
-    snprintf(recent_packets[packet_index], sizeof(recent_packets[packet_index]),
+    // Create packet entry; its length is kept so building the sample needs no rescans
+    int entry_length = snprintf(recent_packets[packet_index], sizeof(recent_packets[packet_index]),
             "{\"protocol\":\"%s\",\"src\":\"%s:%d\",\"dst\":\"%s:%d\",\"size\":%d,\"time\":%ld}",
             protocols[protocol_idx], sources[src_idx], src_port, 
             destinations[dst_idx], dst_port, packet_size, now);
+    recent_lengths[packet_index] = entry_length < 0 ? 0 :
+        ((size_t)entry_length < sizeof(recent_packets[packet_index]) ? (size_t)entry_length
+                                                                     : sizeof(recent_packets[packet_index]) - 1);
     
     packet_index = (packet_index + 1) % 5;
     
     // Build JSON response with recent packets
-    snprintf(output_buffer, buffer_size,
-            "{\"timestamp\":%ld,\"packet_count\":%d,\"recent_packets\":[",
-            now, packet_count);
+    stream_buffer_append_str(out, "{\"timestamp\":");
+    stream_buffer_append_int(out, (int64_t)now);
+    stream_buffer_append_str(out, ",\"packet_count\":");
+    stream_buffer_append_int(out, packet_count);
+    stream_buffer_append_str(out, ",\"recent_packets\":[");
     
-    // Add recent packets (fix JSON formatting - no leading comma)
+    // Add recent packets, oldest first
     bool first_packet = true;
     for (int i = 0; i < 5; i++) {
         int idx = (packet_index + i) % 5;
-        if (strlen(recent_packets[idx]) > 0) {
+        if (recent_lengths[idx] > 0) {
             if (!first_packet) {
-                strcat(output_buffer, ",");
+                stream_buffer_append_char(out, ',');
             }
-            strcat(output_buffer, recent_packets[idx]);
+            stream_buffer_append(out, recent_packets[idx], recent_lengths[idx]);
             first_packet = false;
         }
     }
     
-    strcat(output_buffer, "]}");
-} 
\ No newline at end of file
+    stream_buffer_append_str(out, "]}");
+    return out->length;
+}
@@ -0,0 +1,287 @@
+#include "streaming_delta.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DELTA_MAX_MEMBERS 64
+#define DELTA_MAX_ITEMS 64
+
+typedef struct {
+    const char* data;
+    size_t length;
+} delta_span_t;
+
+typedef struct {
+    delta_span_t key;                 // Including the quotes, as sent
+    delta_span_t value;
+} delta_member_t;
+
+typedef enum {
+    DELTA_SAME,
+    DELTA_SET,
+    DELTA_APPEND
+} delta_kind_t;
+
+typedef struct {
+    char* out;
+    size_t size;
+    size_t length;
+    bool overflow;
+} delta_writer_t;
+
+static bool span_equals(delta_span_t a, delta_span_t b) {
+    return a.length == b.length && memcmp(a.data, b.data, a.length) == 0;
+}
+
+static size_t skip_space(const char* s, size_t length, size_t i) {
+    while (i < length && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+    return i;
+}
+
+// i points at the opening quote; returns the index past the closing one (0 on error)
+static size_t skip_string(const char* s, size_t length, size_t i) {
+    for (i++; i < length; i++) {
+        if (s[i] == '\\') {
+            i++;
+        } else if (s[i] == '"') {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Index past the value starting at i (0 on error)
+static size_t skip_value(const char* s, size_t length, size_t i) {
+    if (i >= length) return 0;
+    if (s[i] == '"') return skip_string(s, length, i);
+
+    if (s[i] == '{' || s[i] == '[') {
+        int depth = 0;
+        while (i < length) {
+            char c = s[i];
+            if (c == '"') {
+                i = skip_string(s, length, i);
+                if (i == 0) return 0;
+                continue;
+            }
+            if (c == '{' || c == '[') depth++;
+            if (c == '}' || c == ']') {
+                if (--depth == 0) return i + 1;
+            }
+            i++;
+        }
+        return 0;
+    }
+
+    // Number, true, false or null
+    size_t start = i;
+    while (i < length && s[i] != ',' && s[i] != '}' && s[i] != ']' &&
+           s[i] != ' ' && s[i] != '\t' && s[i] != '\r' && s[i] != '\n') {
+        i++;
+    }
+    return i > start ? i : 0;
+}
+
+// Split a JSON object into members; returns the count or -1
+static int split_object(const char* s, size_t length, delta_member_t* members, int max) {
+    size_t i = skip_space(s, length, 0);
+    if (i >= length || s[i] != '{') return -1;
+    i = skip_space(s, length, i + 1);
+    if (i < length && s[i] == '}') return 0;
+
+    int count = 0;
+    while (i < length) {
+        if (count == max || s[i] != '"') return -1;
+        size_t key_end = skip_string(s, length, i);
+        if (key_end == 0) return -1;
+        members[count].key.data = s + i;
+        members[count].key.length = key_end - i;
+
+        i = skip_space(s, length, key_end);
+        if (i >= length || s[i] != ':') return -1;
+        i = skip_space(s, length, i + 1);
+        size_t value_end = skip_value(s, length, i);
+        if (value_end == 0) return -1;
+        members[count].value.data = s + i;
+        members[count].value.length = value_end - i;
+        count++;
+
+        i = skip_space(s, length, value_end);
+        if (i < length && s[i] == '}') return count;
+        if (i >= length || s[i] != ',') return -1;
+        i = skip_space(s, length, i + 1);
+    }
+    return -1;
+}
+
+// Split a JSON array into items; returns the count or -1 (also for non-arrays)
+static int split_array(delta_span_t array, delta_span_t* items, int max) {
+    const char* s = array.data;
+    size_t length = array.length;
+    if (length < 2 || s[0] != '[') return -1;
+
+    size_t i = skip_space(s, length, 1);
+    if (i < length && s[i] == ']') return 0;
+
+    int count = 0;
+    while (i < length) {
+        if (count == max) return -1;
+        size_t end = skip_value(s, length, i);
+        if (end == 0) return -1;
+        items[count].data = s + i;
+        items[count].length = end - i;
+        count++;
+
+        i = skip_space(s, length, end);
+        if (i < length && s[i] == ']') return count;
+        if (i >= length || s[i] != ',') return -1;
+        i = skip_space(s, length, i + 1);
+    }
+    return -1;
+}
+
+// Sliding-window match: smallest drop such that old[drop..] is a prefix of new
+// and new has more items; returns false when the arrays do not overlap
+static bool match_append(delta_span_t previous, delta_span_t current, int* drop, int* first_new,
+                         delta_span_t* items, int* item_count) {
+    delta_span_t old_items[DELTA_MAX_ITEMS];
+    int old_count = split_array(previous, old_items, DELTA_MAX_ITEMS);
+    int new_count = split_array(current, items, DELTA_MAX_ITEMS);
+    if (old_count <= 0 || new_count <= 0) return false;
+
+    for (int k = 0; k < old_count; k++) {
+        int overlap = old_count - k;
+        if (overlap >= new_count) continue;
+
+        bool match = true;
+        for (int i = 0; i < overlap && match; i++) {
+            match = span_equals(old_items[k + i], items[i]);
+        }
+        if (match) {
+            *drop = k;
+            *first_new = overlap;
+            *item_count = new_count;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void write_bytes(delta_writer_t* writer, const char* data, size_t length) {
+    if (writer->overflow || writer->size - writer->length <= length) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->out + writer->length, data, length);
+    writer->length += length;
+    writer->out[writer->length] = '\0';
+}
+
+static void write_text(delta_writer_t* writer, const char* text) {
+    write_bytes(writer, text, strlen(text));
+}
+
+static void write_span(delta_writer_t* writer, delta_span_t span) {
+    write_bytes(writer, span.data, span.length);
+}
+
+// Open a "$section":{ (or [) the first time it is needed
+static void open_section(delta_writer_t* writer, bool* opened, bool* any, const char* header) {
+    if (*opened) {
+        write_text(writer, ",");
+        return;
+    }
+    if (*any) write_text(writer, ",");
+    write_text(writer, header);
+    *opened = true;
+    *any = true;
+}
+
+static int find_member(const delta_member_t* members, int count, delta_span_t key) {
+    for (int i = 0; i < count; i++) {
+        if (span_equals(members[i].key, key)) return i;
+    }
+    return -1;
+}
+
+size_t stream_delta_encode(const char* previous, size_t previous_length,
+                           const char* current, size_t current_length,
+                           char* out, size_t out_size) {
+    delta_member_t old_members[DELTA_MAX_MEMBERS];
+    delta_member_t new_members[DELTA_MAX_MEMBERS];
+    delta_kind_t kinds[DELTA_MAX_MEMBERS];
+
+    if (!previous || !current || out_size < 3) return 0;
+
+    int old_count = split_object(previous, previous_length, old_members, DELTA_MAX_MEMBERS);
+    int new_count = split_object(current, current_length, new_members, DELTA_MAX_MEMBERS);
+    if (old_count < 0 || new_count < 0) return 0;
+
+    // Classify every member of the new sample
+    for (int i = 0; i < new_count; i++) {
+        int match = find_member(old_members, old_count, new_members[i].key);
+        if (match < 0) {
+            kinds[i] = DELTA_SET;
+        } else if (span_equals(old_members[match].value, new_members[i].value)) {
+            kinds[i] = DELTA_SAME;
+        } else {
+            delta_span_t items[DELTA_MAX_ITEMS];
+            int drop, first_new, item_count;
+            kinds[i] = match_append(old_members[match].value, new_members[i].value,
+                                    &drop, &first_new, items, &item_count)
+                ? DELTA_APPEND : DELTA_SET;
+        }
+    }
+
+    delta_writer_t writer = { out, out_size, 0, false };
+    bool any = false;
+    bool opened = false;
+    write_text(&writer, "{");
+
+    for (int i = 0; i < new_count; i++) {
+        if (kinds[i] != DELTA_SET) continue;
+        open_section(&writer, &opened, &any, "\"$set\":{");
+        write_span(&writer, new_members[i].key);
+        write_text(&writer, ":");
+        write_span(&writer, new_members[i].value);
+    }
+    if (opened) write_text(&writer, "}");
+
+    opened = false;
+    for (int i = 0; i < old_count; i++) {
+        if (find_member(new_members, new_count, old_members[i].key) >= 0) continue;
+        open_section(&writer, &opened, &any, "\"$unset\":[");
+        write_span(&writer, old_members[i].key);
+    }
+    if (opened) write_text(&writer, "]");
+
+    opened = false;
+    for (int i = 0; i < new_count; i++) {
+        if (kinds[i] != DELTA_APPEND) continue;
+
+        int match = find_member(old_members, old_count, new_members[i].key);
+        delta_span_t items[DELTA_MAX_ITEMS];
+        int drop, first_new, item_count;
+        match_append(old_members[match].value, new_members[i].value,
+                     &drop, &first_new, items, &item_count);
+
+        // The appended items are contiguous in the new array, separators included
+        delta_span_t appended;
+        appended.data = items[first_new].data;
+        appended.length = (size_t)(items[item_count - 1].data + items[item_count - 1].length - appended.data);
+
+        char header[32];
+        open_section(&writer, &opened, &any, "\"$append\":{");
+        write_span(&writer, new_members[i].key);
+        int header_length = snprintf(header, sizeof(header), ":{\"drop\":%d,\"items\":[", drop);
+        write_bytes(&writer, header, (size_t)header_length);
+        write_span(&writer, appended);
+        write_text(&writer, "]}");
+    }
+    if (opened) write_text(&writer, "}");
+
+    write_text(&writer, "}");
+
+    if (writer.overflow || writer.length >= current_length) return 0;
+    return writer.length;
+}
@@ -0,0 +1,26 @@
+#ifndef STREAMING_DELTA_H
+#define STREAMING_DELTA_H
+
+#include <stddef.h>
+
+// Patch between two consecutive samples of a stream whose payload is a flat
+// JSON object. Only the top level is diffed; nested values are compared as
+// raw text and replaced whole. The patch is itself a JSON object:
+//
+//   {"$set":{"free_mb":812},                       changed or new members
+//    "$unset":["error"],                           members that disappeared
+//    "$append":{"recent_packets":{"drop":1,"items":[{...}]}}}
+//
+// "$append" covers arrays used as a sliding window: drop that many items
+// from the front, then append items. Clients apply a patch only on top of
+// the event immediately before it (SSE id - 1) and otherwise wait for the
+// next keyframe (see bridge/stream.ts applyStreamPatch).
+//
+// Returns the patch length, or 0 when a patch is not worth sending
+// (payloads are not objects, out is too small, or the patch would not be
+// smaller than current).
+size_t stream_delta_encode(const char* previous, size_t previous_length,
+                           const char* current, size_t current_length,
+                           char* out, size_t out_size);
+
+#endif // STREAMING_DELTA_H
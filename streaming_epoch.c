@@ -0,0 +1,51 @@
+#include "streaming_epoch.h"
+
+void stream_epoch_init(stream_epoch_t* epoch) {
+    epoch->global = 2;
+    epoch->readers[0] = 0;
+    epoch->readers[1] = 0;
+}
+
+// Register as a reader of the current epoch
+uint64_t stream_epoch_enter(stream_epoch_t* epoch) {
+    while (true) {
+        uint64_t current = __atomic_load_n(&epoch->global, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&epoch->readers[current & 1], 1, __ATOMIC_SEQ_CST);
+
+        // If the epoch moved before we were counted, a writer may already have
+        // checked our slot; back out and join the new epoch instead
+        if (__atomic_load_n(&epoch->global, __ATOMIC_SEQ_CST) == current) {
+            return current;
+        }
+        __atomic_sub_fetch(&epoch->readers[current & 1], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void stream_epoch_exit(stream_epoch_t* epoch, uint64_t token) {
+    __atomic_sub_fetch(&epoch->readers[token & 1], 1, __ATOMIC_SEQ_CST);
+}
+
+uint64_t stream_epoch_current(stream_epoch_t* epoch) {
+    return __atomic_load_n(&epoch->global, __ATOMIC_SEQ_CST);
+}
+
+// Move to the next epoch once the readers of the previous one have left
+bool stream_epoch_try_advance(stream_epoch_t* epoch) {
+    uint64_t current = __atomic_load_n(&epoch->global, __ATOMIC_SEQ_CST);
+
+    // The next epoch reuses the slot of current - 1
+    if (__atomic_load_n(&epoch->readers[(current + 1) & 1], __ATOMIC_SEQ_CST) != 0) {
+        return false;
+    }
+
+    // Another writer may have advanced concurrently; either way progress was made
+    __atomic_compare_exchange_n(&epoch->global, &current, current + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+// Readers that could see an object retired in epoch E entered in E - 1 or E;
+// both groups are gone once the epoch reaches E + 2
+bool stream_epoch_is_safe(stream_epoch_t* epoch, uint64_t retired_epoch) {
+    return stream_epoch_current(epoch) >= retired_epoch + 2;
+}
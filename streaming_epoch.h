@@ -0,0 +1,33 @@
+#ifndef STREAMING_EPOCH_H
+#define STREAMING_EPOCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Epoch-based reclamation for structures that event loops unlink while
+// other threads may still be walking them without a lock.
+//
+// Readers bracket every traversal with enter/exit; they are counted in one
+// of two slots selected by the epoch they entered in. A writer that unlinks
+// an object stamps it with the current epoch and frees it only once the
+// epoch has advanced twice, which requires every reader that could have
+// seen the object to have exited. Readers never block writers or each other.
+typedef struct {
+    uint64_t global;                  // Current epoch (atomic)
+    int readers[2];                   // Active readers per epoch parity (atomic)
+} stream_epoch_t;
+
+void stream_epoch_init(stream_epoch_t* epoch);
+
+// Reader side: returns a token to pass to stream_epoch_exit
+uint64_t stream_epoch_enter(stream_epoch_t* epoch);
+void stream_epoch_exit(stream_epoch_t* epoch, uint64_t token);
+
+// Writer side
+uint64_t stream_epoch_current(stream_epoch_t* epoch);
+bool stream_epoch_try_advance(stream_epoch_t* epoch);
+
+// Whether an object retired at retired_epoch can no longer be reached by a reader
+bool stream_epoch_is_safe(stream_epoch_t* epoch, uint64_t retired_epoch);
+
+#endif // STREAMING_EPOCH_H
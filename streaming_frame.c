@@ -0,0 +1,128 @@
+#include "streaming_frame.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char SSE_SUFFIX[] = "\n\n";
+static const char SSE_DATA_CONTINUATION[] = "\ndata: ";
+
+// Render an SSE frame; multi-line data is split into one data: line per line
+stream_frame_t* stream_frame_create_sse(const char* event_name, uint64_t id,
+                                        const char* data, size_t length) {
+    if (!event_name || (!data && length > 0)) return NULL;
+
+    char prefix[160];
+    int prefix_length;
+    if (id > 0) {
+        prefix_length = snprintf(prefix, sizeof(prefix), "event: %s\nid: %llu\ndata: ",
+                                 event_name, (unsigned long long)id);
+    } else {
+        prefix_length = snprintf(prefix, sizeof(prefix), "event: %s\ndata: ", event_name);
+    }
+    if (prefix_length < 0 || (size_t)prefix_length >= sizeof(prefix)) return NULL;
+
+    // Every embedded newline becomes "\ndata: " on the wire
+    size_t newlines = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == '\n') newlines++;
+    }
+    size_t body_length = length + newlines * (sizeof(SSE_DATA_CONTINUATION) - 2);
+    size_t raw_copy = newlines > 0 ? length + 1 : 0;
+
+    stream_frame_t* frame = malloc(sizeof(stream_frame_t) + (size_t)prefix_length +
+                                   body_length + 1 + raw_copy);
+    if (!frame) return NULL;
+
+    frame->refcount = 1;
+    frame->id = id;
+    frame->prefix_length = (size_t)prefix_length;
+    frame->suffix_length = sizeof(SSE_SUFFIX) - 1;
+    memcpy(frame->storage, prefix, (size_t)prefix_length);
+
+    char* body = frame->storage + prefix_length;
+    if (newlines == 0) {
+        memcpy(body, data, length);
+    } else {
+        char* out = body;
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] == '\n') {
+                memcpy(out, SSE_DATA_CONTINUATION, sizeof(SSE_DATA_CONTINUATION) - 1);
+                out += sizeof(SSE_DATA_CONTINUATION) - 1;
+            } else if (data[i] != '\r') {
+                *out++ = data[i];
+            }
+        }
+        body_length = (size_t)(out - body);
+    }
+    body[body_length] = '\0';
+    frame->body = body;
+    frame->body_length = body_length;
+
+    if (newlines == 0) {
+        frame->payload = body;
+    } else {
+        char* raw = body + body_length + 1;
+        memcpy(raw, data, length);
+        raw[length] = '\0';
+        frame->payload = raw;
+    }
+    frame->payload_length = length;
+
+    return frame;
+}
+
+// Wrap arbitrary bytes (already formatted for the wire)
+stream_frame_t* stream_frame_create_raw(const char* data, size_t length) {
+    stream_frame_t* frame = malloc(sizeof(stream_frame_t) + length + 1);
+    if (!frame) return NULL;
+
+    frame->refcount = 1;
+    frame->id = 0;
+    frame->prefix_length = 0;
+    frame->suffix_length = 0;
+    memcpy(frame->storage, data, length);
+    frame->storage[length] = '\0';
+    frame->body = frame->storage;
+    frame->body_length = length;
+    frame->payload = frame->storage;
+    frame->payload_length = length;
+    return frame;
+}
+
+stream_frame_t* stream_frame_retain(stream_frame_t* frame) {
+    if (frame) __atomic_add_fetch(&frame->refcount, 1, __ATOMIC_RELAXED);
+    return frame;
+}
+
+void stream_frame_release(stream_frame_t* frame) {
+    if (frame && __atomic_sub_fetch(&frame->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(frame);
+    }
+}
+
+// Total bytes the frame occupies on the wire
+size_t stream_frame_size(const stream_frame_t* frame) {
+    return frame->prefix_length + frame->body_length + frame->suffix_length;
+}
+
+// Fill iovecs for the frame's unsent bytes starting at offset; returns the count used
+int stream_frame_segments(const stream_frame_t* frame, size_t offset,
+                          struct iovec* iov, int max_iov) {
+    const char* bases[STREAM_FRAME_MAX_SEGMENTS] = { frame->storage, frame->body, SSE_SUFFIX };
+    size_t lengths[STREAM_FRAME_MAX_SEGMENTS] = {
+        frame->prefix_length, frame->body_length, frame->suffix_length
+    };
+
+    int count = 0;
+    for (int i = 0; i < STREAM_FRAME_MAX_SEGMENTS && count < max_iov; i++) {
+        if (offset >= lengths[i]) {
+            offset -= lengths[i];
+            continue;
+        }
+        iov[count].iov_base = (void*)(bases[i] + offset);
+        iov[count].iov_len = lengths[i] - offset;
+        offset = 0;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,40 @@
+#ifndef STREAMING_FRAME_H
+#define STREAMING_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#define STREAM_FRAME_MAX_SEGMENTS 3
+
+// Immutable, refcounted wire frame shared by every connection that sends it.
+// An SSE frame is rendered once as [event:/id:/data: prefix][data lines]["\n\n"];
+// a raw frame carries arbitrary bytes (HTTP headers, responses) in the body.
+typedef struct stream_frame {
+    int refcount;                     // Atomic
+    uint64_t id;                      // SSE event id (0 = none)
+    size_t prefix_length;             // "event: ...\nid: ...\ndata: " bytes at storage[0]
+    const char* body;                 // Data lines as they go on the wire
+    size_t body_length;
+    const char* payload;              // Original sample, NUL-terminated
+    size_t payload_length;
+    size_t suffix_length;             // 2 for SSE frames ("\n\n"), 0 for raw frames
+    char storage[];
+} stream_frame_t;
+
+// Construction
+stream_frame_t* stream_frame_create_sse(const char* event_name, uint64_t id,
+                                        const char* data, size_t length);
+stream_frame_t* stream_frame_create_raw(const char* data, size_t length);
+
+// Reference counting (safe from any thread)
+stream_frame_t* stream_frame_retain(stream_frame_t* frame);
+void stream_frame_release(stream_frame_t* frame);
+
+// Wire representation
+size_t stream_frame_size(const stream_frame_t* frame);
+int stream_frame_segments(const stream_frame_t* frame, size_t offset,
+                          struct iovec* iov, int max_iov);
+
+#endif // STREAMING_FRAME_H
@@ -0,0 +1,251 @@
+#include "streaming_http.h"
+#include <string.h>
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static bool is_token_char(char c) {
+    if (c >= 'a' && c <= 'z') return true;
+    if (c >= 'A' && c <= 'Z') return true;
+    if (c >= '0' && c <= '9') return true;
+    return c != '\0' && strchr("!#$%&'*+-.^_`|~", c) != NULL;
+}
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static stream_http_view_t view_trim(const char* data, size_t length) {
+    while (length > 0 && is_space(data[0])) {
+        data++;
+        length--;
+    }
+    while (length > 0 && is_space(data[length - 1])) {
+        length--;
+    }
+    stream_http_view_t view = { data, length };
+    return view;
+}
+
+static stream_http_result_t parse_fail(stream_http_parser_t* parser, const char* status) {
+    parser->error_status = status;
+    return STREAM_HTTP_ERROR;
+}
+
+// Reset for the next request on the connection
+void stream_http_parser_reset(stream_http_parser_t* parser) {
+    memset(parser, 0, sizeof(*parser));
+    parser->state = STREAM_HTTP_STATE_REQUEST_LINE;
+}
+
+// "GET /path?query HTTP/1.1"
+static stream_http_result_t parse_request_line(stream_http_parser_t* parser, const char* line, size_t length) {
+    stream_http_request_t* request = &parser->request;
+
+    const char* method_end = memchr(line, ' ', length);
+    if (!method_end || method_end == line) return parse_fail(parser, "400 Bad Request");
+    for (const char* c = line; c < method_end; c++) {
+        if (!is_token_char(*c)) return parse_fail(parser, "400 Bad Request");
+    }
+
+    const char* target = method_end + 1;
+    const char* line_end = line + length;
+    const char* target_end = memchr(target, ' ', (size_t)(line_end - target));
+    if (!target_end || target_end == target) return parse_fail(parser, "400 Bad Request");
+
+    const char* version = target_end + 1;
+    size_t version_length = (size_t)(line_end - version);
+    if (version_length != 8 || memcmp(version, "HTTP/", 5) != 0 ||
+        version[6] != '.' || version[7] < '0' || version[7] > '9') {
+        return parse_fail(parser, "400 Bad Request");
+    }
+    if (version[5] != '1') return parse_fail(parser, "505 HTTP Version Not Supported");
+
+    request->method.data = line;
+    request->method.length = (size_t)(method_end - line);
+    request->target.data = target;
+    request->target.length = (size_t)(target_end - target);
+    request->version_minor = version[7] - '0';
+    request->keep_alive = request->version_minor >= 1;
+
+    const char* question = memchr(target, '?', request->target.length);
+    request->path.data = target;
+    if (question) {
+        request->path.length = (size_t)(question - target);
+        request->query.data = question + 1;
+        request->query.length = (size_t)(target_end - question - 1);
+    } else {
+        request->path.length = request->target.length;
+        request->query.data = target_end;
+        request->query.length = 0;
+    }
+    return STREAM_HTTP_INCOMPLETE;
+}
+
+// "Name: value"; headers that affect framing are interpreted here
+static stream_http_result_t parse_header_line(stream_http_parser_t* parser, const char* line, size_t length) {
+    stream_http_request_t* request = &parser->request;
+
+    // Obsolete line folding is not accepted (RFC 9112 section 5.2)
+    if (is_space(line[0])) return parse_fail(parser, "400 Bad Request");
+
+    const char* colon = memchr(line, ':', length);
+    if (!colon || colon == line) return parse_fail(parser, "400 Bad Request");
+    for (const char* c = line; c < colon; c++) {
+        if (!is_token_char(*c)) return parse_fail(parser, "400 Bad Request");
+    }
+    if (request->header_count == STREAM_HTTP_MAX_HEADERS) {
+        return parse_fail(parser, "431 Request Header Fields Too Large");
+    }
+
+    stream_http_header_t* header = &request->headers[request->header_count++];
+    header->name.data = line;
+    header->name.length = (size_t)(colon - line);
+    header->value = view_trim(colon + 1, (size_t)(line + length - colon - 1));
+
+    if (stream_http_view_equals_nocase(header->name, "Content-Length")) {
+        if (header->value.length == 0 || header->value.length > 9) {
+            return parse_fail(parser, "400 Bad Request");
+        }
+        size_t content_length = 0;
+        for (size_t i = 0; i < header->value.length; i++) {
+            char c = header->value.data[i];
+            if (c < '0' || c > '9') return parse_fail(parser, "400 Bad Request");
+            content_length = content_length * 10 + (size_t)(c - '0');
+        }
+        // Conflicting lengths are a request smuggling vector
+        if (request->has_content_length && request->content_length != content_length) {
+            return parse_fail(parser, "400 Bad Request");
+        }
+        request->content_length = content_length;
+        request->has_content_length = true;
+    } else if (stream_http_view_equals_nocase(header->name, "Transfer-Encoding")) {
+        return parse_fail(parser, "501 Not Implemented");
+    } else if (stream_http_view_equals_nocase(header->name, "Connection")) {
+        if (stream_http_view_has_token(header->value, "close")) {
+            request->keep_alive = false;
+        } else if (stream_http_view_has_token(header->value, "keep-alive")) {
+            request->keep_alive = true;
+        }
+    }
+    return STREAM_HTTP_INCOMPLETE;
+}
+
+// Parse every complete line past parser->offset
+stream_http_result_t stream_http_parse(stream_http_parser_t* parser, const char* buffer,
+                                       size_t length, size_t capacity) {
+    while (parser->state != STREAM_HTTP_STATE_DONE) {
+        if (parser->state == STREAM_HTTP_STATE_BODY) {
+            // Bodies are not used by any endpoint; they are only skipped
+            size_t end = parser->offset + parser->request.content_length;
+            if (end > capacity) return parse_fail(parser, "413 Payload Too Large");
+            if (end > length) return STREAM_HTTP_INCOMPLETE;
+            parser->request.length = end;
+            parser->state = STREAM_HTTP_STATE_DONE;
+            break;
+        }
+
+        const char* line = buffer + parser->offset;
+        const char* newline = memchr(line, '\n', length - parser->offset);
+        if (!newline) {
+            if (length >= capacity) return parse_fail(parser, "431 Request Header Fields Too Large");
+            return STREAM_HTTP_INCOMPLETE;
+        }
+
+        size_t line_length = (size_t)(newline - line);
+        if (line_length > 0 && line[line_length - 1] == '\r') line_length--;
+        size_t next = (size_t)(newline - buffer) + 1;
+
+        stream_http_result_t result = STREAM_HTTP_INCOMPLETE;
+        if (parser->state == STREAM_HTTP_STATE_REQUEST_LINE) {
+            // Empty lines before the request line are ignored (RFC 9112 section 2.2)
+            if (line_length > 0) {
+                result = parse_request_line(parser, line, line_length);
+                parser->state = STREAM_HTTP_STATE_HEADERS;
+            }
+        } else if (line_length == 0) {
+            parser->state = STREAM_HTTP_STATE_BODY;
+        } else {
+            result = parse_header_line(parser, line, line_length);
+        }
+        if (result == STREAM_HTTP_ERROR) return result;
+
+        parser->offset = next;
+    }
+    return STREAM_HTTP_COMPLETE;
+}
+
+// First header with the given name
+const stream_http_view_t* stream_http_find_header(const stream_http_request_t* request, const char* name) {
+    for (int i = 0; i < request->header_count; i++) {
+        if (stream_http_view_equals_nocase(request->headers[i].name, name)) {
+            return &request->headers[i].value;
+        }
+    }
+    return NULL;
+}
+
+bool stream_http_view_equals(stream_http_view_t view, const char* text) {
+    size_t length = strlen(text);
+    return view.length == length && memcmp(view.data, text, length) == 0;
+}
+
+bool stream_http_view_equals_nocase(stream_http_view_t view, const char* text) {
+    size_t length = strlen(text);
+    if (view.length != length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (to_lower(view.data[i]) != to_lower(text[i])) return false;
+    }
+    return true;
+}
+
+// Whether a comma-separated header value lists the token
+bool stream_http_view_has_token(stream_http_view_t view, const char* token) {
+    size_t start = 0;
+    while (start <= view.length) {
+        size_t end = start;
+        while (end < view.length && view.data[end] != ',') end++;
+        if (stream_http_view_equals_nocase(view_trim(view.data + start, end - start), token)) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// First parameter called name; names are matched as sent (no percent-decoding)
+bool stream_http_query_param(stream_http_view_t query, const char* name, stream_http_view_t* value) {
+    size_t start = 0;
+    while (start < query.length) {
+        size_t end = start;
+        while (end < query.length && query.data[end] != '&') end++;
+
+        const char* pair = query.data + start;
+        size_t pair_length = end - start;
+        const char* equals = memchr(pair, '=', pair_length);
+        stream_http_view_t key = { pair, equals ? (size_t)(equals - pair) : pair_length };
+        if (stream_http_view_equals(key, name)) {
+            value->data = equals ? equals + 1 : pair + pair_length;
+            value->length = equals ? (size_t)(pair + pair_length - equals - 1) : 0;
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+bool stream_http_view_to_uint(stream_http_view_t view, unsigned long max, unsigned long* out) {
+    if (view.length == 0) return false;
+
+    unsigned long result = 0;
+    for (size_t i = 0; i < view.length; i++) {
+        char c = view.data[i];
+        if (c < '0' || c > '9') return false;
+        unsigned long digit = (unsigned long)(c - '0');
+        if (result > (max - digit) / 10) return false;
+        result = result * 10 + digit;
+    }
+    *out = result;
+    return true;
+}
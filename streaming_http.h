@@ -0,0 +1,75 @@
+#ifndef STREAMING_HTTP_H
+#define STREAMING_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STREAM_HTTP_MAX_HEADERS 32
+
+// Borrowed slice of the receive buffer (not NUL-terminated)
+typedef struct {
+    const char* data;
+    size_t length;
+} stream_http_view_t;
+
+typedef struct {
+    stream_http_view_t name;
+    stream_http_view_t value;
+} stream_http_header_t;
+
+// Parsed request; every view points into the caller's buffer and stays valid
+// until the request's bytes are consumed
+typedef struct {
+    stream_http_view_t method;
+    stream_http_view_t target;        // Path and query as sent
+    stream_http_view_t path;
+    stream_http_view_t query;         // Without the '?' (empty if absent)
+    int version_minor;                // HTTP/1.x
+    stream_http_header_t headers[STREAM_HTTP_MAX_HEADERS];
+    int header_count;
+    size_t content_length;
+    bool has_content_length;
+    bool keep_alive;
+    size_t length;                    // Bytes occupied by the request, body included
+} stream_http_request_t;
+
+typedef enum {
+    STREAM_HTTP_INCOMPLETE,           // Need more bytes
+    STREAM_HTTP_COMPLETE,             // request is ready
+    STREAM_HTTP_ERROR                 // error_status describes the failure
+} stream_http_result_t;
+
+typedef enum {
+    STREAM_HTTP_STATE_REQUEST_LINE,
+    STREAM_HTTP_STATE_HEADERS,
+    STREAM_HTTP_STATE_BODY,
+    STREAM_HTTP_STATE_DONE
+} stream_http_state_t;
+
+// Incremental parser: feed it the same growing buffer after every read;
+// complete lines are parsed once and never rescanned. capacity is the most
+// the buffer can ever hold, so oversized requests fail instead of stalling.
+typedef struct {
+    stream_http_state_t state;
+    size_t offset;                    // Start of the first unparsed line
+    stream_http_request_t request;
+    const char* error_status;         // e.g. "400 Bad Request"
+} stream_http_parser_t;
+
+void stream_http_parser_reset(stream_http_parser_t* parser);
+stream_http_result_t stream_http_parse(stream_http_parser_t* parser, const char* buffer,
+                                       size_t length, size_t capacity);
+
+// Header lookup and comparisons (case-insensitive where HTTP says so)
+const stream_http_view_t* stream_http_find_header(const stream_http_request_t* request, const char* name);
+bool stream_http_view_equals(stream_http_view_t view, const char* text);
+bool stream_http_view_equals_nocase(stream_http_view_t view, const char* text);
+bool stream_http_view_has_token(stream_http_view_t view, const char* token);
+
+// Query string access: value of the first "name=value" pair (empty for a bare "name")
+bool stream_http_query_param(stream_http_view_t query, const char* name, stream_http_view_t* value);
+
+// Decimal digits only; fails on anything else or a value above max
+bool stream_http_view_to_uint(stream_http_view_t view, unsigned long max, unsigned long* out);
+
+#endif // STREAMING_HTTP_H
@@ -0,0 +1,46 @@
+#include "streaming_mpsc.h"
+#include <stddef.h>
+
+void stream_mpsc_init(stream_mpsc_t* queue) {
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+}
+
+void stream_mpsc_push(stream_mpsc_t* queue, stream_mpsc_node_t* node) {
+    __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+    // Claim the head first, then link; between the two the consumer sees a gap
+    stream_mpsc_node_t* previous = __atomic_exchange_n(&queue->head, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+}
+
+stream_mpsc_node_t* stream_mpsc_pop(stream_mpsc_t* queue) {
+    stream_mpsc_node_t* tail = queue->tail;
+    stream_mpsc_node_t* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    // Step over the stub
+    if (tail == &queue->stub) {
+        if (!next) return NULL;
+        queue->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    // tail looks like the last node; if a producer has already claimed the
+    // head behind it, its link is not visible yet
+    if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) return NULL;
+
+    // Re-queue the stub so tail can be handed out without emptying the list
+    stream_mpsc_push(queue, &queue->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
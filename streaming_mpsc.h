@@ -0,0 +1,28 @@
+#ifndef STREAMING_MPSC_H
+#define STREAMING_MPSC_H
+
+#include <stdbool.h>
+
+// Intrusive multi-producer, single-consumer queue (Vyukov). Any thread may
+// push without locking; one consumer at a time pops in push order. Embed a
+// stream_mpsc_node_t in the queued object and recover it from the node.
+typedef struct stream_mpsc_node {
+    struct stream_mpsc_node* next;    // Atomic
+} stream_mpsc_node_t;
+
+typedef struct {
+    stream_mpsc_node_t* head;         // Atomic; producers swap themselves in here
+    stream_mpsc_node_t* tail;         // Consumer only
+    stream_mpsc_node_t stub;          // Keeps the list non-empty
+} stream_mpsc_t;
+
+void stream_mpsc_init(stream_mpsc_t* queue);
+
+// Producer side (any thread)
+void stream_mpsc_push(stream_mpsc_t* queue, stream_mpsc_node_t* node);
+
+// Consumer side. NULL when empty, and also when a push is midway through
+// linking its node; that producer's own wakeup follows, so callers retry then.
+stream_mpsc_node_t* stream_mpsc_pop(stream_mpsc_t* queue);
+
+#endif // STREAMING_MPSC_H
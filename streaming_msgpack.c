@@ -0,0 +1,402 @@
+#include "streaming_msgpack.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSGPACK_MAX_DEPTH 32
+
+void stream_msgpack_init(stream_msgpack_writer_t* writer, char* data, size_t size) {
+    writer->data = data;
+    writer->size = size;
+    writer->length = 0;
+    writer->overflow = false;
+}
+
+static void write_bytes(stream_msgpack_writer_t* writer, const void* data, size_t length) {
+    if (writer->overflow || writer->size - writer->length < length) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->data + writer->length, data, length);
+    writer->length += length;
+}
+
+static void write_byte(stream_msgpack_writer_t* writer, uint8_t byte) {
+    write_bytes(writer, &byte, 1);
+}
+
+// Type byte followed by a big-endian integer of size bytes
+static void write_be(stream_msgpack_writer_t* writer, uint8_t type, uint64_t value, int size) {
+    uint8_t bytes[9];
+    bytes[0] = type;
+    for (int i = 0; i < size; i++) {
+        bytes[1 + i] = (uint8_t)(value >> (8 * (size - 1 - i)));
+    }
+    write_bytes(writer, bytes, (size_t)size + 1);
+}
+
+void stream_msgpack_map(stream_msgpack_writer_t* writer, uint32_t count) {
+    if (count < 16) {
+        write_byte(writer, (uint8_t)(0x80 | count));
+    } else if (count <= 0xFFFF) {
+        write_be(writer, 0xDE, count, 2);
+    } else {
+        write_be(writer, 0xDF, count, 4);
+    }
+}
+
+void stream_msgpack_array(stream_msgpack_writer_t* writer, uint32_t count) {
+    if (count < 16) {
+        write_byte(writer, (uint8_t)(0x90 | count));
+    } else if (count <= 0xFFFF) {
+        write_be(writer, 0xDC, count, 2);
+    } else {
+        write_be(writer, 0xDD, count, 4);
+    }
+}
+
+static void write_str_header(stream_msgpack_writer_t* writer, size_t length) {
+    if (length < 32) {
+        write_byte(writer, (uint8_t)(0xA0 | length));
+    } else if (length <= 0xFF) {
+        write_be(writer, 0xD9, length, 1);
+    } else if (length <= 0xFFFF) {
+        write_be(writer, 0xDA, length, 2);
+    } else {
+        write_be(writer, 0xDB, length, 4);
+    }
+}
+
+void stream_msgpack_str(stream_msgpack_writer_t* writer, const char* text, size_t length) {
+    write_str_header(writer, length);
+    write_bytes(writer, text, length);
+}
+
+void stream_msgpack_uint(stream_msgpack_writer_t* writer, uint64_t value) {
+    if (value < 128) {
+        write_byte(writer, (uint8_t)value);
+    } else if (value <= 0xFF) {
+        write_be(writer, 0xCC, value, 1);
+    } else if (value <= 0xFFFF) {
+        write_be(writer, 0xCD, value, 2);
+    } else if (value <= 0xFFFFFFFFu) {
+        write_be(writer, 0xCE, value, 4);
+    } else {
+        write_be(writer, 0xCF, value, 8);
+    }
+}
+
+void stream_msgpack_int(stream_msgpack_writer_t* writer, int64_t value) {
+    if (value >= 0) {
+        stream_msgpack_uint(writer, (uint64_t)value);
+    } else if (value >= -32) {
+        write_byte(writer, (uint8_t)(int8_t)value);
+    } else if (value >= INT8_MIN) {
+        write_be(writer, 0xD0, (uint64_t)value, 1);
+    } else if (value >= INT16_MIN) {
+        write_be(writer, 0xD1, (uint64_t)value, 2);
+    } else if (value >= INT32_MIN) {
+        write_be(writer, 0xD2, (uint64_t)value, 4);
+    } else {
+        write_be(writer, 0xD3, (uint64_t)value, 8);
+    }
+}
+
+void stream_msgpack_double(stream_msgpack_writer_t* writer, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_be(writer, 0xCB, bits, 8);
+}
+
+void stream_msgpack_bool(stream_msgpack_writer_t* writer, bool value) {
+    write_byte(writer, value ? 0xC3 : 0xC2);
+}
+
+void stream_msgpack_nil(stream_msgpack_writer_t* writer) {
+    write_byte(writer, 0xC0);
+}
+
+// JSON to MessagePack
+
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t position;
+} json_input_t;
+
+static void skip_space(json_input_t* in) {
+    while (in->position < in->length) {
+        char c = in->text[in->position];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') break;
+        in->position++;
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const char* s, size_t length, size_t i, uint32_t* value) {
+    if (i + 4 > length) return false;
+    *value = 0;
+    for (size_t k = 0; k < 4; k++) {
+        int digit = hex_value(s[i + k]);
+        if (digit < 0) return false;
+        *value = (*value << 4) | (uint32_t)digit;
+    }
+    return true;
+}
+
+static size_t utf8_encode(uint32_t code, char* out) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+// Decode the string at in->position (on its opening quote) into out, or only
+// measure it when out is NULL; returns the decoded length or -1
+static long decode_string(const json_input_t* in, char* out, size_t* end) {
+    const char* s = in->text;
+    size_t i = in->position + 1;
+    long length = 0;
+
+    while (i < in->length) {
+        char c = s[i];
+        if (c == '"') {
+            *end = i + 1;
+            return length;
+        }
+        if ((unsigned char)c < 0x20) return -1;
+
+        if (c != '\\') {
+            if (out) out[length] = c;
+            length++;
+            i++;
+            continue;
+        }
+
+        if (++i >= in->length) return -1;
+        char escaped = s[i++];
+        char decoded;
+        switch (escaped) {
+        case '"': decoded = '"'; break;
+        case '\\': decoded = '\\'; break;
+        case '/': decoded = '/'; break;
+        case 'b': decoded = '\b'; break;
+        case 'f': decoded = '\f'; break;
+        case 'n': decoded = '\n'; break;
+        case 'r': decoded = '\r'; break;
+        case 't': decoded = '\t'; break;
+        case 'u': {
+            uint32_t code;
+            if (!read_hex4(s, in->length, i, &code)) return -1;
+            i += 4;
+            // Surrogate pair for characters outside the BMP
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                uint32_t low;
+                if (i + 1 >= in->length || s[i] != '\\' || s[i + 1] != 'u' ||
+                    !read_hex4(s, in->length, i + 2, &low) || low < 0xDC00 || low > 0xDFFF) {
+                    return -1;
+                }
+                i += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            char utf8[4];
+            size_t n = utf8_encode(code, utf8);
+            if (out) memcpy(out + length, utf8, n);
+            length += (long)n;
+            continue;
+        }
+        default:
+            return -1;
+        }
+        if (out) out[length] = decoded;
+        length++;
+    }
+    return -1;
+}
+
+static bool encode_string(stream_msgpack_writer_t* writer, json_input_t* in) {
+    size_t end;
+    long length = decode_string(in, NULL, &end);
+    if (length < 0) return false;
+
+    write_str_header(writer, (size_t)length);
+    if (writer->overflow || writer->size - writer->length < (size_t)length) {
+        writer->overflow = true;
+    } else {
+        decode_string(in, writer->data + writer->length, &end);
+        writer->length += (size_t)length;
+    }
+    in->position = end;
+    return true;
+}
+
+// Elements of the object or array at in->position, counted without descending
+static bool count_elements(const json_input_t* in, uint32_t* count) {
+    const char* s = in->text;
+    int depth = 0;
+    bool in_string = false;
+    bool empty = true;
+    *count = 0;
+
+    for (size_t i = in->position; i < in->length; i++) {
+        char c = s[i];
+        if (in_string) {
+            if (c == '\\') i++;
+            else if (c == '"') in_string = false;
+            continue;
+        }
+        if (c == '"') {
+            in_string = true;
+            if (depth == 1) empty = false;
+        } else if (c == '{' || c == '[') {
+            if (depth == 1) empty = false;
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                if (!empty) (*count)++;
+                return true;
+            }
+        } else if (depth == 1 && c == ',') {
+            (*count)++;
+        } else if (depth == 1 && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            empty = false;
+        }
+    }
+    return false;
+}
+
+static bool encode_number(stream_msgpack_writer_t* writer, json_input_t* in) {
+    size_t start = in->position;
+    bool is_float = false;
+    while (in->position < in->length) {
+        char c = in->text[in->position];
+        if (c == '.' || c == 'e' || c == 'E') {
+            is_float = true;
+        } else if (!(c == '-' || c == '+' || (c >= '0' && c <= '9'))) {
+            break;
+        }
+        in->position++;
+    }
+
+    char number[64];
+    size_t length = in->position - start;
+    if (length == 0 || length >= sizeof(number)) return false;
+    memcpy(number, in->text + start, length);
+    number[length] = '\0';
+
+    char* end;
+    if (!is_float) {
+        errno = 0;
+        long long value = strtoll(number, &end, 10);
+        if (*end == '\0' && errno != ERANGE) {
+            stream_msgpack_int(writer, (int64_t)value);
+            return true;
+        }
+    }
+    double value = strtod(number, &end);
+    if (*end != '\0') return false;
+    stream_msgpack_double(writer, value);
+    return true;
+}
+
+static bool encode_literal(json_input_t* in, const char* literal) {
+    size_t length = strlen(literal);
+    if (in->length - in->position < length || memcmp(in->text + in->position, literal, length) != 0) {
+        return false;
+    }
+    in->position += length;
+    return true;
+}
+
+static bool encode_value(stream_msgpack_writer_t* writer, json_input_t* in, int depth) {
+    skip_space(in);
+    if (in->position >= in->length || depth > MSGPACK_MAX_DEPTH) return false;
+
+    char c = in->text[in->position];
+    if (c == '"') return encode_string(writer, in);
+
+    if (c == '{' || c == '[') {
+        bool object = c == '{';
+        uint32_t count;
+        if (!count_elements(in, &count)) return false;
+        if (object) {
+            stream_msgpack_map(writer, count);
+        } else {
+            stream_msgpack_array(writer, count);
+        }
+        in->position++;
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (object) {
+                skip_space(in);
+                if (in->position >= in->length || in->text[in->position] != '"') return false;
+                if (!encode_string(writer, in)) return false;
+                skip_space(in);
+                if (in->position >= in->length || in->text[in->position] != ':') return false;
+                in->position++;
+            }
+            if (!encode_value(writer, in, depth + 1)) return false;
+            skip_space(in);
+            if (i + 1 < count) {
+                if (in->position >= in->length || in->text[in->position] != ',') return false;
+                in->position++;
+            }
+        }
+
+        skip_space(in);
+        if (in->position >= in->length || in->text[in->position] != (object ? '}' : ']')) return false;
+        in->position++;
+        return true;
+    }
+
+    if (c == 't' && encode_literal(in, "true")) {
+        stream_msgpack_bool(writer, true);
+        return true;
+    }
+    if (c == 'f' && encode_literal(in, "false")) {
+        stream_msgpack_bool(writer, false);
+        return true;
+    }
+    if (c == 'n' && encode_literal(in, "null")) {
+        stream_msgpack_nil(writer);
+        return true;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) return encode_number(writer, in);
+    return false;
+}
+
+bool stream_msgpack_json(stream_msgpack_writer_t* writer, const char* json, size_t length) {
+    size_t saved_length = writer->length;
+    bool saved_overflow = writer->overflow;
+    json_input_t in = { json, length, 0 };
+
+    bool ok = encode_value(writer, &in, 0);
+    skip_space(&in);
+    if (ok && in.position == in.length) return true;
+
+    writer->length = saved_length;
+    writer->overflow = saved_overflow;
+    return false;
+}
@@ -0,0 +1,32 @@
+#ifndef STREAMING_MSGPACK_H
+#define STREAMING_MSGPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal MessagePack writer for binary WebSocket events. Stream handlers
+// produce JSON text; stream_msgpack_json re-encodes it so clients skip
+// JSON.parse and numbers travel in binary.
+typedef struct {
+    char* data;
+    size_t size;
+    size_t length;
+    bool overflow;                    // Set once a write did not fit; later writes are dropped
+} stream_msgpack_writer_t;
+
+void stream_msgpack_init(stream_msgpack_writer_t* writer, char* data, size_t size);
+
+void stream_msgpack_map(stream_msgpack_writer_t* writer, uint32_t count);
+void stream_msgpack_array(stream_msgpack_writer_t* writer, uint32_t count);
+void stream_msgpack_str(stream_msgpack_writer_t* writer, const char* text, size_t length);
+void stream_msgpack_uint(stream_msgpack_writer_t* writer, uint64_t value);
+void stream_msgpack_int(stream_msgpack_writer_t* writer, int64_t value);
+void stream_msgpack_double(stream_msgpack_writer_t* writer, double value);
+void stream_msgpack_bool(stream_msgpack_writer_t* writer, bool value);
+void stream_msgpack_nil(stream_msgpack_writer_t* writer);
+
+// Encode one JSON value; false (writer left untouched) if the text is not valid JSON
+bool stream_msgpack_json(stream_msgpack_writer_t* writer, const char* json, size_t length);
+
+#endif // STREAMING_MSGPACK_H
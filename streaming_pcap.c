@@ -0,0 +1,440 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "streaming_pcap.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PCAP_MAGIC_MICROSECONDS 0xa1b2c3d4u
+#define PCAP_MAGIC_NANOSECONDS 0xa1b23c4du
+#define PCAP_GLOBAL_HEADER_SIZE 24
+#define PCAP_RECORD_HEADER_SIZE 16
+
+#define PCAPNG_SECTION_HEADER 0x0a0d0d0au
+#define PCAPNG_INTERFACE_DESCRIPTION 1u
+#define PCAPNG_SIMPLE_PACKET 3u
+#define PCAPNG_ENHANCED_PACKET 6u
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4du
+#define PCAPNG_OPTION_END 0
+#define PCAPNG_OPTION_IF_TSRESOL 9
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_ARP 0x0806
+#define ETHERTYPE_IPV6 0x86dd
+
+// Values in the file's byte order; pcap and pcapng are written in the capturing host's order
+static uint16_t pcap_u16(const stream_pcap_t* pcap, const uint8_t* p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return pcap->swapped ? __builtin_bswap16(value) : value;
+}
+
+static uint32_t pcap_u32(const stream_pcap_t* pcap, const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return pcap->swapped ? __builtin_bswap32(value) : value;
+}
+
+// Protocol headers are big-endian
+static uint16_t read_be16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint64_t pcap_units_to_ns(uint64_t units, uint64_t units_per_second) {
+    uint64_t seconds = units / units_per_second;
+    uint64_t fraction = units % units_per_second;
+    return seconds * 1000000000ull +
+           (uint64_t)((unsigned __int128)fraction * 1000000000ull / units_per_second);
+}
+
+bool stream_pcap_open(stream_pcap_t* pcap, const char* path) {
+    memset(pcap, 0, sizeof(*pcap));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Capture %s: cannot open\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < PCAP_GLOBAL_HEADER_SIZE) {
+        printf("Capture %s: too short to be a capture file\n", path);
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Capture %s: mmap failed\n", path);
+        return false;
+    }
+    // Replay walks the file front to back, possibly many times over
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    pcap->data = data;
+    pcap->size = (size_t)st.st_size;
+
+    uint32_t magic;
+    memcpy(&magic, pcap->data, sizeof(magic));
+    if (magic == PCAPNG_SECTION_HEADER) {
+        // Byte order is settled per section as blocks are read
+        pcap->pcapng = true;
+        pcap->first_offset = 0;
+    } else if (magic == PCAP_MAGIC_MICROSECONDS || magic == PCAP_MAGIC_NANOSECONDS ||
+               magic == __builtin_bswap32(PCAP_MAGIC_MICROSECONDS) ||
+               magic == __builtin_bswap32(PCAP_MAGIC_NANOSECONDS)) {
+        pcap->swapped = magic != PCAP_MAGIC_MICROSECONDS && magic != PCAP_MAGIC_NANOSECONDS;
+        pcap->nanosecond = pcap_u32(pcap, pcap->data) == PCAP_MAGIC_NANOSECONDS;
+        // The upper bits of the link type field carry FCS flags
+        pcap->linktype = pcap_u32(pcap, pcap->data + 20) & 0x0fffffff;
+        pcap->first_offset = PCAP_GLOBAL_HEADER_SIZE;
+    } else {
+        printf("Capture %s: not a pcap or pcapng file\n", path);
+        stream_pcap_close(pcap);
+        return false;
+    }
+
+    stream_pcap_rewind(pcap);
+    return true;
+}
+
+void stream_pcap_close(stream_pcap_t* pcap) {
+    if (pcap->data) {
+        munmap((void*)pcap->data, pcap->size);
+    }
+    memset(pcap, 0, sizeof(*pcap));
+}
+
+void stream_pcap_rewind(stream_pcap_t* pcap) {
+    pcap->offset = pcap->first_offset;
+    pcap->interface_count = 0;
+    pcap->last_timestamp_ns = 0;
+}
+
+static bool pcap_next_classic(stream_pcap_t* pcap, stream_pcap_packet_t* packet) {
+    if (pcap->size - pcap->offset < PCAP_RECORD_HEADER_SIZE) return false;
+
+    const uint8_t* record = pcap->data + pcap->offset;
+    uint32_t seconds = pcap_u32(pcap, record);
+    uint32_t fraction = pcap_u32(pcap, record + 4);
+    uint32_t captured = pcap_u32(pcap, record + 8);
+    if (captured > pcap->size - pcap->offset - PCAP_RECORD_HEADER_SIZE) return false;
+
+    packet->timestamp_ns = (uint64_t)seconds * 1000000000ull +
+                           (pcap->nanosecond ? fraction : (uint64_t)fraction * 1000ull);
+    packet->data = record + PCAP_RECORD_HEADER_SIZE;
+    packet->captured_length = captured;
+    packet->original_length = pcap_u32(pcap, record + 12);
+    packet->linktype = pcap->linktype;
+    pcap->offset += PCAP_RECORD_HEADER_SIZE + captured;
+    return true;
+}
+
+// Interface Description Block body: link type, snaplen and if_tsresol
+static void pcapng_add_interface(stream_pcap_t* pcap, const uint8_t* body, size_t length) {
+    if (length < 8 || pcap->interface_count >= STREAM_PCAP_MAX_INTERFACES) return;
+
+    stream_pcap_interface_t* interface = &pcap->interfaces[pcap->interface_count++];
+    interface->linktype = pcap_u16(pcap, body);
+    interface->snaplen = pcap_u32(pcap, body + 4);
+    interface->units_per_second = 1000000;
+
+    size_t offset = 8;
+    while (length - offset >= 4) {
+        uint16_t code = pcap_u16(pcap, body + offset);
+        uint16_t option_length = pcap_u16(pcap, body + offset + 2);
+        if (code == PCAPNG_OPTION_END || option_length > length - offset - 4) break;
+
+        if (code == PCAPNG_OPTION_IF_TSRESOL && option_length >= 1) {
+            // High bit set: a power of two, otherwise a power of ten
+            uint8_t resolution = body[offset + 4];
+            uint8_t exponent = resolution & 0x7f;
+            if (resolution & 0x80) {
+                if (exponent <= 63) interface->units_per_second = 1ull << exponent;
+            } else if (exponent <= 19) {
+                uint64_t units = 1;
+                for (uint8_t i = 0; i < exponent; i++) units *= 10;
+                interface->units_per_second = units;
+            }
+        }
+        offset += 4 + (((size_t)option_length + 3) & ~(size_t)3);
+    }
+}
+
+static bool pcap_next_pcapng(stream_pcap_t* pcap, stream_pcap_packet_t* packet) {
+    while (pcap->size - pcap->offset >= 12) {
+        const uint8_t* block = pcap->data + pcap->offset;
+        uint32_t type;
+        memcpy(&type, block, sizeof(type));
+
+        // A section header sets the byte order for itself and everything after it
+        if (type == PCAPNG_SECTION_HEADER) {
+            uint32_t byte_order;
+            memcpy(&byte_order, block + 8, sizeof(byte_order));
+            if (byte_order == PCAPNG_BYTE_ORDER_MAGIC) {
+                pcap->swapped = false;
+            } else if (byte_order == __builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+                pcap->swapped = true;
+            } else {
+                return false;
+            }
+            pcap->interface_count = 0;
+        } else {
+            type = pcap_u32(pcap, block);
+        }
+
+        uint32_t block_length = pcap_u32(pcap, block + 4);
+        if (block_length < 12 || (block_length & 3) || block_length > pcap->size - pcap->offset) {
+            return false;
+        }
+        pcap->offset += block_length;
+
+        const uint8_t* body = block + 8;
+        size_t body_length = block_length - 12;
+
+        if (type == PCAPNG_INTERFACE_DESCRIPTION) {
+            pcapng_add_interface(pcap, body, body_length);
+        } else if (type == PCAPNG_ENHANCED_PACKET && body_length >= 20) {
+            uint32_t interface_id = pcap_u32(pcap, body);
+            uint32_t captured = pcap_u32(pcap, body + 12);
+            if (interface_id >= (uint32_t)pcap->interface_count || captured > body_length - 20) continue;
+
+            const stream_pcap_interface_t* interface = &pcap->interfaces[interface_id];
+            uint64_t units = ((uint64_t)pcap_u32(pcap, body + 4) << 32) | pcap_u32(pcap, body + 8);
+            packet->timestamp_ns = pcap_units_to_ns(units, interface->units_per_second);
+            packet->data = body + 20;
+            packet->captured_length = captured;
+            packet->original_length = pcap_u32(pcap, body + 16);
+            packet->linktype = interface->linktype;
+            return true;
+        } else if (type == PCAPNG_SIMPLE_PACKET && body_length >= 4 && pcap->interface_count > 0) {
+            // No timestamp; it is taken to arrive together with the packet before it
+            uint32_t original = pcap_u32(pcap, body);
+            uint32_t captured = original;
+            if (pcap->interfaces[0].snaplen > 0 && captured > pcap->interfaces[0].snaplen) {
+                captured = pcap->interfaces[0].snaplen;
+            }
+            if (captured > body_length - 4) captured = (uint32_t)(body_length - 4);
+
+            packet->timestamp_ns = pcap->last_timestamp_ns;
+            packet->data = body + 4;
+            packet->captured_length = captured;
+            packet->original_length = original;
+            packet->linktype = pcap->interfaces[0].linktype;
+            return true;
+        }
+        // Statistics, name resolution, custom and unknown blocks carry no packets
+    }
+    return false;
+}
+
+bool stream_pcap_next(stream_pcap_t* pcap, stream_pcap_packet_t* packet) {
+    if (!pcap->data) return false;
+    bool found = pcap->pcapng ? pcap_next_pcapng(pcap, packet) : pcap_next_classic(pcap, packet);
+    if (found) pcap->last_timestamp_ns = packet->timestamp_ns;
+    return found;
+}
+
+// Transport ports, when the header is there and this is the first fragment
+static void decode_ports(stream_packet_info_t* info, const uint8_t* transport, size_t length) {
+    if ((info->protocol == 6 || info->protocol == 17) && length >= 4) {
+        info->has_ports = true;
+        info->src_port = read_be16(transport);
+        info->dst_port = read_be16(transport + 2);
+    }
+}
+
+static bool decode_ipv4(stream_packet_info_t* info, const uint8_t* ip, size_t length) {
+    if (length < 20 || (ip[0] >> 4) != 4) return false;
+    size_t header_length = (size_t)(ip[0] & 0x0f) * 4;
+    if (header_length < 20 || header_length > length) return false;
+
+    info->ip_version = 4;
+    info->protocol = ip[9];
+    info->src_addr = ip + 12;
+    info->dst_addr = ip + 16;
+    if ((read_be16(ip + 6) & 0x1fff) == 0) {
+        decode_ports(info, ip + header_length, length - header_length);
+    }
+    return true;
+}
+
+static bool decode_ipv6(stream_packet_info_t* info, const uint8_t* ip, size_t length) {
+    if (length < 40 || (ip[0] >> 4) != 6) return false;
+
+    info->ip_version = 6;
+    info->src_addr = ip + 8;
+    info->dst_addr = ip + 24;
+
+    // Walk extension headers to the upper-layer protocol
+    uint8_t next = ip[6];
+    size_t offset = 40;
+    bool first_fragment = true;
+    for (int hops = 0; hops < 8; hops++) {
+        size_t extension_length;
+        if (next == 0 || next == 43 || next == 60) {            // Hop-by-hop, routing, destination
+            if (length - offset < 2) break;
+            extension_length = ((size_t)ip[offset + 1] + 1) * 8;
+        } else if (next == 44) {                                // Fragment
+            if (length - offset < 8) break;
+            first_fragment = (read_be16(ip + offset + 2) >> 3) == 0;
+            extension_length = 8;
+        } else if (next == 51) {                                // Authentication header
+            if (length - offset < 2) break;
+            extension_length = ((size_t)ip[offset + 1] + 2) * 4;
+        } else {
+            break;
+        }
+        if (extension_length > length - offset) break;
+        next = ip[offset];
+        offset += extension_length;
+    }
+
+    info->protocol = next;
+    if (first_fragment) {
+        decode_ports(info, ip + offset, length - offset);
+    }
+    return true;
+}
+
+bool stream_packet_decode(const stream_pcap_packet_t* packet, stream_packet_info_t* info) {
+    memset(info, 0, sizeof(*info));
+    const uint8_t* p = packet->data;
+    size_t length = packet->captured_length;
+    size_t link_length = 0;
+
+    switch (packet->linktype) {
+    case STREAM_LINKTYPE_ETHERNET:
+        if (length < 14) return false;
+        info->ethertype = read_be16(p + 12);
+        link_length = 14;
+        // 802.1Q and 802.1ad tags, stacked at most twice
+        for (int tags = 0; tags < 2 && (info->ethertype == 0x8100 || info->ethertype == 0x88a8 ||
+                                        info->ethertype == 0x9100); tags++) {
+            if (length < link_length + 4) return false;
+            info->ethertype = read_be16(p + link_length + 2);
+            link_length += 4;
+        }
+        break;
+    case STREAM_LINKTYPE_LINUX_SLL:
+        if (length < 16) return false;
+        info->ethertype = read_be16(p + 14);
+        link_length = 16;
+        break;
+    case STREAM_LINKTYPE_LINUX_SLL2:
+        if (length < 20) return false;
+        info->ethertype = read_be16(p);
+        link_length = 20;
+        break;
+    case STREAM_LINKTYPE_NULL:
+        // The address family is in the capturing host's byte order; the IP version nibble is not
+        link_length = 4;
+        break;
+    case STREAM_LINKTYPE_RAW:
+    case 12:                                                    // DLT_RAW on some BSDs
+    case 14:                                                    // DLT_RAW on OpenBSD
+    case STREAM_LINKTYPE_IPV4:
+    case STREAM_LINKTYPE_IPV6:
+        break;
+    default:
+        return false;
+    }
+    if (length < link_length + 1) return false;
+
+    const uint8_t* ip = p + link_length;
+    size_t ip_length = length - link_length;
+    if (info->ethertype == ETHERTYPE_IPV4) return decode_ipv4(info, ip, ip_length);
+    if (info->ethertype == ETHERTYPE_IPV6) return decode_ipv6(info, ip, ip_length);
+    if (info->ethertype != 0) return false;
+
+    uint8_t version = ip[0] >> 4;
+    if (version == 4) return decode_ipv4(info, ip, ip_length);
+    if (version == 6) return decode_ipv6(info, ip, ip_length);
+    return false;
+}
+
+void stream_packet_window_init(stream_packet_window_t* window) {
+    memset(window, 0, sizeof(*window));
+}
+
+static const char* packet_protocol_name(const stream_packet_info_t* info, char* scratch, size_t size) {
+    if (info->ip_version == 0) {
+        if (info->ethertype == ETHERTYPE_ARP) return "ARP";
+        snprintf(scratch, size, "0x%04x", info->ethertype);
+        return scratch;
+    }
+    switch (info->protocol) {
+    case 1: return "ICMP";
+    case 2: return "IGMP";
+    case 6: return "TCP";
+    case 17: return "UDP";
+    case 47: return "GRE";
+    case 50: return "ESP";
+    case 58: return "ICMPv6";
+    case 132: return "SCTP";
+    default:
+        snprintf(scratch, size, "IP/%u", info->protocol);
+        return scratch;
+    }
+}
+
+// "addr", "addr:port" or "[v6addr]:port"
+static int packet_format_endpoint(char* out, size_t size, const stream_packet_info_t* info,
+                                  const uint8_t* addr, uint16_t port) {
+    char text[INET6_ADDRSTRLEN];
+    if (!addr || !inet_ntop(info->ip_version == 6 ? AF_INET6 : AF_INET, addr, text, sizeof(text))) {
+        text[0] = '\0';
+    }
+    if (!info->has_ports) return snprintf(out, size, "%s", text);
+    return snprintf(out, size, info->ip_version == 6 ? "[%s]:%u" : "%s:%u", text, port);
+}
+
+void stream_packet_window_add(stream_packet_window_t* window, const stream_pcap_packet_t* packet,
+                              const stream_packet_info_t* info) {
+    char protocol[16];
+    char src[INET6_ADDRSTRLEN + 8];
+    char dst[INET6_ADDRSTRLEN + 8];
+    packet_format_endpoint(src, sizeof(src), info, info->src_addr, info->src_port);
+    packet_format_endpoint(dst, sizeof(dst), info, info->dst_addr, info->dst_port);
+
+    window->timestamp = (int64_t)(packet->timestamp_ns / 1000000000ull);
+    window->packet_count++;
+
+    char* entry = window->entries[window->next];
+    int length = snprintf(entry, sizeof(window->entries[0]),
+                          "{\"protocol\":\"%s\",\"src\":\"%s\",\"dst\":\"%s\",\"size\":%u,\"time\":%lld}",
+                          packet_protocol_name(info, protocol, sizeof(protocol)), src, dst,
+                          packet->original_length, (long long)window->timestamp);
+    window->lengths[window->next] = length < 0 ? 0 :
+        ((size_t)length < sizeof(window->entries[0]) ? (size_t)length : sizeof(window->entries[0]) - 1);
+    window->next = (window->next + 1) % STREAM_PACKET_WINDOW_SIZE;
+}
+
+size_t stream_packet_window_write(const stream_packet_window_t* window, stream_buffer_t* out) {
+    stream_buffer_append_str(out, "{\"timestamp\":");
+    stream_buffer_append_int(out, window->timestamp);
+    stream_buffer_append_str(out, ",\"packet_count\":");
+    stream_buffer_append_uint(out, window->packet_count);
+    if (window->has_drops) {
+        stream_buffer_append_str(out, ",\"kernel_drops\":");
+        stream_buffer_append_uint(out, window->drops);
+    }
+    stream_buffer_append_str(out, ",\"recent_packets\":[");
+
+    // Oldest first
+    bool first_packet = true;
+    for (int i = 0; i < STREAM_PACKET_WINDOW_SIZE; i++) {
+        int idx = (window->next + i) % STREAM_PACKET_WINDOW_SIZE;
+        if (window->lengths[idx] == 0) continue;
+        if (!first_packet) stream_buffer_append_char(out, ',');
+        stream_buffer_append(out, window->entries[idx], window->lengths[idx]);
+        first_packet = false;
+    }
+
+    stream_buffer_append_str(out, "]}");
+    return out->length;
+}
@@ -0,0 +1,95 @@
+#ifndef STREAMING_PCAP_H
+#define STREAMING_PCAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "streaming_buffer.h"
+
+// Read-only access to .pcap and .pcapng captures. The file is mapped once;
+// packets and decoded headers point straight into the mapping, so nothing
+// is copied until a sample is written out.
+
+#define STREAM_PCAP_MAX_INTERFACES 16     // pcapng interfaces tracked per section
+#define STREAM_PACKET_WINDOW_SIZE 5       // Packets listed in each tcpdump sample
+
+// Link types (www.tcpdump.org/linktypes.html)
+#define STREAM_LINKTYPE_NULL 0
+#define STREAM_LINKTYPE_ETHERNET 1
+#define STREAM_LINKTYPE_RAW 101
+#define STREAM_LINKTYPE_LINUX_SLL 113
+#define STREAM_LINKTYPE_IPV4 228
+#define STREAM_LINKTYPE_IPV6 229
+#define STREAM_LINKTYPE_LINUX_SLL2 276
+
+typedef struct {
+    uint16_t linktype;
+    uint32_t snaplen;
+    uint64_t units_per_second;            // if_tsresol as a divisor (10^6 by default)
+} stream_pcap_interface_t;
+
+typedef struct {
+    const uint8_t* data;                  // Whole file, mapped read-only
+    size_t size;
+    size_t offset;                        // Next record or block
+    size_t first_offset;                  // Where stream_pcap_rewind returns to
+    bool pcapng;
+    bool swapped;                         // File byte order differs from ours
+    bool nanosecond;                      // Classic pcap with nanosecond timestamps
+    uint32_t linktype;                    // Classic pcap only
+    stream_pcap_interface_t interfaces[STREAM_PCAP_MAX_INTERFACES];  // Current pcapng section
+    int interface_count;
+    uint64_t last_timestamp_ns;           // Simple packet blocks have none of their own
+} stream_pcap_t;
+
+typedef struct {
+    uint64_t timestamp_ns;                // Capture time since the epoch
+    const uint8_t* data;                  // Into the mapping
+    uint32_t captured_length;
+    uint32_t original_length;             // On the wire
+    uint32_t linktype;
+} stream_pcap_packet_t;
+
+// Network and transport headers of one packet; addresses point into the packet
+typedef struct {
+    uint16_t ethertype;                   // 0 if the link layer does not say
+    uint8_t ip_version;                   // 4 or 6; 0 for anything else
+    uint8_t protocol;                     // IP protocol after IPv6 extension headers
+    const uint8_t* src_addr;              // 4 or 16 bytes, NULL without IP
+    const uint8_t* dst_addr;
+    bool has_ports;                       // TCP or UDP, first fragment only
+    uint16_t src_port;
+    uint16_t dst_port;
+} stream_packet_info_t;
+
+// Map a capture file; false (with a message printed) if it cannot be read or is not a capture
+bool stream_pcap_open(stream_pcap_t* pcap, const char* path);
+void stream_pcap_close(stream_pcap_t* pcap);
+void stream_pcap_rewind(stream_pcap_t* pcap);
+
+// Next packet in file order; false at the end or at the first truncated or corrupt record
+bool stream_pcap_next(stream_pcap_t* pcap, stream_pcap_packet_t* packet);
+
+// Decode link, network and transport headers; false if there is no IP header to describe
+// (info still carries the ethertype when the link layer has one)
+bool stream_packet_decode(const stream_pcap_packet_t* packet, stream_packet_info_t* info);
+
+// Sliding window of recent packets in the tcpdump stream's sample schema:
+// {"timestamp":..., "packet_count":..., "recent_packets":[{"protocol","src","dst","size","time"}, ...]}
+// plus "kernel_drops" when the source has one
+typedef struct {
+    char entries[STREAM_PACKET_WINDOW_SIZE][224];
+    size_t lengths[STREAM_PACKET_WINDOW_SIZE];
+    int next;                             // Slot the next packet overwrites (oldest entry)
+    uint64_t packet_count;
+    int64_t timestamp;                    // Capture second of the newest packet
+    bool has_drops;                       // Live captures report the kernel's drop counter
+    uint64_t drops;
+} stream_packet_window_t;
+
+void stream_packet_window_init(stream_packet_window_t* window);
+void stream_packet_window_add(stream_packet_window_t* window, const stream_pcap_packet_t* packet,
+                              const stream_packet_info_t* info);
+size_t stream_packet_window_write(const stream_packet_window_t* window, stream_buffer_t* out);
+
+#endif // STREAMING_PCAP_H
@@ -0,0 +1,147 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "streaming_poll.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+#define POLL_BATCH_MAX 256
+
+// Open the underlying kernel poller
+bool stream_poller_open(stream_poller_t* poller) {
+#ifdef __linux__
+    poller->fd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    poller->fd = kqueue();
+#endif
+    if (poller->fd < 0) {
+        printf("Failed to create poller: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Close the underlying kernel poller
+void stream_poller_close(stream_poller_t* poller) {
+    if (poller->fd >= 0) {
+        close(poller->fd);
+        poller->fd = -1;
+    }
+}
+
+// Register a descriptor for edge-triggered notifications
+bool stream_poller_add(stream_poller_t* poller, int fd, uint32_t events, void* data) {
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLET | EPOLLRDHUP;
+    if (events & STREAM_POLL_READ) ev.events |= EPOLLIN;
+    if (events & STREAM_POLL_WRITE) ev.events |= EPOLLOUT;
+    ev.data.ptr = data;
+    if (epoll_ctl(poller->fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        printf("Failed to register fd %d with poller: %s\n", fd, strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    struct kevent changes[2];
+    int count = 0;
+    if (events & STREAM_POLL_READ) {
+        EV_SET(&changes[count++], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, data);
+    }
+    if (events & STREAM_POLL_WRITE) {
+        EV_SET(&changes[count++], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, data);
+    }
+    if (kevent(poller->fd, changes, count, NULL, 0, NULL) != 0) {
+        printf("Failed to register fd %d with poller: %s\n", fd, strerror(errno));
+        return false;
+    }
+    return true;
+#endif
+}
+
+// Remove a descriptor from the poller (closing the fd also removes it)
+void stream_poller_remove(stream_poller_t* poller, int fd) {
+#ifdef __linux__
+    epoll_ctl(poller->fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+    struct kevent changes[2];
+    EV_SET(&changes[0], fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    EV_SET(&changes[1], fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    // Either filter may be absent; errors are expected and ignored
+    kevent(poller->fd, &changes[0], 1, NULL, 0, NULL);
+    kevent(poller->fd, &changes[1], 1, NULL, 0, NULL);
+#endif
+}
+
+// Wait for readiness events
+int stream_poller_wait(stream_poller_t* poller, stream_poll_event_t* events,
+                       int max_events, int timeout_ms) {
+    if (max_events > POLL_BATCH_MAX) max_events = POLL_BATCH_MAX;
+
+#ifdef __linux__
+    struct epoll_event raw[POLL_BATCH_MAX];
+    int n = epoll_wait(poller->fd, raw, max_events, timeout_ms);
+    if (n < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    for (int i = 0; i < n; i++) {
+        uint32_t flags = 0;
+        // A half-close (EPOLLRDHUP) is only the end of the request stream: it reads
+        // as EOF, and responses still queued go out before the connection closes
+        if (raw[i].events & (EPOLLIN | EPOLLRDHUP)) flags |= STREAM_POLL_READ;
+        if (raw[i].events & EPOLLOUT) flags |= STREAM_POLL_WRITE;
+        if (raw[i].events & EPOLLHUP) flags |= STREAM_POLL_HUP;
+        if (raw[i].events & EPOLLERR) flags |= STREAM_POLL_ERROR;
+        events[i].data = raw[i].data.ptr;
+        events[i].events = flags;
+    }
+    return n;
+#else
+    struct kevent raw[POLL_BATCH_MAX];
+    struct timespec ts;
+    struct timespec* tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    int n = kevent(poller->fd, NULL, 0, raw, max_events, tsp);
+    if (n < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    for (int i = 0; i < n; i++) {
+        uint32_t flags = 0;
+        if (raw[i].filter == EVFILT_READ) flags |= STREAM_POLL_READ;
+        if (raw[i].filter == EVFILT_WRITE) flags |= STREAM_POLL_WRITE;
+        // EOF on the read side is a half-close, seen as recv() == 0; on the write
+        // side the peer can take nothing more
+        if ((raw[i].flags & EV_EOF) && raw[i].filter == EVFILT_WRITE) flags |= STREAM_POLL_HUP;
+        if (raw[i].flags & EV_ERROR) flags |= STREAM_POLL_ERROR;
+        events[i].data = raw[i].udata;
+        events[i].events = flags;
+    }
+    return n;
+#endif
+}
+
+// Switch a descriptor to non-blocking mode
+bool stream_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return false;
+    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) return false;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef STREAMING_POLL_H
+#define STREAMING_POLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Readiness flags reported by the poller
+#define STREAM_POLL_READ   0x01
+#define STREAM_POLL_WRITE  0x02
+#define STREAM_POLL_HUP    0x04
+#define STREAM_POLL_ERROR  0x08
+
+// Edge-triggered readiness poller (epoll on Linux, kqueue on macOS)
+typedef struct {
+    int fd;
+} stream_poller_t;
+
+// Single readiness event returned by stream_poller_wait
+typedef struct {
+    void* data;
+    uint32_t events;
+} stream_poll_event_t;
+
+// Poller lifecycle
+bool stream_poller_open(stream_poller_t* poller);
+void stream_poller_close(stream_poller_t* poller);
+
+// Register a non-blocking descriptor for edge-triggered read/write readiness
+bool stream_poller_add(stream_poller_t* poller, int fd, uint32_t events, void* data);
+void stream_poller_remove(stream_poller_t* poller, int fd);
+
+// Wait for events; timeout_ms < 0 blocks indefinitely. Returns event count or -1
+int stream_poller_wait(stream_poller_t* poller, stream_poll_event_t* events,
+                       int max_events, int timeout_ms);
+
+// Socket helpers
+bool stream_set_nonblocking(int fd);
+
+#endif // STREAMING_POLL_H
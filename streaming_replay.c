@@ -0,0 +1,191 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "streaming.h"
+#include "streaming_pcap.h"
+#include "streaming_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPLAY_SLEEP_SLICE_NS 100000000ull   // Longest sleep between checks for stop
+#define REPLAY_RETRY_NS 1000000ull           // Back-off when an unpaced replay finds the queue full
+
+typedef struct stream_replay {
+    char stream_name[64];
+    char path[512];
+    stream_pcap_t pcap;
+    double speed;                     // 1 = original timing, N = N times faster, 0 = unpaced
+    bool loop;                        // Start over at the end of the file
+
+    pthread_t thread;
+    bool thread_started;
+    bool stop;                        // Atomic
+
+    // Replay thread only; reported when it stops
+    uint64_t packets_published;
+    uint64_t packets_dropped;
+    uint64_t passes;
+
+    struct stream_replay* next;
+} stream_replay_t;
+
+static stream_replay_t* g_replays = NULL;
+
+static uint64_t replay_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool replay_stopping(stream_replay_t* replay) {
+    return __atomic_load_n(&replay->stop, __ATOMIC_ACQUIRE);
+}
+
+static void replay_sleep_ns(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+// Sleep until the monotonic clock reaches due_ns; false if told to stop first
+static bool replay_wait_until(stream_replay_t* replay, uint64_t due_ns) {
+    for (;;) {
+        if (replay_stopping(replay)) return false;
+        uint64_t now = replay_now_ns();
+        if (now >= due_ns) return true;
+        uint64_t remaining = due_ns - now;
+        replay_sleep_ns(remaining < REPLAY_SLEEP_SLICE_NS ? remaining : REPLAY_SLEEP_SLICE_NS);
+    }
+}
+
+static void* replay_thread_func(void* arg) {
+    stream_replay_t* replay = (stream_replay_t*)arg;
+    stream_packet_window_t window;
+    stream_buffer_t sample;
+    stream_packet_window_init(&window);
+    stream_buffer_init(&sample);
+
+    while (!replay_stopping(replay)) {
+        stream_pcap_rewind(&replay->pcap);
+        uint64_t pass_started_ns = replay_now_ns();
+        uint64_t first_timestamp_ns = 0;
+        uint64_t packets_this_pass = 0;
+
+        stream_pcap_packet_t packet;
+        while (!replay_stopping(replay) && stream_pcap_next(&replay->pcap, &packet)) {
+            if (packets_this_pass++ == 0) first_timestamp_ns = packet.timestamp_ns;
+
+            // Packets are due at their offset into the capture, scaled; out-of-order
+            // timestamps go out right away
+            if (replay->speed > 0) {
+                uint64_t offset_ns = packet.timestamp_ns > first_timestamp_ns
+                                   ? packet.timestamp_ns - first_timestamp_ns : 0;
+                if (!replay_wait_until(replay, pass_started_ns + (uint64_t)((double)offset_ns / replay->speed))) {
+                    break;
+                }
+            }
+
+            stream_packet_info_t info;
+            stream_packet_decode(&packet, &info);
+            stream_packet_window_add(&window, &packet, &info);
+            stream_buffer_reset(&sample);
+            stream_packet_window_write(&window, &sample);
+            if (sample.failed) {
+                replay->packets_dropped++;
+                continue;
+            }
+
+            // Paced replays keep to the clock and drop what the stream cannot take;
+            // unpaced ones go exactly as fast as the owner loop drains
+            bool published = streaming_publish(replay->stream_name, sample.data, sample.length);
+            while (!published && replay->speed <= 0 && !replay_stopping(replay)) {
+                replay_sleep_ns(REPLAY_RETRY_NS);
+                published = streaming_publish(replay->stream_name, sample.data, sample.length);
+            }
+            if (published) {
+                replay->packets_published++;
+            } else {
+                replay->packets_dropped++;
+            }
+        }
+
+        if (packets_this_pass == 0) {
+            printf("Replay %s: no packets in %s\n", replay->stream_name, replay->path);
+            break;
+        }
+        if (replay_stopping(replay)) break;
+        replay->passes++;
+        if (!replay->loop) break;
+    }
+
+    stream_buffer_free(&sample);
+    return NULL;
+}
+
+// Replay a capture file into a push stream
+bool streaming_add_replay(const char* stream_name, const char* path, double speed, bool loop) {
+    if (!stream_name || !path || speed < 0) {
+        printf("Invalid parameters for capture replay\n");
+        return false;
+    }
+
+    stream_replay_t* replay = calloc(1, sizeof(stream_replay_t));
+    if (!replay) {
+        printf("Failed to allocate capture replay for %s\n", stream_name);
+        return false;
+    }
+    strncpy(replay->stream_name, stream_name, sizeof(replay->stream_name) - 1);
+    strncpy(replay->path, path, sizeof(replay->path) - 1);
+    replay->speed = speed;
+    replay->loop = loop;
+
+    // Mapped now so a bad path is reported at startup rather than on first subscribe
+    if (!stream_pcap_open(&replay->pcap, path)) {
+        free(replay);
+        return false;
+    }
+
+    replay->next = g_replays;
+    g_replays = replay;
+    printf("Replay %s: %s (%zu bytes, %s, speed %g%s)\n", stream_name, path, replay->pcap.size,
+           replay->pcap.pcapng ? "pcapng" : "pcap", speed, loop ? ", looping" : "");
+    return true;
+}
+
+void stream_replay_start_all(void) {
+    for (stream_replay_t* replay = g_replays; replay; replay = replay->next) {
+        if (replay->thread_started) continue;
+        __atomic_store_n(&replay->stop, false, __ATOMIC_RELEASE);
+        if (pthread_create(&replay->thread, NULL, replay_thread_func, replay) != 0) {
+            printf("Replay %s: failed to create thread\n", replay->stream_name);
+            continue;
+        }
+        replay->thread_started = true;
+    }
+}
+
+void stream_replay_stop_all(void) {
+    for (stream_replay_t* replay = g_replays; replay; replay = replay->next) {
+        __atomic_store_n(&replay->stop, true, __ATOMIC_RELEASE);
+    }
+    for (stream_replay_t* replay = g_replays; replay; replay = replay->next) {
+        if (!replay->thread_started) continue;
+        pthread_join(replay->thread, NULL);
+        replay->thread_started = false;
+        printf("Replay %s: %llu packets published, %llu dropped, %llu full passes\n", replay->stream_name,
+               (unsigned long long)replay->packets_published, (unsigned long long)replay->packets_dropped,
+               (unsigned long long)replay->passes);
+    }
+}
+
+void stream_replay_cleanup(void) {
+    stream_replay_stop_all();
+    while (g_replays) {
+        stream_replay_t* replay = g_replays;
+        g_replays = replay->next;
+        stream_pcap_close(&replay->pcap);
+        free(replay);
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef STREAMING_REPLAY_H
+#define STREAMING_REPLAY_H
+
+// Capture replays added with streaming_add_replay. Each runs on its own thread
+// while the server is running and publishes one tcpdump-style sample per packet.
+
+// Start every replay thread (after the event loops are up)
+void stream_replay_start_all(void);
+
+// Stop and join every replay thread (before the event loops go down)
+void stream_replay_stop_all(void);
+
+// Stop, unmap and forget every replay
+void stream_replay_cleanup(void);
+
+#endif // STREAMING_REPLAY_H
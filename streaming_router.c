@@ -0,0 +1,55 @@
+#include "streaming_router.h"
+#include <string.h>
+
+#define ROUTE_MASK (STREAM_ROUTE_SLOTS - 1)
+
+// FNV-1a; endpoint paths are short, so this beats anything fancier
+static uint32_t route_hash(const char* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void stream_route_table_init(stream_route_table_t* table) {
+    memset(table, 0, sizeof(*table));
+}
+
+bool stream_route_insert(stream_route_table_t* table, const char* key, int value) {
+    // Keep at least half the slots free so probe sequences stay short
+    if (table->count >= STREAM_ROUTE_SLOTS / 2) return false;
+
+    stream_http_view_t view = { key, strlen(key) };
+    uint32_t hash = route_hash(view.data, view.length);
+
+    for (uint32_t probe = 0; probe < STREAM_ROUTE_SLOTS; probe++) {
+        stream_route_t* slot = &table->slots[(hash + probe) & ROUTE_MASK];
+        if (__atomic_load_n(&slot->value, __ATOMIC_ACQUIRE) == 0) {
+            slot->hash = hash;
+            slot->key = key;
+            __atomic_store_n(&slot->value, value + 1, __ATOMIC_RELEASE);
+            table->count++;
+            return true;
+        }
+        if (slot->hash == hash && stream_http_view_equals(view, slot->key)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+int stream_route_lookup(const stream_route_table_t* table, stream_http_view_t key) {
+    uint32_t hash = route_hash(key.data, key.length);
+
+    for (uint32_t probe = 0; probe < STREAM_ROUTE_SLOTS; probe++) {
+        const stream_route_t* slot = &table->slots[(hash + probe) & ROUTE_MASK];
+        int value = __atomic_load_n(&slot->value, __ATOMIC_ACQUIRE);
+        if (value == 0) return -1;
+        if (slot->hash == hash && stream_http_view_equals(key, slot->key)) {
+            return value - 1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,33 @@
+#ifndef STREAMING_ROUTER_H
+#define STREAMING_ROUTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "streaming_http.h"
+
+// Slots per table; a power of two at least twice the number of routes
+#define STREAM_ROUTE_SLOTS 64
+
+// Open-addressing (linear probing) map from a path or name to a registry index.
+// Routes are only ever added, so lookups run without a lock: a slot's key is
+// written before its value is published with a release store.
+typedef struct {
+    uint32_t hash;
+    const char* key;                  // Must outlive the table (points into the registry)
+    int value;                        // Atomic; registry index + 1, 0 = empty slot
+} stream_route_t;
+
+typedef struct {
+    stream_route_t slots[STREAM_ROUTE_SLOTS];
+    int count;                        // Writer side only
+} stream_route_table_t;
+
+void stream_route_table_init(stream_route_table_t* table);
+
+// Writers must be serialized by the caller; fails on a duplicate key or a full table
+bool stream_route_insert(stream_route_table_t* table, const char* key, int value);
+
+// Registry index for key, or -1
+int stream_route_lookup(const stream_route_table_t* table, stream_http_view_t key);
+
+#endif // STREAMING_ROUTER_H
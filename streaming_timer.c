@@ -0,0 +1,189 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "streaming_timer.h"
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define WHEEL_MASK ((uint64_t)STREAM_TIMER_WHEEL_SIZE - 1)
+#define WHEEL_SPAN(level) ((uint64_t)1 << (STREAM_TIMER_WHEEL_BITS * ((level) + 1)))
+#define WHEEL_MAX_DELTA (WHEEL_SPAN(STREAM_TIMER_WHEEL_LEVELS - 1) - 1)
+
+// Monotonic clock in milliseconds
+uint64_t stream_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+// Initialize an empty wheel positioned at now_ms
+void stream_timer_queue_init(stream_timer_queue_t* queue, uint64_t now_ms) {
+    memset(queue, 0, sizeof(*queue));
+    queue->current_ms = now_ms;
+}
+
+// Initialize a timer (not armed)
+void stream_timer_init(stream_timer_t* timer, stream_timer_callback_t callback, void* user_data) {
+    timer->deadline_ms = 0;
+    timer->callback = callback;
+    timer->user_data = user_data;
+    timer->armed = false;
+    timer->slot = NULL;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+static void timer_link(stream_timer_t** head, stream_timer_t* timer) {
+    timer->slot = head;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head) (*head)->prev = timer;
+    *head = timer;
+}
+
+static void timer_unlink(stream_timer_t* timer) {
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        *timer->slot = timer->next;
+    }
+    if (timer->next) timer->next->prev = timer->prev;
+    timer->slot = NULL;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+// Place an armed timer in the slot matching its distance from the wheel position
+static void timer_place(stream_timer_queue_t* queue, stream_timer_t* timer) {
+    uint64_t deadline = timer->deadline_ms;
+    if (deadline < queue->current_ms) deadline = queue->current_ms;
+
+    uint64_t delta = deadline - queue->current_ms;
+    if (delta > WHEEL_MAX_DELTA) {
+        // Too far out: park at the top level's horizon and re-slot on cascade
+        delta = WHEEL_MAX_DELTA;
+        deadline = queue->current_ms + delta;
+    }
+
+    int level = 0;
+    while (level < STREAM_TIMER_WHEEL_LEVELS - 1 && delta >= WHEEL_SPAN(level)) {
+        level++;
+    }
+
+    size_t index = (size_t)((deadline >> (STREAM_TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+    timer_link(&queue->slots[level][index], timer);
+}
+
+// Arm (or re-arm) a timer for an absolute deadline; past deadlines fire on the next tick
+void stream_timer_schedule(stream_timer_queue_t* queue, stream_timer_t* timer, uint64_t deadline_ms) {
+    if (timer->armed) {
+        stream_timer_cancel(queue, timer);
+    }
+
+    timer->deadline_ms = deadline_ms;
+    timer->armed = true;
+    queue->count++;
+    timer_place(queue, timer);
+}
+
+// Disarm a timer
+void stream_timer_cancel(stream_timer_queue_t* queue, stream_timer_t* timer) {
+    if (!timer->armed) return;
+
+    timer_unlink(timer);
+    timer->armed = false;
+    queue->count--;
+}
+
+// Move every timer of a higher-level slot down to the level matching its deadline
+static void timer_cascade(stream_timer_queue_t* queue, int level) {
+    size_t index = (size_t)((queue->current_ms >> (STREAM_TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+    stream_timer_t* timer = queue->slots[level][index];
+    queue->slots[level][index] = NULL;
+
+    while (timer) {
+        stream_timer_t* next = timer->next;
+        timer_place(queue, timer);
+        timer = next;
+    }
+}
+
+// Milliseconds until the wheel next needs servicing
+int stream_timer_next_timeout(stream_timer_queue_t* queue, uint64_t now_ms) {
+    if (queue->count == 0) return -1;
+
+    uint64_t wake = UINT64_MAX;
+
+    // Level 0 slots hold exact deadlines
+    for (uint64_t k = 0; k < STREAM_TIMER_WHEEL_SIZE; k++) {
+        if (queue->slots[0][(queue->current_ms + k) & WHEEL_MASK]) {
+            wake = queue->current_ms + k;
+            break;
+        }
+    }
+
+    // Higher levels only need a wakeup when their next occupied slot cascades
+    for (int level = 1; level < STREAM_TIMER_WHEEL_LEVELS; level++) {
+        int shift = STREAM_TIMER_WHEEL_BITS * level;
+        uint64_t position = queue->current_ms >> shift;
+        // The current slot is still pending if the wheel sits exactly on its boundary
+        uint64_t first = (queue->current_ms & (((uint64_t)1 << shift) - 1)) == 0 ? 0 : 1;
+        for (uint64_t k = first; k < first + STREAM_TIMER_WHEEL_SIZE; k++) {
+            if (queue->slots[level][(position + k) & WHEEL_MASK]) {
+                uint64_t cascade_at = (position + k) << shift;
+                if (cascade_at < wake) wake = cascade_at;
+                break;
+            }
+        }
+    }
+
+    if (wake <= now_ms) return 0;
+    uint64_t delta = wake - now_ms;
+    return delta > 60000 ? 60000 : (int)delta;
+}
+
+// Advance tick by tick, cascading higher levels at slot boundaries
+void stream_timer_run_expired(stream_timer_queue_t* queue, uint64_t now_ms) {
+    while (queue->current_ms <= now_ms) {
+        if (queue->count == 0) {
+            queue->current_ms = now_ms + 1;
+            return;
+        }
+
+        uint64_t tick = queue->current_ms;
+        for (int level = 1; level < STREAM_TIMER_WHEEL_LEVELS; level++) {
+            if ((tick & ((WHEEL_SPAN(level - 1)) - 1)) != 0) break;
+            timer_cascade(queue, level);
+        }
+
+        // Detach the slot so callbacks re-arming for later ticks cannot loop
+        stream_timer_t** slot = &queue->slots[0][tick & WHEEL_MASK];
+        while (*slot) {
+            stream_timer_t* timer = *slot;
+            timer_unlink(timer);
+            timer_link(&queue->expired, timer);
+        }
+        queue->current_ms = tick + 1;
+
+        while (queue->expired) {
+            stream_timer_t* timer = queue->expired;
+            stream_timer_cancel(queue, timer);
+            // Callbacks may re-arm this timer or arm/cancel others
+            timer->callback(timer, timer->user_data);
+        }
+    }
+}
+
+// Next deadline of a periodic schedule, keeping the original phase
+uint64_t stream_timer_next_period(uint64_t previous, uint64_t interval_ms, uint64_t now_ms) {
+    if (interval_ms == 0) interval_ms = 1;
+    uint64_t next = previous + interval_ms;
+    if (next <= now_ms) {
+        // Fell behind: skip the missed periods instead of bursting to catch up
+        uint64_t missed = (now_ms - previous) / interval_ms;
+        next = previous + (missed + 1) * interval_ms;
+    }
+    return next;
+}
@@ -0,0 +1,56 @@
+#ifndef STREAMING_TIMER_H
+#define STREAMING_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hierarchical timing wheel: 4 levels of 64 slots at 1 ms resolution.
+// Level 0 covers 64 ms, level 1 ~4 s, level 2 ~4.4 min, level 3 ~4.7 h;
+// longer deadlines park in the top level and are re-slotted as it cascades.
+#define STREAM_TIMER_WHEEL_BITS 6
+#define STREAM_TIMER_WHEEL_SIZE (1 << STREAM_TIMER_WHEEL_BITS)
+#define STREAM_TIMER_WHEEL_LEVELS 4
+
+typedef struct stream_timer stream_timer_t;
+
+// Timer callback, invoked on the thread that owns the timer queue
+typedef void (*stream_timer_callback_t)(stream_timer_t* timer, void* user_data);
+
+// Intrusive timer; embed in the owning object and keep it alive while armed
+struct stream_timer {
+    uint64_t deadline_ms;             // Absolute CLOCK_MONOTONIC deadline
+    stream_timer_callback_t callback;
+    void* user_data;
+    bool armed;
+    stream_timer_t** slot;            // List head the timer is linked into
+    stream_timer_t* prev;
+    stream_timer_t* next;
+};
+
+// Timing wheel owned by a single event loop
+typedef struct {
+    uint64_t current_ms;              // Next tick that has not been processed
+    uint32_t count;                   // Armed timers
+    stream_timer_t* slots[STREAM_TIMER_WHEEL_LEVELS][STREAM_TIMER_WHEEL_SIZE];
+    stream_timer_t* expired;          // Timers being fired by the current tick
+} stream_timer_queue_t;
+
+// Monotonic clock in milliseconds
+uint64_t stream_now_ms(void);
+
+// Queue management (schedule and cancel are O(1))
+void stream_timer_queue_init(stream_timer_queue_t* queue, uint64_t now_ms);
+void stream_timer_init(stream_timer_t* timer, stream_timer_callback_t callback, void* user_data);
+void stream_timer_schedule(stream_timer_queue_t* queue, stream_timer_t* timer, uint64_t deadline_ms);
+void stream_timer_cancel(stream_timer_queue_t* queue, stream_timer_t* timer);
+
+// Milliseconds until the wheel next needs servicing (-1 when nothing is armed)
+int stream_timer_next_timeout(stream_timer_queue_t* queue, uint64_t now_ms);
+
+// Advance the wheel to now_ms, firing every timer whose deadline has passed
+void stream_timer_run_expired(stream_timer_queue_t* queue, uint64_t now_ms);
+
+// Next deadline of a periodic schedule anchored at `previous`, skipping missed periods
+uint64_t stream_timer_next_period(uint64_t previous, uint64_t interval_ms, uint64_t now_ms);
+
+#endif // STREAMING_TIMER_H
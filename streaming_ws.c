@@ -0,0 +1,340 @@
+#include "streaming_ws.h"
+#include <string.h>
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY_LENGTH 24              // Base64 of 16 random bytes
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;                  // Bytes hashed so far
+    uint8_t block[64];
+    size_t block_length;
+} ws_sha1_t;
+
+static uint32_t rotl32(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1_init(ws_sha1_t* sha) {
+    sha->state[0] = 0x67452301u;
+    sha->state[1] = 0xEFCDAB89u;
+    sha->state[2] = 0x98BADCFEu;
+    sha->state[3] = 0x10325476u;
+    sha->state[4] = 0xC3D2E1F0u;
+    sha->length = 0;
+    sha->block_length = 0;
+}
+
+static void sha1_transform(ws_sha1_t* sha, const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = sha->state[0], b = sha->state[1], c = sha->state[2], d = sha->state[3], e = sha->state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999u;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1u;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDCu;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6u;
+        }
+        uint32_t temp = rotl32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    sha->state[0] += a;
+    sha->state[1] += b;
+    sha->state[2] += c;
+    sha->state[3] += d;
+    sha->state[4] += e;
+}
+
+static void sha1_update(ws_sha1_t* sha, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    sha->length += length;
+    while (length > 0) {
+        size_t take = 64 - sha->block_length;
+        if (take > length) take = length;
+        memcpy(sha->block + sha->block_length, bytes, take);
+        sha->block_length += take;
+        bytes += take;
+        length -= take;
+        if (sha->block_length == 64) {
+            sha1_transform(sha, sha->block);
+            sha->block_length = 0;
+        }
+    }
+}
+
+static void sha1_final(ws_sha1_t* sha, uint8_t digest[20]) {
+    uint64_t bits = sha->length * 8;
+    uint8_t pad = 0x80;
+    sha1_update(sha, &pad, 1);
+    pad = 0;
+    while (sha->block_length != 56) {
+        sha1_update(sha, &pad, 1);
+    }
+    uint8_t length_bytes[8];
+    for (int i = 0; i < 8; i++) {
+        length_bytes[i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha1_update(sha, length_bytes, 8);
+
+    for (int i = 0; i < 20; i++) {
+        digest[i] = (uint8_t)(sha->state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+// Standard base64 with padding; out needs 4 * ((length + 2) / 3) + 1 bytes
+static void base64_encode(const uint8_t* data, size_t length, char* out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t chunk = (uint32_t)data[i] << 16;
+        if (i + 1 < length) chunk |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) chunk |= data[i + 2];
+        out[o++] = alphabet[(chunk >> 18) & 63];
+        out[o++] = alphabet[(chunk >> 12) & 63];
+        out[o++] = i + 1 < length ? alphabet[(chunk >> 6) & 63] : '=';
+        out[o++] = i + 2 < length ? alphabet[chunk & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+static bool is_base64_char(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '+' || c == '/' || c == '=';
+}
+
+bool stream_ws_accept_key(stream_http_view_t key, char accept[STREAM_WS_ACCEPT_SIZE]) {
+    if (key.length != WS_KEY_LENGTH) return false;
+    for (size_t i = 0; i < key.length; i++) {
+        if (!is_base64_char(key.data[i])) return false;
+    }
+
+    ws_sha1_t sha;
+    uint8_t digest[20];
+    sha1_init(&sha);
+    sha1_update(&sha, key.data, key.length);
+    sha1_update(&sha, WS_GUID, strlen(WS_GUID));
+    sha1_final(&sha, digest);
+    base64_encode(digest, sizeof(digest), accept);
+    return true;
+}
+
+static stream_ws_result_t frame_fail(int* close_code, int code) {
+    *close_code = code;
+    return STREAM_WS_ERROR;
+}
+
+stream_ws_result_t stream_ws_parse_frame(const char* data, size_t length, size_t max_payload,
+                                         stream_ws_frame_t* frame, int* close_code) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    if (length < 2) return STREAM_WS_INCOMPLETE;
+
+    // No extensions are negotiated, so the reserved bits must be clear
+    if (bytes[0] & 0x70) return frame_fail(close_code, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+    frame->fin = (bytes[0] & 0x80) != 0;
+    frame->opcode = (stream_ws_opcode_t)(bytes[0] & 0x0F);
+
+    switch (frame->opcode) {
+    case STREAM_WS_OP_CONTINUATION:
+    case STREAM_WS_OP_TEXT:
+    case STREAM_WS_OP_BINARY:
+    case STREAM_WS_OP_CLOSE:
+    case STREAM_WS_OP_PING:
+    case STREAM_WS_OP_PONG:
+        break;
+    default:
+        return frame_fail(close_code, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+    }
+
+    // Clients must mask every frame (RFC 6455 section 5.1)
+    if (!(bytes[1] & 0x80)) return frame_fail(close_code, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+
+    size_t header_length = 2;
+    uint64_t payload_length = bytes[1] & 0x7F;
+    if (payload_length == 126) {
+        header_length += 2;
+        if (length < header_length) return STREAM_WS_INCOMPLETE;
+        payload_length = ((uint64_t)bytes[2] << 8) | bytes[3];
+    } else if (payload_length == 127) {
+        header_length += 8;
+        if (length < header_length) return STREAM_WS_INCOMPLETE;
+        payload_length = 0;
+        for (int i = 0; i < 8; i++) payload_length = (payload_length << 8) | bytes[2 + i];
+    }
+
+    // Control frames are short and never fragmented (section 5.5)
+    if (frame->opcode >= STREAM_WS_OP_CLOSE && (!frame->fin || payload_length > 125)) {
+        return frame_fail(close_code, STREAM_WS_CLOSE_PROTOCOL_ERROR);
+    }
+    if (payload_length > max_payload) return frame_fail(close_code, STREAM_WS_CLOSE_TOO_BIG);
+
+    header_length += 4;
+    if (length < header_length) return STREAM_WS_INCOMPLETE;
+    memcpy(frame->mask, bytes + header_length - 4, 4);
+
+    frame->header_length = header_length;
+    frame->payload_length = (size_t)payload_length;
+    if (length - header_length < frame->payload_length) return STREAM_WS_INCOMPLETE;
+    return STREAM_WS_COMPLETE;
+}
+
+bool stream_ws_close_code_valid(int code) {
+    if (code >= 3000 && code <= 4999) return true;
+    if (code < 1000 || code > 1014) return false;
+    return code != 1004 && code != 1005 && code != 1006;
+}
+
+bool stream_ws_utf8_valid(const char* text, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)text;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t lead = bytes[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        // Sequence length and the range of the first continuation byte, which
+        // rules out overlong forms, surrogates and values past U+10FFFF
+        size_t count;
+        uint8_t low = 0x80, high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            count = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            count = 3;
+            if (lead == 0xE0) low = 0xA0;
+            if (lead == 0xED) high = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            count = 4;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F;
+        } else {
+            return false;
+        }
+
+        if (length - i < count) return false;
+        if (bytes[i + 1] < low || bytes[i + 1] > high) return false;
+        for (size_t j = 2; j < count; j++) {
+            if ((bytes[i + j] & 0xC0) != 0x80) return false;
+        }
+        i += count;
+    }
+    return true;
+}
+
+void stream_ws_unmask(char* payload, size_t length, const uint8_t mask[4]) {
+    for (size_t i = 0; i < length; i++) {
+        payload[i] = (char)((uint8_t)payload[i] ^ mask[i & 3]);
+    }
+}
+
+size_t stream_ws_frame_header(stream_ws_opcode_t opcode, size_t payload_length, char* out) {
+    uint8_t* bytes = (uint8_t*)out;
+    bytes[0] = (uint8_t)(0x80 | opcode);
+    if (payload_length < 126) {
+        bytes[1] = (uint8_t)payload_length;
+        return 2;
+    }
+    if (payload_length <= 0xFFFF) {
+        bytes[1] = 126;
+        bytes[2] = (uint8_t)(payload_length >> 8);
+        bytes[3] = (uint8_t)payload_length;
+        return 4;
+    }
+    bytes[1] = 127;
+    for (int i = 0; i < 8; i++) {
+        bytes[2 + i] = (uint8_t)((uint64_t)payload_length >> (56 - 8 * i));
+    }
+    return 10;
+}
+
+static size_t skip_space(const char* s, size_t length, size_t i) {
+    while (i < length && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+    return i;
+}
+
+// Index past the JSON value at i (0 on error)
+static size_t skip_value(const char* s, size_t length, size_t i) {
+    int depth = 0;
+    bool in_string = false;
+    size_t start = i;
+
+    for (; i < length; i++) {
+        char c = s[i];
+        if (in_string) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                in_string = false;
+                if (depth == 0) return i + 1;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) return i > start ? i : 0;
+            if (--depth == 0) return i + 1;
+        } else if (depth == 0 && (c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+            return i > start ? i : 0;
+        }
+    }
+    return depth == 0 && !in_string && i > start ? i : 0;
+}
+
+bool stream_ws_json_field(const char* json, size_t length, const char* key, char* out, size_t size) {
+    size_t key_length = strlen(key);
+    size_t i = skip_space(json, length, 0);
+    if (i >= length || json[i] != '{') return false;
+    i = skip_space(json, length, i + 1);
+
+    while (i < length && json[i] == '"') {
+        size_t name_end = skip_value(json, length, i);
+        if (name_end == 0) return false;
+        bool match = name_end - i - 2 == key_length && memcmp(json + i + 1, key, key_length) == 0;
+
+        i = skip_space(json, length, name_end);
+        if (i >= length || json[i] != ':') return false;
+        i = skip_space(json, length, i + 1);
+        size_t value_end = skip_value(json, length, i);
+        if (value_end == 0) return false;
+
+        if (match) {
+            const char* value = json + i;
+            size_t value_length = value_end - i;
+            if (value[0] == '"') {
+                value++;
+                value_length -= 2;
+            }
+            if (value_length >= size) return false;
+            memcpy(out, value, value_length);
+            out[value_length] = '\0';
+            return true;
+        }
+
+        i = skip_space(json, length, value_end);
+        if (i >= length || json[i] != ',') return false;
+        i = skip_space(json, length, i + 1);
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#ifndef STREAMING_WS_H
+#define STREAMING_WS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "streaming_http.h"
+
+// RFC 6455 pieces used by the streaming server: the opening handshake,
+// frame headers in both directions and lookups in JSON control messages
+
+#define STREAM_WS_MAX_HEADER 14       // Largest frame header (64-bit length plus mask)
+#define STREAM_WS_ACCEPT_SIZE 29      // Sec-WebSocket-Accept value plus NUL
+
+typedef enum {
+    STREAM_WS_OP_CONTINUATION = 0x0,
+    STREAM_WS_OP_TEXT = 0x1,
+    STREAM_WS_OP_BINARY = 0x2,
+    STREAM_WS_OP_CLOSE = 0x8,
+    STREAM_WS_OP_PING = 0x9,
+    STREAM_WS_OP_PONG = 0xA
+} stream_ws_opcode_t;
+
+// Close status codes (RFC 6455 section 7.4.1)
+#define STREAM_WS_CLOSE_NORMAL 1000
+#define STREAM_WS_CLOSE_GOING_AWAY 1001
+#define STREAM_WS_CLOSE_PROTOCOL_ERROR 1002
+#define STREAM_WS_CLOSE_UNSUPPORTED 1003
+#define STREAM_WS_CLOSE_INVALID_DATA 1007
+#define STREAM_WS_CLOSE_TOO_BIG 1009
+
+typedef enum {
+    STREAM_WS_INCOMPLETE,             // Need more bytes
+    STREAM_WS_COMPLETE,               // Header and payload are buffered
+    STREAM_WS_ERROR                   // close_code says why
+} stream_ws_result_t;
+
+// Header of one client frame
+typedef struct {
+    bool fin;
+    stream_ws_opcode_t opcode;
+    size_t header_length;
+    size_t payload_length;
+    uint8_t mask[4];
+} stream_ws_frame_t;
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key; false if the key is malformed
+bool stream_ws_accept_key(stream_http_view_t key, char accept[STREAM_WS_ACCEPT_SIZE]);
+
+// Parse the client frame at the start of data; payloads above max_payload are refused
+stream_ws_result_t stream_ws_parse_frame(const char* data, size_t length, size_t max_payload,
+                                         stream_ws_frame_t* frame, int* close_code);
+void stream_ws_unmask(char* payload, size_t length, const uint8_t mask[4]);
+
+// Whether a close code may appear in a Close frame: the assigned codes except
+// 1005, 1006 and 1015, which are reserved for reporting, plus 3000-4999
+bool stream_ws_close_code_valid(int code);
+
+// Whether text is well-formed UTF-8: no overlong forms, surrogates or code points
+// above U+10FFFF. Text messages and close reasons must pass (RFC 6455 section 8.1)
+bool stream_ws_utf8_valid(const char* text, size_t length);
+
+// Unmasked, final server frame header; out needs STREAM_WS_MAX_HEADER bytes. Returns its length.
+size_t stream_ws_frame_header(stream_ws_opcode_t opcode, size_t payload_length, char* out);
+
+// Top-level member of a flat JSON object: strings without their quotes, other values as
+// written. Escapes are not decoded. False if absent or too long for out.
+bool stream_ws_json_field(const char* json, size_t length, const char* key, char* out, size_t size);
+
+#endif // STREAMING_WS_H
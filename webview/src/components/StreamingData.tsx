@@ -2,7 +2,8 @@ import { useState, useEffect, useRef } from "react";
 import bridge from "../bridge/bridge";
 import {
   streamManager,
-  STREAM_ENDPOINTS,
+  streamMultiplexer,
+  STREAM_NAMES,
   type MemoryData,
 } from "../bridge/stream";
 
@@ -32,7 +33,7 @@ export function StreamingData() {
     getStreamingConfig();
   }, []);
 
-  // Setup stream manager and connect to memory stream
+  // Subscribe to the memory stream
   useEffect(() => {
     if (!streamingConfig?.enabled || connectionInitialized.current) {
       return;
@@ -40,42 +41,32 @@ export function StreamingData() {
 
     connectionInitialized.current = true;
 
-    // Setup event handlers
-    streamManager.onData<MemoryData>((data) => {
-      console.log("Memory data received:", data);
-      setMemoryData(data);
-      setError(""); // Clear any previous errors
-    });
-
-    streamManager.onError((errorMsg) => {
-      console.error("Stream error:", errorMsg);
-      setError(errorMsg);
-    });
-
-    streamManager.onConnection((connected) => {
-      console.log("Connection status changed:", connected);
-      setIsConnected(connected);
-      if (!connected) {
-        setError("Stream disconnected");
+    // Subscribe on the shared multiplexed connection
+    const unsubscribe = streamMultiplexer.subscribe<MemoryData>(
+      STREAM_NAMES.MEMORY,
+      {
+        onData: (data) => {
+          console.log("Memory data received:", data);
+          setMemoryData(data);
+          setError(""); // Clear any previous errors
+        },
+        onError: (errorMsg) => {
+          console.error("Stream error:", errorMsg);
+          setError(errorMsg);
+        },
+        onConnection: (connected) => {
+          console.log("Connection status changed:", connected);
+          setIsConnected(connected);
+          if (!connected) {
+            setError("Stream disconnected");
+          }
+        },
       }
-    });
-
-    // Connect to memory stream
-    const connectToStream = async () => {
-      try {
-        console.log("Connecting to memory stream...");
-        await streamManager.connect(STREAM_ENDPOINTS.MEMORY);
-      } catch (err) {
-        console.error("Failed to connect to memory stream:", err);
-        setError(`Failed to connect to memory stream: ${err}`);
-      }
-    };
-
-    connectToStream();
+    );
 
     // Cleanup on unmount
     return () => {
-      streamManager.disconnect();
+      unsubscribe();
       connectionInitialized.current = false;
     };
   }, [streamingConfig]);
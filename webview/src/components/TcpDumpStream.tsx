@@ -1,10 +1,10 @@
 import { useState, useEffect, useRef } from "react";
 import bridge from "../bridge/bridge";
 import {
-  createStreamManager,
-  STREAM_ENDPOINTS,
+  streamManager,
+  streamMultiplexer,
+  STREAM_NAMES,
   type TcpDumpData,
-  type StreamManager,
 } from "../bridge/stream";
 
 export function TcpDumpStream() {
@@ -15,7 +15,6 @@ export function TcpDumpStream() {
     enabled: boolean;
     port: number;
   } | null>(null);
-  const streamManagerRef = useRef<StreamManager | null>(null);
   const connectionInitialized = useRef(false);
 
   // Get streaming configuration
@@ -34,7 +33,7 @@ export function TcpDumpStream() {
     getStreamingConfig();
   }, []);
 
-  // Setup stream manager and connect to TCP dump stream
+  // Subscribe to the TCP dump stream
   useEffect(() => {
     if (!streamingConfig?.enabled || connectionInitialized.current) {
       return;
@@ -42,49 +41,32 @@ export function TcpDumpStream() {
 
     connectionInitialized.current = true;
 
-    // Create a dedicated stream manager for this component
-    const manager = createStreamManager();
-    streamManagerRef.current = manager;
-
-    // Setup event handlers
-    manager.onData<TcpDumpData>((data) => {
-      console.log("TCP dump data received:", data);
-      setTcpData(data);
-      setError(""); // Clear any previous errors
-    });
-
-    manager.onError((errorMsg) => {
-      console.error("TCP dump stream error:", errorMsg);
-      setError(errorMsg);
-    });
-
-    manager.onConnection((connected) => {
-      console.log("TCP dump connection status changed:", connected);
-      setIsConnected(connected);
-      if (!connected) {
-        setError("TCP dump stream disconnected");
+    // Subscribe on the shared multiplexed connection
+    const unsubscribe = streamMultiplexer.subscribe<TcpDumpData>(
+      STREAM_NAMES.TCPDUMP,
+      {
+        onData: (data) => {
+          console.log("TCP dump data received:", data);
+          setTcpData(data);
+          setError(""); // Clear any previous errors
+        },
+        onError: (errorMsg) => {
+          console.error("TCP dump stream error:", errorMsg);
+          setError(errorMsg);
+        },
+        onConnection: (connected) => {
+          console.log("TCP dump connection status changed:", connected);
+          setIsConnected(connected);
+          if (!connected) {
+            setError("TCP dump stream disconnected");
+          }
+        },
       }
-    });
-
-    // Connect to TCP dump stream
-    const connectToStream = async () => {
-      try {
-        console.log("Connecting to TCP dump stream...");
-        await manager.connect(STREAM_ENDPOINTS.TCPDUMP);
-      } catch (err) {
-        console.error("Failed to connect to TCP dump stream:", err);
-        setError(`Failed to connect to TCP dump stream: ${err}`);
-      }
-    };
-
-    connectToStream();
+    );
 
     // Cleanup on unmount
     return () => {
-      if (streamManagerRef.current) {
-        streamManagerRef.current.disconnect();
-        streamManagerRef.current = null;
-      }
+      unsubscribe();
       connectionInitialized.current = false;
     };
   }, [streamingConfig]);
@@ -145,13 +127,13 @@ export function TcpDumpStream() {
       )}
 
       {/* TCP Dump Data */}
-      {tcpData && streamManagerRef.current ? (
+      {tcpData ? (
         <div>
           <div
             style={{ marginBottom: "1rem", fontSize: "0.9rem", color: "#666" }}
           >
             Last updated:{" "}
-            {streamManagerRef.current.formatTimestamp(tcpData.timestamp)}
+            {streamManager.formatTimestamp(tcpData.timestamp)}
           </div>
 
           {/* Packet Summary */}
@@ -178,6 +160,19 @@ export function TcpDumpStream() {
               <span>Recent Packets:</span>
               <span>{tcpData.recent_packets.length}</span>
             </div>
+            {tcpData.kernel_drops !== undefined && (
+              <div
+                style={{
+                  display: "flex",
+                  justifyContent: "space-between",
+                  fontSize: "0.9rem",
+                  color: tcpData.kernel_drops > 0 ? "#f44336" : "#666",
+                }}
+              >
+                <span>Kernel Drops:</span>
+                <span>{tcpData.kernel_drops}</span>
+              </div>
+            )}
           </div>
 
           {/* Recent Packets */}
@@ -227,7 +222,7 @@ export function TcpDumpStream() {
                       </span>
                     </div>
                     <div style={{ fontSize: "0.7rem", color: "#888" }}>
-                      {streamManagerRef.current?.formatTimestamp(packet.time)}
+                      {streamManager.formatTimestamp(packet.time)}
                     </div>
                   </div>
                 ))
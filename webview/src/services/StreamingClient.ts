@@ -1,11 +1,22 @@
-// TCP Streaming Client for real-time data
+// WebSocket Streaming Client for real-time data
+import { decodeMessagePack } from "./msgpack";
+
+// Stream event, sent by the server as a binary MessagePack frame
 export interface StreamMessage {
-  type: string;
+  type: string; // "data", or "batch" when data is an array of samples
   stream: string;
+  id?: number;
   data: unknown;
   timestamp: number;
 }
 
+// Text reply to a subscribe/unsubscribe request
+interface StreamControlReply {
+  type: "subscribed" | "unsubscribed" | "error";
+  stream?: string;
+  message?: string;
+}
+
 export interface StreamingClientOptions {
   host: string;
   port: number;
@@ -22,6 +33,8 @@ export class StreamingClient {
     string,
     Set<(data: StreamMessage) => void>
   >();
+  // Newest event id per stream, so a reconnect resumes where it left off
+  private lastEventIds = new Map<string, number>();
   private options: StreamingClientOptions;
 
   constructor(options: Partial<StreamingClientOptions> = {}) {
@@ -37,26 +50,33 @@ export class StreamingClient {
   connect(): Promise<void> {
     return new Promise((resolve, reject) => {
       try {
-        // Use WebSocket to connect to the TCP server
-        // Note: This requires a WebSocket-to-TCP bridge or the backend to support WebSocket protocol
-        const url = `ws://${this.options.host}:${this.options.port}`;
+        // The streaming server upgrades /ws; one socket carries every subscribed stream
+        const url = `ws://${this.options.host}:${this.options.port}/ws`;
         console.log(`[StreamingClient] Connecting to ${url}`);
 
         this.socket = new WebSocket(url);
+        this.socket.binaryType = "arraybuffer";
 
         this.socket.onopen = () => {
           console.log("[StreamingClient] Connected to streaming server");
           this.isConnected = true;
           this.reconnectAttempts = 0;
           this.clearReconnectTimer();
+
+          // Subscriptions do not survive a reconnect; ask for them again
+          this.messageHandlers.forEach((_, streamName) => {
+            this.sendControl("subscribe", streamName, this.lastEventIds.get(streamName));
+          });
           resolve();
         };
 
         this.socket.onmessage = (event) => {
           try {
-            const message: StreamMessage = JSON.parse(event.data);
-            console.log("[StreamingClient] Received message:", message);
-            this.handleMessage(message);
+            if (event.data instanceof ArrayBuffer) {
+              this.handleMessage(decodeMessagePack(event.data) as StreamMessage);
+            } else {
+              this.handleControlReply(JSON.parse(event.data));
+            }
           } catch (error) {
             console.error("[StreamingClient] Error parsing message:", error);
           }
@@ -131,7 +151,35 @@ export class StreamingClient {
     }
   }
 
+  private handleControlReply(reply: StreamControlReply): void {
+    if (reply.type === "error") {
+      console.error(
+        `[StreamingClient] Stream request failed${reply.stream ? ` for ${reply.stream}` : ""}:`,
+        reply.message
+      );
+    } else {
+      console.log(`[StreamingClient] Stream ${reply.stream} ${reply.type}`);
+    }
+  }
+
+  // Subscribe and unsubscribe requests; streams are named ("system.memory")
+  // or given by endpoint ("/stream/memory")
+  private sendControl(
+    type: "subscribe" | "unsubscribe",
+    streamName: string,
+    lastEventId?: number
+  ): void {
+    if (this.socket && this.isConnected) {
+      this.socket.send(
+        JSON.stringify({ type, stream: streamName, last_event_id: lastEventId })
+      );
+    }
+  }
+
   private handleMessage(message: StreamMessage): void {
+    if (message.id !== undefined) {
+      this.lastEventIds.set(message.stream, message.id);
+    }
     const handlers = this.messageHandlers.get(message.stream);
     if (handlers) {
       handlers.forEach((handler) => {
@@ -151,6 +199,7 @@ export class StreamingClient {
   ): () => void {
     if (!this.messageHandlers.has(streamName)) {
       this.messageHandlers.set(streamName, new Set());
+      this.sendControl("subscribe", streamName);
     }
 
     this.messageHandlers.get(streamName)!.add(handler);
@@ -163,6 +212,8 @@ export class StreamingClient {
         handlers.delete(handler);
         if (handlers.size === 0) {
           this.messageHandlers.delete(streamName);
+          this.lastEventIds.delete(streamName);
+          this.sendControl("unsubscribe", streamName);
         }
       }
       console.log(`[StreamingClient] Unsubscribed from stream: ${streamName}`);
@@ -178,21 +229,19 @@ export class StreamingClient {
     }
   }
 
-  // Start a stream
+  // Start a stream without registering a handler
   startStream(streamName: string): void {
     this.send({
-      type: "start_stream",
+      type: "subscribe",
       stream: streamName,
-      timestamp: Date.now(),
     });
   }
 
   // Stop a stream
   stopStream(streamName: string): void {
     this.send({
-      type: "stop_stream",
+      type: "unsubscribe",
       stream: streamName,
-      timestamp: Date.now(),
     });
   }
 
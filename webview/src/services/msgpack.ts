@@ -0,0 +1,119 @@
+// MessagePack decoder for binary stream events from the streaming server
+// (covers every type the server's encoder emits; ext and bin are not used)
+
+class Reader {
+  private offset = 0;
+  private readonly view: DataView;
+  private readonly bytes: Uint8Array;
+  private static readonly text = new TextDecoder();
+
+  constructor(buffer: ArrayBuffer) {
+    this.view = new DataView(buffer);
+    this.bytes = new Uint8Array(buffer);
+  }
+
+  get done(): boolean {
+    return this.offset >= this.bytes.length;
+  }
+
+  value(): unknown {
+    const type = this.uint8();
+
+    if (type < 0x80) return type;
+    if (type >= 0xe0) return type - 0x100;
+    if ((type & 0xf0) === 0x80) return this.map(type & 0x0f);
+    if ((type & 0xf0) === 0x90) return this.array(type & 0x0f);
+    if ((type & 0xe0) === 0xa0) return this.str(type & 0x1f);
+
+    switch (type) {
+      case 0xc0:
+        return null;
+      case 0xc2:
+        return false;
+      case 0xc3:
+        return true;
+      case 0xca:
+        return this.advance(4, (at) => this.view.getFloat32(at));
+      case 0xcb:
+        return this.advance(8, (at) => this.view.getFloat64(at));
+      case 0xcc:
+        return this.uint8();
+      case 0xcd:
+        return this.advance(2, (at) => this.view.getUint16(at));
+      case 0xce:
+        return this.advance(4, (at) => this.view.getUint32(at));
+      case 0xcf:
+        return this.advance(8, (at) => Number(this.view.getBigUint64(at)));
+      case 0xd0:
+        return this.advance(1, (at) => this.view.getInt8(at));
+      case 0xd1:
+        return this.advance(2, (at) => this.view.getInt16(at));
+      case 0xd2:
+        return this.advance(4, (at) => this.view.getInt32(at));
+      case 0xd3:
+        return this.advance(8, (at) => Number(this.view.getBigInt64(at)));
+      case 0xd9:
+        return this.str(this.uint8());
+      case 0xda:
+        return this.str(this.advance(2, (at) => this.view.getUint16(at)));
+      case 0xdb:
+        return this.str(this.advance(4, (at) => this.view.getUint32(at)));
+      case 0xdc:
+        return this.array(this.advance(2, (at) => this.view.getUint16(at)));
+      case 0xdd:
+        return this.array(this.advance(4, (at) => this.view.getUint32(at)));
+      case 0xde:
+        return this.map(this.advance(2, (at) => this.view.getUint16(at)));
+      case 0xdf:
+        return this.map(this.advance(4, (at) => this.view.getUint32(at)));
+      default:
+        throw new Error(`Unsupported MessagePack type 0x${type.toString(16)}`);
+    }
+  }
+
+  private advance<T>(size: number, read: (at: number) => T): T {
+    if (this.offset + size > this.bytes.length) {
+      throw new Error("Truncated MessagePack data");
+    }
+    const value = read(this.offset);
+    this.offset += size;
+    return value;
+  }
+
+  private uint8(): number {
+    return this.advance(1, (at) => this.bytes[at]);
+  }
+
+  private str(length: number): string {
+    return this.advance(length, (at) =>
+      Reader.text.decode(this.bytes.subarray(at, at + length))
+    );
+  }
+
+  private array(count: number): unknown[] {
+    const items: unknown[] = [];
+    for (let i = 0; i < count; i++) {
+      items.push(this.value());
+    }
+    return items;
+  }
+
+  private map(count: number): Record<string, unknown> {
+    const result: Record<string, unknown> = {};
+    for (let i = 0; i < count; i++) {
+      const key = String(this.value());
+      result[key] = this.value();
+    }
+    return result;
+  }
+}
+
+// Decode exactly one value; throws on malformed or trailing data
+export function decodeMessagePack(buffer: ArrayBuffer): unknown {
+  const reader = new Reader(buffer);
+  const value = reader.value();
+  if (!reader.done) {
+    throw new Error("Trailing bytes after MessagePack value");
+  }
+  return value;
+}